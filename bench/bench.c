@@ -0,0 +1,840 @@
+// Throughput benchmarks for the grex primitives and parse loops, on generated corpora.
+//
+//   cc -O2 -o bench bench.c -lpthread && ./bench
+//
+// Add -mavx2 (or -march=native) to measure the AVX2 kernels, or -DGREX_NO_SIMD for the portable ones.
+//
+//   ./bench [--json] [filter]
+//
+// runs the benchmarks whose name or corpus contains the filter, and --json prints the results
+// as a JSON object instead of a table. Build with -DBENCH_REVISION=\"$(git rev-parse --short HEAD)\"
+// to tag the results with the commit they were measured on.
+//
+// The corpora are generated from fixed seeds, so every run and every commit parses the same bytes.
+
+#define _POSIX_C_SOURCE 200809L
+#include "../grex.h"
+#include "../grex.c"
+#include <stdio.h>
+#include <time.h>
+
+#ifndef CORPUS_SIZE
+#define CORPUS_SIZE (256u << 20)
+#endif
+#ifndef DATA_SIZE
+#define DATA_SIZE (64u << 20)
+#endif
+#define LINE_LENGTH 8192
+#ifndef RUNS
+#define RUNS 5
+#endif
+#ifndef BENCH_REVISION
+#define BENCH_REVISION ""
+#endif
+
+#define NUMBER_COUNT (4u << 20)
+
+// Lines of the generated corpora are shorter than this
+#define RECORD_MAX 512
+
+static char* corpus;
+static unsigned corpus_length;
+static char capture_buf[LINE_LENGTH * 2];
+static volatile unsigned long long sink;
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static unsigned next_random(unsigned* seed) {
+  *seed = *seed * 1103515245u + 12345u;
+  return *seed >> 8;
+}
+
+static const char* pick(unsigned* seed, const char* const* words, unsigned count) {
+  return words[next_random(seed) % count];
+}
+
+static const char* const words[] = {
+  "alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel",
+  "india", "juliet", "kilo", "lima", "mike", "november", "oscar", "papa",
+};
+
+// Printable text split into lines of LINE_LENGTH bytes, without any ',' or '"'
+static void make_long_lines(void) {
+  unsigned seed = 12345;
+
+  corpus = malloc(CORPUS_SIZE);
+  corpus_length = CORPUS_SIZE;
+
+  for (unsigned i = 0; i < corpus_length; i++) {
+    seed = seed * 1103515245u + 12345u;
+    corpus[i] = 'a' + (seed >> 16) % 26;
+    if (i % LINE_LENGTH == LINE_LENGTH - 1) {
+      corpus[i] = '\n';
+    }
+  }
+}
+
+// Sections of key = value properties with integers, hex, floats, identifiers and quoted strings,
+// and the occasional comment. Keys repeat, like in real configuration files.
+static void make_ini(void) {
+  static const char* const keys[] = {
+    "host", "port", "timeout", "retries", "user", "path", "ratio", "level",
+    "max_connections", "buffer_size", "log_file", "enabled", "mode", "name", "weight", "color",
+  };
+  unsigned seed = 2024;
+
+  corpus = malloc(DATA_SIZE + RECORD_MAX);
+  corpus_length = 0;
+
+  for (unsigned i = 0; corpus_length < DATA_SIZE; i++) {
+    char* out = corpus + corpus_length;
+    if (i % 32 == 0) {
+      out += sprintf(out, "\n[section_%u]\n", i / 32);
+    }
+    if (next_random(&seed) % 16 == 0) {
+      out += sprintf(out, "# the %s of the %s\n", pick(&seed, keys, 16), pick(&seed, words, 16));
+    }
+
+    out += sprintf(out, "%s_%u = ", pick(&seed, keys, 16), next_random(&seed) % 8);
+    switch (next_random(&seed) % 5) {
+      case 0:
+        out += sprintf(out, "%u\n", next_random(&seed) % 100000);
+        break;
+      case 1:
+        out += sprintf(out, "0x%x\n", next_random(&seed));
+        break;
+      case 2:
+        out += sprintf(out, "%.4f\n", (double)next_random(&seed) / 1000.0);
+        break;
+      case 3:
+        out += sprintf(out, "%s_%s\n", pick(&seed, words, 16), pick(&seed, words, 16));
+        break;
+      default:
+        if (next_random(&seed) % 4 == 0) {
+          out += sprintf(out, "\"%s \\\"%s\\\"\\n%s\"\n", pick(&seed, words, 16), pick(&seed, words, 16), pick(&seed, words, 16));
+        }
+        else {
+          out += sprintf(out, "\"/var/%s/%s %s\"\n", pick(&seed, words, 16), pick(&seed, words, 16), pick(&seed, words, 16));
+        }
+        break;
+    }
+    corpus_length = out - corpus;
+  }
+}
+
+// One quoted string per line, a quarter of them with escapes
+static void make_strings(void) {
+  unsigned seed = 99;
+
+  corpus = malloc(DATA_SIZE + RECORD_MAX);
+  corpus_length = 0;
+
+  while (corpus_length < DATA_SIZE) {
+    char* out = corpus + corpus_length;
+    unsigned count = 1 + next_random(&seed) % 8;
+    int escapes = next_random(&seed) % 4 == 0;
+
+    *out++ = '"';
+    for (unsigned w = 0; w < count; w++) {
+      out += sprintf(out, w ? (escapes && w % 3 == 0 ? "\\t%s" : " %s") : "%s", pick(&seed, words, 16));
+    }
+    if (escapes) {
+      out += sprintf(out, " \\\"%s\\\"", pick(&seed, words, 16));
+    }
+    *out++ = '"';
+    *out++ = '\n';
+    corpus_length = out - corpus;
+  }
+}
+
+// Rows of six fields: ids, integers, floats, words, and quoted text with commas,
+// doubled quotes and the occasional newline
+static void make_csv(void) {
+  unsigned seed = 31337;
+
+  corpus = malloc(DATA_SIZE + RECORD_MAX);
+  corpus_length = 0;
+
+  for (unsigned i = 0; corpus_length < DATA_SIZE; i++) {
+    char* out = corpus + corpus_length;
+    out += sprintf(out, "%u,%d,%.3f,%s,", i, (int)(next_random(&seed) % 20000) - 10000, (double)next_random(&seed) / 4096.0, pick(&seed, words, 16));
+    switch (next_random(&seed) % 4) {
+      case 0:
+        out += sprintf(out, "\"%s, %s and %s\"", pick(&seed, words, 16), pick(&seed, words, 16), pick(&seed, words, 16));
+        break;
+      case 1:
+        out += sprintf(out, "\"the \"\"%s\"\" %s\"", pick(&seed, words, 16), pick(&seed, words, 16));
+        break;
+      case 2:
+        out += sprintf(out, "\"%s\n%s\"", pick(&seed, words, 16), pick(&seed, words, 16));
+        break;
+      default:
+        out += sprintf(out, "%s %s", pick(&seed, words, 16), pick(&seed, words, 16));
+        break;
+    }
+    out += sprintf(out, ",%s\n", next_random(&seed) % 2 ? "" : pick(&seed, words, 16));
+    corpus_length = out - corpus;
+  }
+}
+
+// Syslog-style lines: timestamp, host, program with an optional pid, and a free-form message
+static void make_syslog(void) {
+  static const char* const months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+  static const char* const programs[] = { "sshd", "cron", "kernel", "systemd", "nginx", "postfix/smtpd", "dhclient", "sudo" };
+  unsigned seed = 514;
+
+  corpus = malloc(DATA_SIZE + RECORD_MAX);
+  corpus_length = 0;
+
+  while (corpus_length < DATA_SIZE) {
+    char* out = corpus + corpus_length;
+    const char* program = pick(&seed, programs, 8);
+
+    out += sprintf(out, "%s %u %02u:%02u:%02u host-%u %s", pick(&seed, months, 12), 1 + next_random(&seed) % 28,
+                   next_random(&seed) % 24, next_random(&seed) % 60, next_random(&seed) % 60, next_random(&seed) % 64, program);
+    if (strcmp(program, "kernel")) {
+      out += sprintf(out, "[%u]", next_random(&seed) % 65536);
+    }
+
+    switch (next_random(&seed) % 4) {
+      case 0:
+        out += sprintf(out, ": Accepted publickey for %s from 10.%u.%u.%u port %u ssh2\n", pick(&seed, words, 16),
+                       next_random(&seed) % 256, next_random(&seed) % 256, next_random(&seed) % 256, next_random(&seed) % 65536);
+        break;
+      case 1:
+        out += sprintf(out, ": (%s) CMD (run-parts /etc/cron.%s)\n", pick(&seed, words, 16), pick(&seed, words, 16));
+        break;
+      case 2:
+        out += sprintf(out, ": [%u.%06u] %s: link is up\n", next_random(&seed) % 100000, next_random(&seed) % 1000000, pick(&seed, words, 16));
+        break;
+      default:
+        out += sprintf(out, ": %s %s %s request completed in %u ms\n", pick(&seed, words, 16), pick(&seed, words, 16),
+                       pick(&seed, words, 16), next_random(&seed) % 5000);
+        break;
+    }
+    corpus_length = out - corpus;
+  }
+}
+
+// One integer per line, with 1 to 18 digits and an occasional sign
+static void make_integers(void) {
+  unsigned seed = 777;
+
+  corpus = malloc(NUMBER_COUNT * 21 + 1);
+  corpus_length = 0;
+
+  for (unsigned i = 0; i < NUMBER_COUNT; i++) {
+    unsigned digits = 1 + next_random(&seed) % 18;
+    if (next_random(&seed) % 8 == 0) {
+      corpus[corpus_length++] = '-';
+    }
+    corpus[corpus_length++] = '1' + next_random(&seed) % 9;
+    for (unsigned d = 1; d < digits; d++) {
+      corpus[corpus_length++] = '0' + next_random(&seed) % 10;
+    }
+    corpus[corpus_length++] = '\n';
+  }
+  corpus[corpus_length] = 0;
+}
+
+// One float per line, mixing metric samples with few decimals and full precision doubles
+static void make_floats(void) {
+  unsigned seed = 4242;
+
+  corpus = malloc(NUMBER_COUNT * 32 + 1);
+  corpus_length = 0;
+
+  for (unsigned i = 0; i < NUMBER_COUNT; i++) {
+    double magnitude = (double)next_random(&seed) / (1 << 24);
+    switch (i % 4) {
+      case 0:
+      case 1:
+        corpus_length += sprintf(corpus + corpus_length, "%.4f\n", magnitude * 100000.0);
+        break;
+      case 2:
+        corpus_length += sprintf(corpus + corpus_length, "%.3e\n", magnitude * 1e-6);
+        break;
+      default:
+        corpus_length += sprintf(corpus + corpus_length, "%.17g\n", magnitude * 1234.5);
+        break;
+    }
+  }
+}
+
+// Each benchmark parses the whole corpus and returns the number of primitive calls or records
+
+static unsigned long long bench_memchr(void) {
+  const char* s = corpus;
+  const char* end = corpus + corpus_length;
+  unsigned long long lines = 0;
+
+  while ((s = memchr(s, '\n', end - s)) != NULL) {
+    s++;
+    lines++;
+  }
+  sink += lines;
+  return lines;
+}
+
+static unsigned long long bench_memcpy(void) {
+  unsigned long long lines = 0;
+
+  for (unsigned i = 0; i + LINE_LENGTH <= corpus_length; i += LINE_LENGTH) {
+    memcpy(capture_buf, corpus + i, LINE_LENGTH);
+    lines++;
+  }
+  sink += capture_buf[0];
+  return lines;
+}
+
+static unsigned long long bench_until(void) {
+  grex_parser_t p = {0};
+  grex_parser_init(&p, corpus, corpus_length);
+
+  unsigned long long lines = 0;
+  while (grex_until(&p, '\n') == GREX_OK) {
+    grex_char(&p, '\n');
+    lines++;
+  }
+  sink += lines;
+  return lines;
+}
+
+static unsigned long long bench_capture_until(void) {
+  grex_parser_t p = {0};
+  grex_parser_init(&p, corpus, corpus_length);
+
+  unsigned long long lines = 0;
+  while (grex_capture_until(&p, '\n', capture_buf, sizeof(capture_buf)) == GREX_OK) {
+    grex_char(&p, '\n');
+    lines++;
+  }
+  sink += lines;
+  return lines;
+}
+
+static unsigned long long bench_until_any(void) {
+  grex_parser_t p = {0};
+  grex_parser_init(&p, corpus, corpus_length);
+
+  unsigned long long fields = 0;
+  while (grex_until_any(&p, ",\n\"") == GREX_OK) {
+    grex_char(&p, cur(&p));
+    fields++;
+  }
+  sink += fields;
+  return fields;
+}
+
+static unsigned long long bench_until_sequence(void) {
+  grex_parser_t p = {0};
+  grex_parser_init(&p, corpus, corpus_length);
+
+  // The marker is not in the corpus, so this scans all of it
+  sink += grex_until_sequence(&p, "[second_section]");
+  return 1;
+}
+
+static unsigned long long bench_until_sequence_reverse(void) {
+  grex_parser_t p = {0};
+  grex_parser_init(&p, corpus, corpus_length);
+  grex_parser_end(&p);
+
+  sink += grex_until_sequence_reverse(&p, "[second_section]");
+  return 1;
+}
+
+// Jumps from one match to the next, a few hundred bytes apart
+static unsigned long long bench_until_sequence_hits(void) {
+  grex_parser_t p = {0};
+  grex_parser_init(&p, corpus, corpus_length);
+
+  unsigned long long calls = 1;
+  while (grex_until_sequence(&p, "sshd[") == GREX_OK) {
+    calls++;
+  }
+  sink += calls;
+  return calls;
+}
+
+// The field scanner of a CSV reader without quotes: skip to a delimiter, then match it
+static unsigned long long bench_set(void) {
+  grex_parser_t p = {0};
+  grex_parser_init(&p, corpus, corpus_length);
+
+  unsigned long long calls = 0;
+  for (;;) {
+    grex_until_any(&p, ",\n\"");
+    if (grex_set(&p, ",\n\"") != GREX_OK) {
+      break;
+    }
+    calls++;
+  }
+  sink += calls;
+  return calls;
+}
+
+static unsigned long long bench_string(void) {
+  grex_parser_t p = {0};
+  grex_parser_init(&p, corpus, corpus_length);
+
+  unsigned long long strings = 0;
+  while (grex_string(&p, capture_buf, sizeof(capture_buf)) == GREX_OK && grex_char(&p, '\n') == GREX_OK) {
+    strings++;
+  }
+  sink += strings;
+  return strings;
+}
+
+static unsigned long long bench_string_span(void) {
+  grex_parser_t p = {0};
+  grex_parser_init(&p, corpus, corpus_length);
+
+  grex_span_t span;
+  unsigned long long strings = 0;
+  while (grex_string_span(&p, &span) == GREX_OK && grex_char(&p, '\n') == GREX_OK) {
+    strings++;
+  }
+  sink += strings;
+  return strings;
+}
+
+static unsigned long long bench_string_decode(void) {
+  grex_parser_t p = {0};
+  grex_parser_init(&p, corpus, corpus_length);
+
+  grex_span_t span;
+  unsigned long long strings = 0;
+  while (grex_string_decode(&p, capture_buf, sizeof(capture_buf), &span) == GREX_OK && grex_char(&p, '\n') == GREX_OK) {
+    strings++;
+  }
+  sink += strings;
+  return strings;
+}
+
+static unsigned long long bench_strtoll(void) {
+  const char* s = corpus;
+  char* end;
+  long long total = 0;
+
+  for (unsigned i = 0; i < NUMBER_COUNT; i++) {
+    total += strtoll(s, &end, 10);
+    s = end + 1;
+  }
+  sink += total;
+  return NUMBER_COUNT;
+}
+
+static unsigned long long bench_integer(void) {
+  grex_parser_t p = {0};
+  grex_parser_init(&p, corpus, corpus_length);
+
+  unsigned long long calls = 0;
+  long long value, total = 0;
+  while (grex_integer(&p, 10, &value) == GREX_OK) {
+    total += value;
+    calls++;
+    if (grex_whitespace(&p) != GREX_OK) {
+      break;
+    }
+  }
+  sink += total;
+  return calls;
+}
+
+static unsigned long long bench_strtod(void) {
+  const char* s = corpus;
+  char* end;
+  double total = 0;
+
+  for (unsigned i = 0; i < NUMBER_COUNT; i++) {
+    total += strtod(s, &end);
+    s = end + 1;
+  }
+  sink += (unsigned long long)total;
+  return NUMBER_COUNT;
+}
+
+static unsigned long long bench_float(void) {
+  grex_parser_t p = {0};
+  grex_parser_init(&p, corpus, corpus_length);
+
+  unsigned long long calls = 0;
+  double value, total = 0;
+  while (grex_float(&p, &value) == GREX_OK) {
+    total += value;
+    calls++;
+    if (grex_whitespace(&p) != GREX_OK) {
+      break;
+    }
+  }
+  sink += (unsigned long long)total;
+  return calls;
+}
+
+// Skips the section headers and comments of an INI file, returns GREX_EOF at the end
+static grex_result_t ini_skip(grex_parser_t* p) {
+  for (;;) {
+    if (grex_whitespace(p) == GREX_EOF) {
+      return GREX_EOF;
+    }
+    if (grex_char(p, '#') == GREX_OK) {
+      grex_until(p, '\n');
+    }
+    else if (grex_char(p, '[') == GREX_OK) {
+      grex_until(p, ']');
+      grex_char(p, ']');
+    }
+    else {
+      return GREX_OK;
+    }
+  }
+}
+
+static grex_result_t ini_equals(grex_parser_t* p) {
+  grex_whitespace_no_line(p);
+  if (grex_char(p, '=') != GREX_OK) {
+    return GREX_NO_MATCH;
+  }
+  grex_whitespace_no_line(p);
+  return GREX_OK;
+}
+
+// The properties copied into buffers, like the README example
+static unsigned long long ini_buffers(grex_parser_t* p) {
+  static char key[256];
+  static char value[256];
+  long long number;
+  double real;
+  unsigned long long properties = 0;
+
+  while (ini_skip(p) == GREX_OK) {
+    if (grex_identifier(p, key, sizeof(key)) || ini_equals(p)) break;
+    if (grex_integer(p, 0, &number) && grex_float(p, &real) && grex_identifier(p, value, sizeof(value)) &&
+        grex_string(p, value, sizeof(value))) break;
+    properties++;
+  }
+  return properties;
+}
+
+// The same properties as spans into the input
+static unsigned long long ini_spans(grex_parser_t* p) {
+  grex_span_t key, value;
+  long long number;
+  double real;
+  unsigned long long properties = 0;
+
+  while (ini_skip(p) == GREX_OK) {
+    if (grex_identifier_span(p, &key) || ini_equals(p)) break;
+    if (grex_integer(p, 0, &number) && grex_float(p, &real) && grex_identifier_span(p, &value) &&
+        grex_string_span(p, &value)) break;
+    properties++;
+  }
+  return properties;
+}
+
+// The keys interned and the string values decoded into an arena reset per property
+static unsigned long long ini_intern(grex_parser_t* p) {
+  grex_span_t key, value;
+  unsigned id;
+  long long number;
+  double real;
+  unsigned long long properties = 0;
+
+  while (ini_skip(p) == GREX_OK) {
+    grex_arena_reset(p->arena);
+    if (grex_identifier_intern(p, &id, &key) || ini_equals(p)) break;
+    if (grex_integer(p, 0, &number) && grex_float(p, &real) && grex_identifier_span(p, &value) &&
+        grex_string_alloc(p, &value)) break;
+    properties++;
+  }
+  return properties;
+}
+
+static unsigned long long bench_ini_buffers(void) {
+  grex_parser_t p = {0};
+  grex_parser_init(&p, corpus, corpus_length);
+
+  unsigned long long properties = ini_buffers(&p);
+  sink += properties;
+  return properties;
+}
+
+static unsigned long long bench_ini_spans(void) {
+  grex_parser_t p = {0};
+  grex_parser_init(&p, corpus, corpus_length);
+
+  unsigned long long properties = ini_spans(&p);
+  sink += properties;
+  return properties;
+}
+
+static unsigned long long bench_ini_structural(void) {
+  grex_parser_t p = {0};
+  grex_parser_init(&p, corpus, corpus_length);
+  grex_parser_set_structural(&p, GREX_STRUCTURAL_DEFAULT, 0);
+
+  unsigned long long properties = ini_spans(&p);
+  grex_parser_destroy(&p);
+  sink += properties;
+  return properties;
+}
+
+static unsigned long long bench_ini_intern(void) {
+  grex_parser_t p = {0};
+  grex_intern_t keys;
+  grex_arena_t arena;
+  grex_intern_init(&keys, 256);
+  grex_arena_init(&arena, 0);
+  grex_parser_init(&p, corpus, corpus_length);
+  grex_parser_set_intern(&p, &keys);
+  grex_parser_set_arena(&p, &arena);
+
+  unsigned long long properties = ini_intern(&p);
+  grex_intern_destroy(&keys);
+  grex_arena_destroy(&arena);
+  sink += properties;
+  return properties;
+}
+
+static unsigned long long bench_ini_stream(void) {
+  grex_parser_t p = {0};
+  FILE* fh = fmemopen(corpus, corpus_length, "rb");
+  if (!fh || grex_parser_init_stream(&p, grex_read_stdio, fh, 64 * 1024)) {
+    return 1;
+  }
+
+  unsigned long long properties = ini_spans(&p);
+  grex_parser_destroy(&p);
+  fclose(fh);
+  sink += properties;
+  return properties;
+}
+
+// Counts the records, a quoted field ends at a quote that isn't doubled
+static unsigned long long csv_records(grex_parser_t* p) {
+  unsigned long long records = 0;
+
+  for (;;) {
+    if (grex_char(p, '"') == GREX_OK) {
+      do {
+        grex_until(p, '"');
+        if (grex_char(p, '"') != GREX_OK) {
+          return records;
+        }
+      } while (grex_char(p, '"') == GREX_OK);
+    }
+    else {
+      grex_until_any(p, ",\n");
+    }
+
+    if (grex_char(p, ',') == GREX_OK) {
+      continue;
+    }
+    unsigned long long end = grex_parser_tell(p);
+    if (grex_char(p, '\n') != GREX_OK) {
+      return records;
+    }
+    records++;
+
+    // Matching the last character leaves the head on it
+    if (grex_parser_tell(p) == end) {
+      return records;
+    }
+  }
+}
+
+static unsigned long long bench_csv(void) {
+  grex_parser_t p = {0};
+  grex_parser_init(&p, corpus, corpus_length);
+
+  unsigned long long records = csv_records(&p);
+  sink += records;
+  return records;
+}
+
+static grex_result_t parse_csv_chunk(grex_parser_t* p, grex_chunk_t* chunk, void* arg) {
+  (void)arg;
+  chunk->data = (void*)(size_t)csv_records(p);
+  return GREX_OK;
+}
+
+static void count_csv_chunk(const grex_chunk_t* chunk, void* arg) {
+  *(unsigned long long*)arg += (size_t)chunk->data;
+}
+
+static unsigned long long bench_csv_parallel(void) {
+  grex_parallel_t par;
+  unsigned long long records = 0;
+  grex_parallel_init(&par, parse_csv_chunk, count_csv_chunk, &records);
+  grex_parse_parallel(&par, corpus, corpus_length);
+  sink += records;
+  return records;
+}
+
+static unsigned long long bench_syslog(void) {
+  grex_parser_t p = {0};
+  grex_parser_init(&p, corpus, corpus_length);
+
+  grex_span_t month, host, program, message;
+  long long day, hour, minute, second, pid;
+  unsigned long long lines = 0;
+
+  while (grex_identifier_span(&p, &month) == GREX_OK) {
+    grex_whitespace_no_line(&p);
+    if (grex_integer(&p, 10, &day)) break;
+    grex_whitespace_no_line(&p);
+    if (grex_integer(&p, 10, &hour) || grex_char(&p, ':') || grex_integer(&p, 10, &minute) || grex_char(&p, ':') ||
+        grex_integer(&p, 10, &second)) break;
+    grex_whitespace_no_line(&p);
+    if (grex_capture_until_span(&p, ' ', &host)) break;
+    grex_whitespace_no_line(&p);
+    if (grex_capture_until_any_span(&p, "[:", &program)) break;
+    if (grex_char(&p, '[') == GREX_OK && (grex_integer(&p, 10, &pid) || grex_char(&p, ']'))) break;
+    if (grex_char(&p, ':')) break;
+    grex_whitespace_no_line(&p);
+    if (grex_capture_until_span(&p, '\n', &message) || grex_char(&p, '\n')) break;
+    lines++;
+  }
+  sink += lines;
+  return lines;
+}
+
+typedef struct corpus_spec {
+  const char* name;
+  void (*make)(void);
+} corpus_spec_t;
+
+typedef struct bench_spec {
+  const char* name;
+  const char* corpus;
+  unsigned long long (*fn)(void);
+} bench_spec_t;
+
+static const corpus_spec_t corpora[] = {
+  { "lines", make_long_lines },
+  { "strings", make_strings },
+  { "integers", make_integers },
+  { "floats", make_floats },
+  { "ini", make_ini },
+  { "csv", make_csv },
+  { "syslog", make_syslog },
+};
+
+static const bench_spec_t benches[] = {
+  { "memchr (baseline)", "lines", bench_memchr },
+  { "memcpy (baseline)", "lines", bench_memcpy },
+  { "grex_until", "lines", bench_until },
+  { "grex_capture_until", "lines", bench_capture_until },
+  { "grex_until_any", "lines", bench_until_any },
+  { "grex_until_sequence", "lines", bench_until_sequence },
+  { "grex_until_sequence_reverse", "lines", bench_until_sequence_reverse },
+  { "grex_string", "strings", bench_string },
+  { "grex_string_span", "strings", bench_string_span },
+  { "grex_string_decode", "strings", bench_string_decode },
+  { "strtoll (baseline)", "integers", bench_strtoll },
+  { "grex_integer", "integers", bench_integer },
+  { "strtod (baseline)", "floats", bench_strtod },
+  { "grex_float", "floats", bench_float },
+  { "ini (buffers)", "ini", bench_ini_buffers },
+  { "ini (spans)", "ini", bench_ini_spans },
+  { "ini (structural index)", "ini", bench_ini_structural },
+  { "ini (intern, arena)", "ini", bench_ini_intern },
+  { "ini (stream)", "ini", bench_ini_stream },
+  { "grex_set", "csv", bench_set },
+  { "csv records", "csv", bench_csv },
+  { "csv records (parallel)", "csv", bench_csv_parallel },
+  { "grex_until_sequence (hits)", "syslog", bench_until_sequence_hits },
+  { "syslog records", "syslog", bench_syslog },
+};
+
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+
+static const char* filter;
+static int json;
+static unsigned results;
+
+static int selected(const bench_spec_t* b) {
+  return !filter || strstr(b->name, filter) || strstr(b->corpus, filter);
+}
+
+static void run(const bench_spec_t* b) {
+  double best = 1e30;
+  unsigned long long calls = 0;
+
+  for (int i = 0; i < RUNS; i++) {
+    double start = now();
+    calls = b->fn();
+    double elapsed = now() - start;
+    if (elapsed < best) {
+      best = elapsed;
+    }
+  }
+
+  double mbs = corpus_length / best / (1 << 20);
+  double ns = calls ? best * 1e9 / calls : 0;
+
+  if (json) {
+    printf("%s\n    {\"name\": \"%s\", \"corpus\": \"%s\", \"bytes\": %u, \"calls\": %llu, \"seconds\": %.6f, "
+           "\"mb_per_s\": %.1f, \"ns_per_call\": %.2f}",
+           results ? "," : "", b->name, b->corpus, corpus_length, calls, best, mbs, ns);
+  }
+  else {
+    printf("%-28s %-9s %10.1f MB/s %10.2f ns/call\n", b->name, b->corpus, mbs, ns);
+  }
+  fflush(stdout);
+  results++;
+}
+
+int main(int argc, const char* argv[]) {
+#if defined(GREX_AVX2)
+  const char* kernels = "avx2";
+#elif defined(GREX_SSE2)
+  const char* kernels = "sse2";
+#else
+  const char* kernels = "portable";
+#endif
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--json")) {
+      json = 1;
+    }
+    else {
+      filter = argv[i];
+    }
+  }
+
+  if (json) {
+    printf("{\n  \"revision\": \"%s\",\n  \"kernels\": \"%s\",\n  \"runs\": %d,\n  \"results\": [", BENCH_REVISION, kernels, RUNS);
+  }
+  else {
+    printf("kernels: %s\n", kernels);
+  }
+
+  for (unsigned c = 0; c < COUNT(corpora); c++) {
+    unsigned b = 0;
+    while (b < COUNT(benches) && (strcmp(benches[b].corpus, corpora[c].name) || !selected(&benches[b]))) {
+      b++;
+    }
+    if (b == COUNT(benches)) {
+      continue;
+    }
+
+    corpora[c].make();
+    for (; b < COUNT(benches); b++) {
+      if (!strcmp(benches[b].corpus, corpora[c].name) && selected(&benches[b])) {
+        run(&benches[b]);
+      }
+    }
+    free(corpus);
+  }
+
+  if (json) {
+    printf("\n  ]\n}\n");
+  }
+  return 0;
+}
@@ -28,15 +28,72 @@ SOFTWARE.
 #include <stdlib.h>
 #include <stdio.h>
 #include <errno.h>
+#include <float.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#define GREX_MMAP_WIN32
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define GREX_MMAP_POSIX
+#endif
+
+#if !defined(GREX_NO_THREADS)
+#if defined(_WIN32)
+#define GREX_THREADS_WIN32
+#elif defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#define GREX_THREADS_POSIX
+#endif
+#endif
+
+#if !defined(GREX_NO_SIMD)
+#if defined(__AVX2__)
+#define GREX_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GREX_SSE2
+#endif
+#endif
+
+#if defined(GREX_AVX2)
+#include <immintrin.h>
+#elif defined(GREX_SSE2)
+#include <emmintrin.h>
+#endif
+
+#if defined(GREX_PROFILE)
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define GREX_PROFILE_RDTSC
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define GREX_PROFILE_RDTSC
+#else
+#include <time.h>
+#endif
+#include <stdarg.h>
+
+// The primitives are defined under another name, and wrapped by the counting functions at the end of the file
+#define GREX_IMPL(name) name##_unprofiled
+#else
+#define GREX_IMPL(name) name
+#endif
 
 #define GREX_EOF_CHECK(p) do { \
-  if (p->parsing_offset >= p->input_length) { \
+  if (p->parsing_offset >= p->input_length && !refill(p, NULL)) { \
     return GREX_EOF; \
   } \
 } while (0)
 
+// The head is only past the end after stop_at_eof wrapped around on an empty input
 #define GREX_REVERSE_EOF_CHECK(p) do { \
-  if ((int)(p->parsing_offset) < 0) { \
+  if (p->parsing_offset > p->input_length) { \
     return GREX_EOF; \
   } \
 } while (0)
@@ -45,431 +102,6451 @@ SOFTWARE.
 
 #define REVERSE_NEXT(p) if (!reverse_next(p)) { return GREX_EOF; }
 
+static size_t refill(grex_parser_t* p, size_t* offset);
+static void line_index_discard(grex_parser_t* p, size_t n);
+static void structural_discard(grex_parser_t* p, size_t n);
+static void line_index_free(grex_parser_t* p);
+
 static inline int cur(grex_parser_t* p) {
   return p->input[p->parsing_offset];
 }
 
 static inline int next(grex_parser_t* p) {
-  if (p->parsing_offset+1 >= p->input_length) {
+  if (p->parsing_offset+1 >= p->input_length && !refill(p, NULL)) {
     return 0;
   }
   return p->input[++p->parsing_offset];
 }
 
 static inline int reverse_next(grex_parser_t* p) {
-  if ((int)p->parsing_offset-1 < 0) {
+  if (p->parsing_offset == 0 || p->parsing_offset > p->input_length) {
     return 0;
   }
   return p->input[--p->parsing_offset];
 }
 
-static void report_error(grex_parser_t* p, const char* where) {
-  if (p->error_callback) {
-    p->error_callback(p, where, p->error_callback_arg);
-  }
-  else {
-    //fprintf(stderr, "grex error: %s - %s\n", where, &p->input[p->parsing_offset]);
+static inline int ctz32(unsigned x) {
+#if defined(__GNUC__)
+  return __builtin_ctz(x);
+#else
+  int n = 0;
+  while (!(x & 1)) {
+    x >>= 1;
+    n++;
   }
+  return n;
+#endif
 }
 
-void grex_parser_init(grex_parser_t* p, const char* input, unsigned length) {
-  p->input = input;
-  p->input_end = input + length;
-  p->input_length = length;
-  p->parsing_offset = 0;
+static inline int clz32(unsigned x) {
+#if defined(__GNUC__)
+  return __builtin_clz(x);
+#else
+  int n = 0;
+  while (!(x & 0x80000000u)) {
+    x <<= 1;
+    n++;
+  }
+  return n;
+#endif
 }
 
-void grex_parser_destroy(grex_parser_t* p) {
+static inline int clz64(unsigned long long x) {
+#if defined(__GNUC__)
+  return __builtin_clzll(x);
+#else
+  int n = 0;
+  while (!(x & 0x8000000000000000ULL)) {
+    x <<= 1;
+    n++;
+  }
+  return n;
+#endif
 }
 
-void grex_parser_reset(grex_parser_t* p) {
-  p->parsing_offset = 0;
+static inline int ctz64(unsigned long long x) {
+#if defined(__GNUC__)
+  return __builtin_ctzll(x);
+#else
+  int n = 0;
+  while (!(x & 1)) {
+    x >>= 1;
+    n++;
+  }
+  return n;
+#endif
 }
 
-void grex_parser_end(grex_parser_t* p) {
-  p->parsing_offset = p->input_length;
+static inline int popcount64(unsigned long long x) {
+#if defined(__GNUC__)
+  return __builtin_popcountll(x);
+#else
+  int n = 0;
+  for (; x; x &= x - 1) {
+    n++;
+  }
+  return n;
+#endif
 }
 
-void grex_parser_set_error_callback(grex_parser_t* p, grex_error_callback_t cb, void* arg) {
-  p->error_callback = cb;
-  p->error_callback_arg = arg;
+// Scanners that run into the end of the input leave the head on the last character, like next() does
+static inline grex_result_t stop_at_eof(grex_parser_t* p) {
+  p->parsing_offset = p->input_length - 1;
+  return GREX_EOF;
 }
 
-grex_result_t grex_whitespace(grex_parser_t* p) {
-  return grex_set(p, " \t\n\r\f");
+static const char* const primitive_names[GREX_PRIMITIVE_COUNT] = {
+  "grex_whitespace",
+  "grex_whitespace_no_line",
+  "grex_char",
+  "grex_set",
+  "grex_range",
+  "grex_sequence",
+  "grex_sequence_reverse",
+  "grex_sequence_needle",
+  "grex_while",
+  "grex_until",
+  "grex_until_any",
+  "grex_while_class",
+  "grex_until_class",
+  "grex_while_sequence",
+  "grex_while_sequence_reverse",
+  "grex_while_needle",
+  "grex_while_needle_reverse",
+  "grex_integer",
+  "grex_uinteger",
+  "grex_float",
+  "grex_identifier",
+  "grex_string",
+  "grex_range_while",
+  "grex_char_class",
+  "grex_keyword",
+};
+
+static void record_error(grex_parser_t* p, grex_primitive_t where) {
+  if (p->error_mode == GREX_ERRORS_DEFERRED) {
+    unsigned long long offset = grex_parser_tell(p);
+    if (offset > p->error_offset || !p->error_expected) {
+      p->error_offset = offset;
+      p->error_expected = 0;
+    }
+    if (offset == p->error_offset) {
+      p->error_expected |= 1ULL << where;
+    }
+  }
+  else {
+    p->error_callback(p, primitive_names[where], p->error_callback_arg);
+  }
 }
 
-grex_result_t grex_whitespace_no_line(grex_parser_t* p) {
-  return grex_set(p, " \t\f");
+// Misses are expected while trying alternatives, so without a callback or the deferred mode they cost a single test
+// Misses are only recorded, and lines only counted through refills, when something reports them
+static inline int reports_errors(const grex_parser_t* p) {
+  return p->error_callback || p->error_mode == GREX_ERRORS_DEFERRED;
 }
 
-grex_result_t grex_char(grex_parser_t* p, int c) {
-  GREX_EOF_CHECK(p);
-  if (cur(p) == c) {
-    next(p);
-    return GREX_OK;
+static inline void report_error(grex_parser_t* p, grex_primitive_t where) {
+  if (reports_errors(p)) {
+    record_error(p, where);
   }
-  report_error(p, "grex_char");
-  return GREX_NO_MATCH;
 }
 
-grex_result_t grex_set(grex_parser_t* p, const char* set) {
-  GREX_EOF_CHECK(p);
+void grex_parser_init(grex_parser_t* p, const char* input, size_t length) {
+  p->input = input;
+  p->input_end = input + length;
+  p->input_length = length;
+  p->parsing_offset = 0;
+  p->read_callback = NULL;
+  p->read_callback_arg = NULL;
+  p->window = NULL;
+  p->window_size = 0;
+  p->stream_offset = 0;
+  p->stream_hold = ~0ULL;
+  p->file_data = NULL;
+  p->file_size = 0;
+  memset(&p->line_index, 0, sizeof(p->line_index));
+  p->structural = NULL;
+  p->arena = NULL;
+  p->intern = NULL;
+#if defined(GREX_PROFILE)
+  memset(&p->profile, 0, sizeof(p->profile));
+#endif
+}
 
-  int n = 0;
+grex_result_t grex_parser_open_file(grex_parser_t* p, const char* path) {
+  void* data = NULL;
+  size_t size = 0;
 
-  while (strchr(set, cur(p))) {
-    NEXT(p);
-    n++;
+#if defined(GREX_MMAP_POSIX)
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return GREX_IO_ERR;
   }
 
-  if (n) {
-    return GREX_OK;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (unsigned long long)st.st_size > (size_t)-1) {
+    close(fd);
+    return GREX_IO_ERR;
   }
 
-  report_error(p, "grex_set");
-  return GREX_NO_MATCH;
-}
-
-grex_result_t grex_range(grex_parser_t* p, const char* range) {
-  // TODO: handle multiple ranges
-  if (strlen(range) < 2) return GREX_NO_MATCH;
-
-  GREX_EOF_CHECK(p);
+  size = (size_t)st.st_size;
+  if (size > 0) {
+    data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
 
-  int c = cur(p);
-  if (c >= range[0] && c <= range[1]) {
-    next(p);
-    return GREX_OK;
+  if (data == MAP_FAILED) {
+    return GREX_IO_ERR;
   }
 
-  report_error(p, "grex_range");
-  return GREX_NO_MATCH;
-}
+  // The advice macros are only declared when the build exposes POSIX.1-2001
+  if (size > 0) {
+#if defined(POSIX_MADV_SEQUENTIAL)
+    posix_madvise(data, size, POSIX_MADV_SEQUENTIAL);
+    posix_madvise(data, size, POSIX_MADV_WILLNEED);
+#endif
+#if defined(MADV_HUGEPAGE)
+    madvise(data, size, MADV_HUGEPAGE);
+#endif
+  }
+#elif defined(GREX_MMAP_WIN32)
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    return GREX_IO_ERR;
+  }
 
-grex_result_t grex_sequence(grex_parser_t* p, const char* seq) {
-  GREX_EOF_CHECK(p);
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size) || (unsigned long long)file_size.QuadPart > (size_t)-1) {
+    CloseHandle(file);
+    return GREX_IO_ERR;
+  }
 
-  unsigned n = strlen(seq);
-  if (p->parsing_offset+n > p->input_length) {
-    report_error(p, "grex_sequence");
-    return GREX_NO_MATCH;
+  size = (size_t)file_size.QuadPart;
+  if (size > 0) {
+    // The view keeps the file mapped after both handles are closed
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping) {
+      data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      CloseHandle(mapping);
+    }
+    if (!data) {
+      CloseHandle(file);
+      return GREX_IO_ERR;
+    }
+  }
+  CloseHandle(file);
+#else
+  FILE* fh = fopen(path, "rb");
+  if (!fh) {
+    return GREX_IO_ERR;
   }
 
-  if (memcmp(&p->input[p->parsing_offset], seq, n)) {
-    report_error(p, "grex_sequence");
-    return GREX_NO_MATCH;
+  size_t capacity = 0;
+  for (;;) {
+    if (size == capacity) {
+      capacity = capacity ? capacity * 2 : 64 * 1024;
+      void* grown = realloc(data, capacity);
+      if (!grown) {
+        free(data);
+        fclose(fh);
+        return GREX_ALLOC_ERR;
+      }
+      data = grown;
+    }
+
+    size_t n = fread((char*)data + size, 1, capacity - size, fh);
+    if (n == 0) {
+      break;
+    }
+    size += n;
   }
+  fclose(fh);
+#endif
 
-  p->parsing_offset += n;
+  grex_parser_init(p, size > 0 ? (const char*)data : "", size);
+  p->file_data = size > 0 ? data : NULL;
+  p->file_size = size;
   return GREX_OK;
 }
 
-grex_result_t grex_sequence_reverse(grex_parser_t* p, const char* seq) {
-  GREX_REVERSE_EOF_CHECK(p);
+void grex_parser_close_file(grex_parser_t* p) {
+  if (p->file_data) {
+#if defined(GREX_MMAP_POSIX)
+    munmap(p->file_data, p->file_size);
+#elif defined(GREX_MMAP_WIN32)
+    UnmapViewOfFile(p->file_data);
+#else
+    free(p->file_data);
+#endif
+  }
 
-  int n = strlen(seq);
-  if (p->parsing_offset - n < 0) {
-    report_error(p, "grex_sequence_reverse");
-    return GREX_NO_MATCH;
+  line_index_free(p);
+  grex_parser_set_structural(p, NULL, 0);
+  grex_parser_init(p, "", 0);
+}
+
+grex_result_t grex_parser_init_stream(grex_parser_t* p, grex_read_callback_t cb, void* arg, size_t window_size) {
+  if (window_size < 64) {
+    window_size = 64;
   }
 
-  if (memcmp(&p->input[p->parsing_offset - n], seq, n)) {
-    report_error(p, "grex_sequence_reverse");
-    return GREX_NO_MATCH;
+  char* window = malloc(window_size);
+  if (!window) {
+    return GREX_ALLOC_ERR;
   }
 
-  p->parsing_offset -= n;
+  grex_parser_init(p, "", 0);
+  p->input = window;
+  p->input_end = window;
+  p->read_callback = cb;
+  p->read_callback_arg = arg;
+  p->window = window;
+  p->window_size = window_size;
   return GREX_OK;
 }
 
-grex_result_t grex_while(grex_parser_t* p, unsigned c) {
-  GREX_EOF_CHECK(p);
-
-  int n = 0;
+size_t grex_read_stdio(void* file, char* buf, size_t size) {
+  return fread(buf, 1, size, (FILE*)file);
+}
 
-  while (cur(p) == c) {
-    NEXT(p);
-    n++;
-  }
+unsigned long long grex_parser_tell(const grex_parser_t* p) {
+  return p->stream_offset + p->parsing_offset;
+}
 
-  if (n) {
-    return GREX_OK;
+void grex_parser_mark(grex_parser_t* p, grex_mark_t* mark) {
+  mark->offset = grex_parser_tell(p);
+  mark->hold = p->stream_hold;
+  if (mark->offset < p->stream_hold) {
+    p->stream_hold = mark->offset;
   }
-
-  report_error(p, "grex_while");
-  return GREX_NO_MATCH;
 }
 
-grex_result_t grex_until(grex_parser_t* p, unsigned c) {
-  GREX_EOF_CHECK(p);
+void grex_parser_rewind(grex_parser_t* p, const grex_mark_t* mark) {
+  p->parsing_offset = (size_t)(mark->offset - p->stream_offset);
+}
 
-  int n = 0;
+void grex_parser_release(grex_parser_t* p, const grex_mark_t* mark) {
+  p->stream_hold = mark->hold;
+}
 
-  while (cur(p) != c) {
-    NEXT(p);
-    n++;
+grex_result_t grex_memo_init(grex_memo_t* m, size_t capacity) {
+  size_t size = 16;
+  while (size < capacity) {
+    size *= 2;
   }
 
-  if (n) {
-    return GREX_OK;
+  m->entries = malloc(size * sizeof(*m->entries));
+  if (!m->entries) {
+    m->mask = 0;
+    return GREX_ALLOC_ERR;
   }
 
-  report_error(p, "grex_until");
-  return GREX_NO_MATCH;
+  m->mask = size - 1;
+  grex_memo_clear(m);
+  return GREX_OK;
 }
 
-grex_result_t grex_while_sequence(grex_parser_t* p, const char* seq) {
-  int result = grex_sequence(p, seq);
+void grex_memo_destroy(grex_memo_t* m) {
+  free(m->entries);
+  m->entries = NULL;
+  m->mask = 0;
+}
 
-  while (result == GREX_OK) {
-    result = grex_sequence(p, seq);
+void grex_memo_clear(grex_memo_t* m) {
+  if (!m->entries) {
+    return;
   }
 
-  return result;
+  // An empty slot never matches, since no rule can end before it starts
+  for (size_t i = 0; i <= m->mask; i++) {
+    m->entries[i].offset = 1;
+    m->entries[i].end = 0;
+    m->entries[i].rule = 0;
+    m->entries[i].result = 0;
+  }
 }
 
-grex_result_t grex_while_sequence_reverse(grex_parser_t* p, const char* seq) {
-  int result = grex_sequence_reverse(p, seq);
+static inline size_t memo_slot(const grex_memo_t* m, unsigned rule, unsigned long long offset) {
+  unsigned long long h = (offset ^ ((unsigned long long)rule << 40)) * 0x9E3779B97F4A7C15ULL;
+  return (size_t)(h >> 32) & m->mask;
+}
 
-  while (result == GREX_OK) {
-    result = grex_sequence_reverse(p, seq);
+int grex_memo_lookup(grex_parser_t* p, const grex_memo_t* m, unsigned rule, grex_result_t* result) {
+  if (!m->entries) {
+    return 0;
   }
 
-  return result;
-}
+  unsigned long long offset = grex_parser_tell(p);
+  const grex_memo_entry_t* e = &m->entries[memo_slot(m, rule, offset)];
+  if (e->offset != offset || e->rule != rule || e->end < e->offset) {
+    return 0;
+  }
 
-grex_result_t grex_until_sequence(grex_parser_t* p, const char* seq) {
-  int result = grex_sequence(p, seq);
+  p->parsing_offset = (size_t)(e->end - p->stream_offset);
+  *result = (grex_result_t)e->result;
+  return 1;
+}
 
-  while (result == GREX_NO_MATCH) {
-    NEXT(p);
-    result = grex_sequence(p, seq);
+void grex_memo_store(grex_parser_t* p, grex_memo_t* m, unsigned rule, const grex_mark_t* start, grex_result_t result) {
+  if (!m->entries) {
+    return;
   }
 
-  return result;
+  grex_memo_entry_t* e = &m->entries[memo_slot(m, rule, start->offset)];
+  e->offset = start->offset;
+  e->end = grex_parser_tell(p);
+  e->rule = rule;
+  e->result = result;
 }
 
-grex_result_t grex_until_sequence_reverse(grex_parser_t* p, const char* seq) {
-  int result = grex_sequence_reverse(p, seq);
+// Alignment of grex_arena_alloc, enough for any scalar type
+#define GREX_ARENA_ALIGN 16
+
+void grex_arena_init(grex_arena_t* a, size_t block_size) {
+  a->first = NULL;
+  a->current = NULL;
+  a->block_size = block_size ? block_size : GREX_ARENA_BLOCK;
+}
 
-  while (result == GREX_NO_MATCH) {
-    REVERSE_NEXT(p);
-    result = grex_sequence_reverse(p, seq);
+void grex_arena_destroy(grex_arena_t* a) {
+  grex_arena_block_t* b = a->first;
+  while (b) {
+    grex_arena_block_t* next = b->next;
+    free(b);
+    b = next;
   }
+  a->first = NULL;
+  a->current = NULL;
+}
 
-  return result;
+static inline char* arena_data(grex_arena_block_t* b) {
+  return (char*)(b + 1);
 }
 
-grex_result_t grex_integer(grex_parser_t* p, int base, long long *value) {
-  GREX_EOF_CHECK(p);
+// Padding that aligns the next allocation of the block
+static inline size_t arena_padding(grex_arena_block_t* b, size_t align) {
+  return (size_t)(-(uintptr_t)(arena_data(b) + b->used) & (align - 1));
+}
 
-  const char* str = &p->input[p->parsing_offset];
-  char* endptr = NULL;
-  unsigned long long res = strtoll(str, &endptr, base);
+// Allocates from the current block, or from the next block after it that is large enough,
+// or from a new block inserted after it. The blocks after the current one are the ones released.
+static char* arena_bump(grex_arena_t* a, size_t size, size_t align) {
+  grex_arena_block_t* b = a->current;
+  if (b && b->size - b->used >= size + arena_padding(b, align)) {
+    char* ptr = arena_data(b) + b->used + arena_padding(b, align);
+    b->used = ptr + size - arena_data(b);
+    return ptr;
+  }
 
-  if (endptr > str) {
+  grex_arena_block_t** link = b ? &b->next : &a->first;
+  while (*link && (*link)->size < size + align - 1) {
+    link = &(*link)->next;
+  }
 
-    if (endptr < p->input_end && *endptr == '.') {
-      // Possibly decimal number
-      if (endptr+1 < p->input_end && isdigit(endptr[1])) {
-        return GREX_NO_MATCH;
-      }
+  b = *link;
+  if (b) {
+    // A released block that is too small stays where it is, for a later smaller allocation
+    if (b != (a->current ? a->current->next : a->first)) {
+      *link = b->next;
+      grex_arena_block_t** after = a->current ? &a->current->next : &a->first;
+      b->next = *after;
+      *after = b;
     }
-
-    *value = res;
-    p->parsing_offset = endptr - p->input;
-    if (errno == ERANGE) {
-      return GREX_RANGE_ERR;
+  }
+  else {
+    size_t block_size = size + align - 1 > a->block_size ? size + align - 1 : a->block_size;
+    b = malloc(sizeof(*b) + block_size);
+    if (!b) {
+      return NULL;
     }
-    return GREX_OK;
+    b->size = block_size;
+    grex_arena_block_t** after = a->current ? &a->current->next : &a->first;
+    b->next = *after;
+    *after = b;
   }
 
-  report_error(p, "grex_uinteger");
-  return GREX_NO_MATCH;
+  b->used = 0;
+  a->current = b;
+  char* ptr = arena_data(b) + arena_padding(b, align);
+  b->used = ptr + size - arena_data(b);
+  return ptr;
 }
 
-grex_result_t grex_uinteger(grex_parser_t* p, int base, unsigned long long* value) {
-  GREX_EOF_CHECK(p);
-
-  const char* str = &p->input[p->parsing_offset];
-  char* endptr = NULL;
-  unsigned long long res = strtoull(str, &endptr, base);
+void* grex_arena_alloc(grex_arena_t* a, size_t size) {
+  return arena_bump(a, size, GREX_ARENA_ALIGN);
+}
 
-  if (endptr > str) {
+void grex_arena_reset(grex_arena_t* a) {
+  a->current = NULL;
+}
 
-    if (endptr < p->input_end && *endptr == '.') {
-      // Possibly decimal number
-      if (endptr+1 < p->input_end && isdigit(endptr[1])) {
-        return GREX_NO_MATCH;
-      }
-    }
+void grex_arena_mark(const grex_arena_t* a, grex_arena_mark_t* mark) {
+  mark->block = a->current;
+  mark->used = a->current ? a->current->used : 0;
+}
 
-    *value = res;
-    p->parsing_offset = endptr - p->input;
-    if (errno == ERANGE) {
-      return GREX_RANGE_ERR;
-    }
-    return GREX_OK;
+void grex_arena_release(grex_arena_t* a, const grex_arena_mark_t* mark) {
+  a->current = mark->block;
+  if (mark->block) {
+    mark->block->used = mark->used;
   }
+}
 
-  report_error(p, "grex_uinteger");
-  return GREX_NO_MATCH;
+void grex_parser_set_arena(grex_parser_t* p, grex_arena_t* a) {
+  p->arena = a;
 }
 
-grex_result_t grex_float(grex_parser_t* p, double* value) {
-  GREX_EOF_CHECK(p);
+// Copies the span into the arena, null-terminated, and points the span to the copy
+static grex_result_t arena_copy(grex_parser_t* p, grex_span_t* span) {
+  char* copy = p->arena ? arena_bump(p->arena, span->len + 1, 1) : NULL;
+  if (!copy) {
+    return GREX_ALLOC_ERR;
+  }
 
-  const char* str = &p->input[p->parsing_offset];
-  char* endptr = NULL;
-  double res = strtod(str, &endptr);
+  memcpy(copy, span->ptr, span->len);
+  copy[span->len] = 0;
+  span->ptr = copy;
+  return GREX_OK;
+}
 
-  if (endptr > str) {
-    *value = res;
-    p->parsing_offset = endptr - p->input;
-    return GREX_OK;
+// Copies the span of a primitive that started at the mark into the arena, or moves the head back to the mark
+static grex_result_t alloc_result(grex_parser_t* p, const grex_mark_t* mark, grex_result_t result, grex_span_t* span) {
+  if (result == GREX_OK && (result = arena_copy(p, span)) != GREX_OK) {
+    grex_parser_rewind(p, mark);
   }
-
-  report_error(p, "grex_float");
-  return GREX_NO_MATCH;
+  grex_parser_release(p, mark);
+  return result;
 }
 
-static int identifier_starter(grex_parser_t* p) {
-  int c = cur(p);
-  return isalpha(c) || (c == '_');
+// FNV-1a, one character at a time so the scanners can hash while they match
+#define GREX_INTERN_SEED 2166136261u
+
+static inline unsigned intern_hash_step(unsigned h, unsigned char c) {
+  return (h ^ c) * 16777619u;
 }
 
-static int identifier_component(grex_parser_t* p) {
-  int c = cur(p);
-  return isalnum(c) || (c == '_');
+static unsigned intern_hash(const char* str, size_t len) {
+  unsigned h = GREX_INTERN_SEED;
+  for (size_t i = 0; i < len; i++) {
+    h = intern_hash_step(h, (unsigned char)str[i]);
+  }
+  return h;
 }
 
-grex_result_t grex_identifier(grex_parser_t* p, char* buf, unsigned size) {
-  GREX_EOF_CHECK(p);
+// The slot of the name, or the empty slot where it would be added
+static grex_intern_slot_t* intern_probe(const grex_intern_t* t, const char* str, size_t len, unsigned hash) {
+  for (size_t i = hash & t->mask;; i = (i + 1) & t->mask) {
+    grex_intern_slot_t* slot = &t->slots[i];
+    if (!slot->id) {
+      return slot;
+    }
+    if (slot->hash == hash) {
+      const grex_span_t* name = &t->names[slot->id - 1];
+      if (name->len == len && !memcmp(name->ptr, str, len)) {
+        return slot;
+      }
+    }
+  }
+}
 
-  const char *begin = &p->input[p->parsing_offset];
-  int n = 0;
+// Doubles the slots, moving the names by their stored hash
+static grex_result_t intern_grow(grex_intern_t* t) {
+  size_t size = (t->mask + 1) * 2;
+  grex_intern_slot_t* slots = calloc(size, sizeof(*slots));
+  if (!slots) {
+    return GREX_ALLOC_ERR;
+  }
 
-  if (!identifier_starter(p)) {
-    return GREX_NO_MATCH;
+  for (size_t i = 0; i <= t->mask; i++) {
+    if (t->slots[i].id) {
+      size_t j = t->slots[i].hash & (size - 1);
+      while (slots[j].id) {
+        j = (j + 1) & (size - 1);
+      }
+      slots[j] = t->slots[i];
+    }
   }
 
-  NEXT(p);
-  n++;
+  free(t->slots);
+  t->slots = slots;
+  t->mask = size - 1;
+  return GREX_OK;
+}
 
-  while (identifier_component(p)) {
-    NEXT(p);
-    n++;
+static grex_result_t intern_insert(grex_intern_t* t, const char* str, size_t len, unsigned hash, unsigned* id) {
+  grex_intern_slot_t* slot = intern_probe(t, str, len, hash);
+  if (slot->id) {
+    *id = slot->id - 1;
+    return GREX_OK;
   }
 
-  if (n >= size) {
-    n = size - 1;
+  // Keeps the table at most half full
+  if ((t->count + 1) * 2 > t->mask + 1) {
+    if (intern_grow(t) != GREX_OK) {
+      return GREX_ALLOC_ERR;
+    }
+    slot = intern_probe(t, str, len, hash);
   }
-  if (n > 0) {
-    memset(buf, 0, size);
-    memcpy(buf, begin, n);
+
+  if (t->count == t->capacity) {
+    size_t capacity = t->capacity ? t->capacity * 2 : 16;
+    grex_span_t* names = realloc(t->names, capacity * sizeof(*names));
+    if (!names) {
+      return GREX_ALLOC_ERR;
+    }
+    t->names = names;
+    t->capacity = capacity;
+  }
+
+  char* copy = arena_bump(&t->arena, len + 1, 1);
+  if (!copy) {
+    return GREX_ALLOC_ERR;
   }
+  memcpy(copy, str, len);
+  copy[len] = 0;
 
+  t->names[t->count].ptr = copy;
+  t->names[t->count].len = len;
+  t->names[t->count].flags = 0;
+  slot->hash = hash;
+  slot->id = (unsigned)++t->count;
+  *id = slot->id - 1;
   return GREX_OK;
 }
 
-grex_result_t grex_string(grex_parser_t* p, char* buf, unsigned size) {
-  int result = grex_double_quoted_string(p, buf, size);
-  if (result == GREX_OK) {
-    return result;
+grex_result_t grex_intern_init(grex_intern_t* t, size_t expected) {
+  size_t size = 16;
+  while (size < expected * 2) {
+    size *= 2;
   }
 
-  result = grex_single_quoted_string(p, buf, size);
-  return result;
+  t->names = NULL;
+  t->count = 0;
+  t->capacity = 0;
+  grex_arena_init(&t->arena, 0);
+
+  t->slots = calloc(size, sizeof(*t->slots));
+  if (!t->slots) {
+    t->mask = 0;
+    return GREX_ALLOC_ERR;
+  }
+  t->mask = size - 1;
+
+  if (expected > 0) {
+    t->names = malloc(expected * sizeof(*t->names));
+    t->capacity = t->names ? expected : 0;
+  }
+  return GREX_OK;
 }
 
-static grex_result_t parse_string(grex_parser_t* p, int delim, char* buf, unsigned size) {
-  GREX_EOF_CHECK(p);
+void grex_intern_destroy(grex_intern_t* t) {
+  free(t->slots);
+  free(t->names);
+  grex_arena_destroy(&t->arena);
+  t->slots = NULL;
+  t->mask = 0;
+  t->names = NULL;
+  t->count = 0;
+  t->capacity = 0;
+}
 
-  if (cur(p) != delim) {
-    return GREX_NO_MATCH;
+void grex_intern_clear(grex_intern_t* t) {
+  if (t->slots) {
+    memset(t->slots, 0, (t->mask + 1) * sizeof(*t->slots));
   }
+  t->count = 0;
+  grex_arena_reset(&t->arena);
+}
 
-  NEXT(p);
+grex_result_t grex_intern_string(grex_intern_t* t, const char* str, size_t len, unsigned* id) {
+  if (!t->slots) {
+    return GREX_ALLOC_ERR;
+  }
+  return intern_insert(t, str, len, intern_hash(str, len), id);
+}
 
-  const char *begin = &p->input[p->parsing_offset];
-  int n = 0;
+int grex_intern_find(const grex_intern_t* t, const char* str, size_t len, unsigned* id) {
+  if (!t->slots) {
+    return 0;
+  }
 
-  while (cur(p) != delim) {
-    if (cur(p) == '\\') {
-      NEXT(p);
-      n++;
-      if (cur(p) == delim) {
-        NEXT(p);
-        n++;
-      }
-    }
-    NEXT(p);
-    n++;
+  const grex_intern_slot_t* slot = intern_probe(t, str, len, intern_hash(str, len));
+  if (!slot->id) {
+    return 0;
   }
+  *id = slot->id - 1;
+  return 1;
+}
+
+const grex_span_t* grex_intern_name(const grex_intern_t* t, unsigned id) {
+  return id < t->count ? &t->names[id] : NULL;
+}
 
-  // consume end delimieter
-  NEXT(p);
+void grex_parser_set_intern(grex_parser_t* p, grex_intern_t* t) {
+  p->intern = t;
+}
 
-  if (n >= size) {
-    n = size - 1;
+// Streaming mode: discards the input behind the head (and behind stream_hold, if it is set) and
+// reads more into the window. The last character is always kept, so the head can stay on it at eof.
+// The window offset pointed by offset, if any, is moved along with the input.
+// Returns the number of characters read, zero at the end of the stream or if the parser does not stream.
+static size_t refill(grex_parser_t* p, size_t* offset) {
+  if (!p->read_callback) {
+    return 0;
   }
-  if (n > 0) {
-    memset(buf, 0, size);
 
-    int di = 0;
-    for (int i = 0; i < n; i++) {
-      if (begin[i] == '\\') {
-        if (i+1 < n && begin[i + 1] == delim) {
-          buf[di++] = delim;
-          i++;
-        }
-        else {
-          buf[di++] = '\\';
-        }
-      }
-      else {
-        buf[di++] = begin[i];
-      }
+  size_t keep = p->parsing_offset;
+  if (p->stream_hold - p->stream_offset < keep) {
+    keep = (size_t)(p->stream_hold - p->stream_offset);
+  }
+  if (keep >= p->input_length) {
+    keep = p->input_length ? p->input_length - 1 : 0;
+  }
+
+  if (keep > 0) {
+    line_index_discard(p, keep);
+    if (p->structural) {
+      structural_discard(p, keep);
+    }
+    memmove(p->window, p->window + keep, p->input_length - keep);
+    p->input_length -= keep;
+    p->parsing_offset -= keep;
+    p->stream_offset += keep;
+    if (offset) {
+      *offset -= keep;
     }
   }
 
-  return GREX_OK;
-}
+  // Only a token that fills the whole window makes it grow
+  if (p->input_length == p->window_size) {
+    char* window = realloc(p->window, p->window_size * 2);
+    if (!window) {
+      return 0;
+    }
+    p->window = window;
+    p->window_size *= 2;
+  }
 
-grex_result_t grex_delimited_string(grex_parser_t* p, int delim, char* buf, unsigned size) {
-  unsigned prev_offset = p->parsing_offset;
+  size_t n = p->read_callback(p->read_callback_arg, p->window + p->input_length, p->window_size - p->input_length);
+  if (n == 0) {
+    p->read_callback = NULL;
+  }
 
-  int result = parse_string(p, delim, buf, size);
+  p->input_length += n;
+  p->input = p->window;
+  p->input_end = p->window + p->input_length;
+  return n;
+}
 
-  if (result != GREX_OK) {
-    p->parsing_offset = prev_offset;
+// Streaming mode: makes sure at least n characters past the head are in the window.
+// Returns zero if the input ends before that.
+static int ensure(grex_parser_t* p, size_t n) {
+  while (p->input_length - p->parsing_offset < n) {
+    if (!refill(p, NULL)) {
+      return 0;
+    }
   }
+  return 1;
+}
 
-  return result;
+void grex_parser_destroy(grex_parser_t* p) {
+  if (p->file_data) {
+    grex_parser_close_file(p);
+  }
+  line_index_free(p);
+  grex_parser_set_structural(p, NULL, 0);
+  free(p->window);
+  p->window = NULL;
+  p->read_callback = NULL;
 }
 
-grex_result_t grex_single_quoted_string(grex_parser_t* p, char* buf, unsigned size) {
-  return grex_delimited_string(p, '\'', buf, size);
+void grex_parser_reset(grex_parser_t* p) {
+  p->parsing_offset = 0;
 }
 
-grex_result_t grex_double_quoted_string(grex_parser_t* p, char* buf, unsigned size) {
-  return grex_delimited_string(p, '"', buf, size);
+void grex_parser_end(grex_parser_t* p) {
+  p->parsing_offset = p->input_length;
 }
 
-grex_result_t grex_capture_until(grex_parser_t* p, int c, char* buf, unsigned size) {
-  unsigned prev_offset = p->parsing_offset;
+void grex_parser_set_error_callback(grex_parser_t* p, grex_error_callback_t cb, void* arg) {
+  p->error_callback = cb;
+  p->error_callback_arg = arg;
+}
+
+void grex_parser_set_error_mode(grex_parser_t* p, int mode) {
+  p->error_mode = mode;
+  grex_parser_clear_error(p);
+}
+
+void grex_parser_clear_error(grex_parser_t* p) {
+  p->error_offset = 0;
+  p->error_expected = 0;
+}
+
+size_t grex_parser_error(grex_parser_t* p, char* buf, size_t size) {
+  if (!p->error_expected) {
+    if (size > 0) {
+      buf[0] = 0;
+    }
+    return 0;
+  }
+
+  char message[1024];
+  unsigned long long line, column;
+  int n;
+
+  if (grex_parser_position(p, p->error_offset, &line, &column) == GREX_OK) {
+    n = snprintf(message, sizeof(message), "%llu:%llu: expected ", line, column);
+  }
+  else {
+    n = snprintf(message, sizeof(message), "offset %llu: expected ", p->error_offset);
+  }
+
+  // "a", "a or b", "a, b or c"
+  unsigned long long expected = p->error_expected;
+  int first = 1;
+  while (expected) {
+    int i = ctz64(expected);
+    expected &= expected - 1;
+    n += snprintf(message + n, sizeof(message) - n, "%s%s", first ? "" : expected ? ", " : " or ", primitive_names[i]);
+    first = 0;
+  }
+
+  size_t length = (size_t)n;
+  if (size > 0) {
+    size_t copy = length < size ? length : size - 1;
+    memcpy(buf, message, copy);
+    buf[copy] = 0;
+  }
+  return length;
+}
+
+static inline int class_has(const grex_class_t* cls, unsigned char c) {
+  return (cls->bits[c >> 6] >> (c & 63)) & 1;
+}
+
+// Finds the first character from `from` onwards whose membership equals `member`, or 256
+static int class_find(const grex_class_t* cls, int from, int member) {
+  while (from < 256) {
+    unsigned long long word = cls->bits[from >> 6];
+    if (!member) {
+      word = ~word;
+    }
+    word &= ~0ULL << (from & 63);
+    if (word) {
+      return (from & ~63) + ctz64(word);
+    }
+    from = (from & ~63) + 64;
+  }
+  return 256;
+}
+
+static void class_update_ranges(grex_class_t* cls) {
+  unsigned n = 0;
+  int c = class_find(cls, 0, 1);
+
+  while (c < 256) {
+    int end = class_find(cls, c, 0);
+    if (n < GREX_CLASS_MAX_RANGES) {
+      cls->ranges[n][0] = (unsigned char)c;
+      cls->ranges[n][1] = (unsigned char)(end - 1);
+    }
+    n++;
+    c = class_find(cls, end, 1);
+  }
+
+  // A count above GREX_CLASS_MAX_RANGES tells the scanners to use the bitmap only
+  cls->range_count = n;
+}
+
+void grex_class_clear(grex_class_t* cls) {
+  memset(cls->bits, 0, sizeof(cls->bits));
+  cls->range_count = 0;
+}
+
+void grex_class_add_set(grex_class_t* cls, const char* set) {
+  for (const unsigned char* s = (const unsigned char*)set; *s; s++) {
+    cls->bits[*s >> 6] |= 1ULL << (*s & 63);
+  }
+  class_update_ranges(cls);
+}
+
+void grex_class_add_range(grex_class_t* cls, int first, int last) {
+  if (first < 0) first = 0;
+  if (last > 255) last = 255;
+
+  for (int c = first; c <= last; c++) {
+    cls->bits[c >> 6] |= 1ULL << (c & 63);
+  }
+  class_update_ranges(cls);
+}
+
+void grex_class_negate(grex_class_t* cls) {
+  for (int i = 0; i < 4; i++) {
+    cls->bits[i] = ~cls->bits[i];
+  }
+  class_update_ranges(cls);
+}
+
+grex_result_t grex_class_parse(grex_class_t* cls, const char* spec) {
+  const unsigned char* s = (const unsigned char*)spec;
+  int negate = 0;
+
+  grex_class_clear(cls);
+
+  if (*s == '^') {
+    negate = 1;
+    s++;
+  }
+
+  while (*s) {
+    int first = *s++;
+    if (first == '\\') {
+      if (!*s) {
+        return GREX_NO_MATCH;
+      }
+      first = *s++;
+    }
+
+    int last = first;
+    if (s[0] == '-' && s[1]) {
+      s++;
+      last = *s++;
+      if (last == '\\') {
+        if (!*s) {
+          return GREX_NO_MATCH;
+        }
+        last = *s++;
+      }
+      if (first > last) {
+        return GREX_NO_MATCH;
+      }
+    }
+
+    grex_class_add_range(cls, first, last);
+  }
+
+  if (negate) {
+    grex_class_negate(cls);
+  }
+  return GREX_OK;
+}
+
+int grex_class_contains(const grex_class_t* cls, int c) {
+  return class_has(cls, (unsigned char)c);
+}
+
+#if defined(GREX_AVX2)
+static const unsigned char* class_scan_avx2(const grex_class_t* cls, const unsigned char* s, const unsigned char* end, int member) {
+  __m256i first[GREX_CLASS_MAX_RANGES];
+  __m256i width[GREX_CLASS_MAX_RANGES];
+  unsigned n = cls->range_count;
+
+  for (unsigned i = 0; i < n; i++) {
+    first[i] = _mm256_set1_epi8((char)cls->ranges[i][0]);
+    width[i] = _mm256_set1_epi8((char)(cls->ranges[i][1] - cls->ranges[i][0]));
+  }
+
+  unsigned flip = member ? 0xFFFFFFFFu : 0;
+
+  while (end - s >= 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)s);
+    __m256i m = _mm256_setzero_si256();
+    for (unsigned i = 0; i < n; i++) {
+      // (c - first) <= (last - first), as an unsigned compare
+      __m256i d = _mm256_sub_epi8(v, first[i]);
+      m = _mm256_or_si256(m, _mm256_cmpeq_epi8(_mm256_min_epu8(d, width[i]), d));
+    }
+    unsigned mask = (unsigned)_mm256_movemask_epi8(m) ^ flip;
+    if (mask) {
+      return s + ctz32(mask);
+    }
+    s += 32;
+  }
+
+  return s;
+}
+#endif
+
+#if defined(GREX_SSE2)
+static const unsigned char* class_scan_sse2(const grex_class_t* cls, const unsigned char* s, const unsigned char* end, int member) {
+  __m128i first[GREX_CLASS_MAX_RANGES];
+  __m128i width[GREX_CLASS_MAX_RANGES];
+  unsigned n = cls->range_count;
+
+  for (unsigned i = 0; i < n; i++) {
+    first[i] = _mm_set1_epi8((char)cls->ranges[i][0]);
+    width[i] = _mm_set1_epi8((char)(cls->ranges[i][1] - cls->ranges[i][0]));
+  }
+
+  unsigned flip = member ? 0xFFFFu : 0;
+
+  while (end - s >= 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)s);
+    __m128i m = _mm_setzero_si128();
+    for (unsigned i = 0; i < n; i++) {
+      __m128i d = _mm_sub_epi8(v, first[i]);
+      m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_min_epu8(d, width[i]), d));
+    }
+    unsigned mask = (unsigned)_mm_movemask_epi8(m) ^ flip;
+    if (mask) {
+      return s + ctz32(mask);
+    }
+    s += 16;
+  }
+
+  return s;
+}
+#endif
+
+// Returns the first character in [s, end) whose membership in the class is not `member`, or end
+static const char* class_scan(const grex_class_t* cls, const char* s, const char* end, int member) {
+  const unsigned char* u = (const unsigned char*)s;
+  const unsigned char* e = (const unsigned char*)end;
+
+  // Most runs are short, so check a few characters before paying for the SIMD setup
+  for (int i = 0; i < 8 && u < e; i++, u++) {
+    if (class_has(cls, *u) != member) {
+      return (const char*)u;
+    }
+  }
+
+  if (cls->range_count <= GREX_CLASS_MAX_RANGES) {
+#if defined(GREX_AVX2)
+    u = class_scan_avx2(cls, u, e, member);
+    if (e - u >= 32) {
+      return (const char*)u;
+    }
+#endif
+#if defined(GREX_SSE2)
+    u = class_scan_sse2(cls, u, e, member);
+    if (e - u >= 16) {
+      return (const char*)u;
+    }
+#endif
+  }
+
+  while (u < e && class_has(cls, *u) == member) {
+    u++;
+  }
+  return (const char*)u;
+}
+
+// Streaming mode: reads more input once a scan reached the end of the window, setting *s to where
+// the scan continues. The scanned input is discarded, unless it is being captured into a span.
+static size_t scan_refill(grex_parser_t* p, size_t* s, const grex_span_t* span) {
+  *s = p->input_length;
+  if (!span) {
+    p->parsing_offset = p->input_length;
+  }
+  return refill(p, s);
+}
+
+// Captures the input between the head and stop into the span, if any, then moves the head to stop
+static grex_result_t scan_done(grex_parser_t* p, const char* stop, grex_span_t* span, unsigned long long begin, grex_primitive_t where) {
+  if (span) {
+    span->ptr = &p->input[p->parsing_offset];
+    span->len = stop - span->ptr;
+    span->flags = 0;
+  }
+
+  p->parsing_offset = stop - p->input;
+  if (grex_parser_tell(p) > begin) {
+    return GREX_OK;
+  }
+
+  report_error(p, where);
+  return GREX_NO_MATCH;
+}
+
+static grex_result_t scan_class(grex_parser_t* p, const grex_class_t* cls, int member, grex_span_t* span, grex_primitive_t where) {
+  GREX_EOF_CHECK(p);
+
+  unsigned long long begin = grex_parser_tell(p);
+  size_t s = p->parsing_offset;
+  const char* stop;
+
+  while ((stop = class_scan(cls, &p->input[s], p->input_end, member)) == p->input_end) {
+    if (!scan_refill(p, &s, span)) {
+      return stop_at_eof(p);
+    }
+  }
+
+  return scan_done(p, stop, span, begin, where);
+}
+
+// " \t\n\r\f"
+static const grex_class_t whitespace_class = {
+  { 0x0000000100003600ULL, 0, 0, 0 }, 3, { { '\t', '\n' }, { '\f', '\r' }, { ' ', ' ' } }
+};
+
+// " \t\f"
+static const grex_class_t whitespace_no_line_class = {
+  { 0x0000000100001200ULL, 0, 0, 0 }, 3, { { '\t', '\t' }, { '\f', '\f' }, { ' ', ' ' } }
+};
+
+// [A-Za-z_]
+static const grex_class_t identifier_start_class = {
+  { 0, 0x07FFFFFE87FFFFFEULL, 0, 0 }, 3, { { 'A', 'Z' }, { '_', '_' }, { 'a', 'z' } }
+};
+
+// [A-Za-z0-9_]
+static const grex_class_t identifier_class = {
+  { 0x03FF000000000000ULL, 0x07FFFFFE87FFFFFEULL, 0, 0 }, 4, { { '0', '9' }, { 'A', 'Z' }, { '_', '_' }, { 'a', 'z' } }
+};
+
+grex_result_t GREX_IMPL(grex_whitespace)(grex_parser_t* p) {
+  return scan_class(p, &whitespace_class, 1, NULL, GREX_PRIMITIVE_WHITESPACE);
+}
+
+grex_result_t GREX_IMPL(grex_whitespace_no_line)(grex_parser_t* p) {
+  return scan_class(p, &whitespace_no_line_class, 1, NULL, GREX_PRIMITIVE_WHITESPACE_NO_LINE);
+}
+
+grex_result_t GREX_IMPL(grex_char)(grex_parser_t* p, int c) {
+  GREX_EOF_CHECK(p);
+  if (cur(p) == c) {
+    next(p);
+    return GREX_OK;
+  }
+  report_error(p, GREX_PRIMITIVE_CHAR);
+  return GREX_NO_MATCH;
+}
+
+grex_result_t GREX_IMPL(grex_set)(grex_parser_t* p, const char* set) {
+  grex_class_t cls;
+  grex_class_clear(&cls);
+  grex_class_add_set(&cls, set);
+  return scan_class(p, &cls, 1, NULL, GREX_PRIMITIVE_SET);
+}
+
+static grex_result_t char_class(grex_parser_t* p, const grex_class_t* cls, grex_primitive_t where) {
+  GREX_EOF_CHECK(p);
+
+  if (class_has(cls, cur(p))) {
+    next(p);
+    return GREX_OK;
+  }
+
+  report_error(p, where);
+  return GREX_NO_MATCH;
+}
+
+grex_result_t GREX_IMPL(grex_char_class)(grex_parser_t* p, const grex_class_t* cls) {
+  return char_class(p, cls, GREX_PRIMITIVE_CHAR_CLASS);
+}
+
+grex_result_t GREX_IMPL(grex_range)(grex_parser_t* p, const char* range) {
+  grex_class_t cls;
+  if (grex_class_parse(&cls, range) != GREX_OK) {
+    return GREX_NO_MATCH;
+  }
+  return char_class(p, &cls, GREX_PRIMITIVE_RANGE);
+}
+
+grex_result_t GREX_IMPL(grex_range_while)(grex_parser_t* p, const char* range) {
+  grex_class_t cls;
+  if (grex_class_parse(&cls, range) != GREX_OK) {
+    return GREX_NO_MATCH;
+  }
+  return scan_class(p, &cls, 1, NULL, GREX_PRIMITIVE_RANGE_WHILE);
+}
+
+grex_result_t GREX_IMPL(grex_sequence)(grex_parser_t* p, const char* seq) {
+  GREX_EOF_CHECK(p);
+
+  size_t n = strlen(seq);
+  if (!ensure(p, n)) {
+    report_error(p, GREX_PRIMITIVE_SEQUENCE);
+    return GREX_NO_MATCH;
+  }
+
+  if (memcmp(&p->input[p->parsing_offset], seq, n)) {
+    report_error(p, GREX_PRIMITIVE_SEQUENCE);
+    return GREX_NO_MATCH;
+  }
+
+  p->parsing_offset += n;
+  return GREX_OK;
+}
+
+grex_result_t GREX_IMPL(grex_sequence_reverse)(grex_parser_t* p, const char* seq) {
+  GREX_REVERSE_EOF_CHECK(p);
+
+  size_t n = strlen(seq);
+  if (p->parsing_offset < n) {
+    report_error(p, GREX_PRIMITIVE_SEQUENCE_REVERSE);
+    return GREX_NO_MATCH;
+  }
+
+  if (memcmp(&p->input[p->parsing_offset - n], seq, n)) {
+    report_error(p, GREX_PRIMITIVE_SEQUENCE_REVERSE);
+    return GREX_NO_MATCH;
+  }
+
+  p->parsing_offset -= n;
+  return GREX_OK;
+}
+
+grex_result_t GREX_IMPL(grex_while)(grex_parser_t* p, unsigned c) {
+  GREX_EOF_CHECK(p);
+
+  int n = 0;
+
+  while (cur(p) == c) {
+    NEXT(p);
+    n++;
+  }
+
+  if (n) {
+    return GREX_OK;
+  }
+
+  report_error(p, GREX_PRIMITIVE_WHILE);
+  return GREX_NO_MATCH;
+}
+
+// The search kernels pad the needles with copies of the first byte, so they only come in
+// widths of 1, 4 and 8 and the compare loops below are unrolled with a constant count
+static inline unsigned bytes_width(unsigned count) {
+  return count == 1 ? 1 : count <= 4 ? 4 : 8;
+}
+
+#if defined(GREX_AVX2)
+static inline unsigned bytes_match_avx2(__m256i v, const __m256i* needle, unsigned width) {
+  __m256i m = _mm256_cmpeq_epi8(v, needle[0]);
+  for (unsigned i = 1; i < width; i++) {
+    m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, needle[i]));
+  }
+  return (unsigned)_mm256_movemask_epi8(m);
+}
+
+static inline const unsigned char* bytes_loop_avx2(const unsigned char* s, const unsigned char* end, const __m256i* needle, unsigned width) {
+  while (end - s >= 64) {
+    unsigned long long lo = bytes_match_avx2(_mm256_loadu_si256((const __m256i*)s), needle, width);
+    unsigned long long hi = bytes_match_avx2(_mm256_loadu_si256((const __m256i*)(s + 32)), needle, width);
+    unsigned long long mask = lo | (hi << 32);
+    if (mask) {
+      return s + ctz64(mask);
+    }
+    s += 64;
+  }
+
+  while (end - s >= 32) {
+    unsigned mask = bytes_match_avx2(_mm256_loadu_si256((const __m256i*)s), needle, width);
+    if (mask) {
+      return s + ctz32(mask);
+    }
+    s += 32;
+  }
+
+  return s;
+}
+
+static const unsigned char* bytes_scan_avx2(const unsigned char* s, const unsigned char* end, const unsigned char* bytes, unsigned count) {
+  __m256i needle[GREX_UNTIL_ANY_MAX];
+  unsigned width = bytes_width(count);
+
+  for (unsigned i = 0; i < width; i++) {
+    needle[i] = _mm256_set1_epi8((char)bytes[i < count ? i : 0]);
+  }
+
+  if (width == 1) {
+    // Long lines are the common case for a single byte, so test 128 bytes per iteration
+    while (end - s >= 128) {
+      __m256i a = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)s), needle[0]);
+      __m256i b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(s + 32)), needle[0]);
+      __m256i c = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(s + 64)), needle[0]);
+      __m256i d = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(s + 96)), needle[0]);
+      if (_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d)))) {
+        break;
+      }
+      s += 128;
+    }
+    return bytes_loop_avx2(s, end, needle, 1);
+  }
+
+  if (width == 4) {
+    return bytes_loop_avx2(s, end, needle, 4);
+  }
+  return bytes_loop_avx2(s, end, needle, 8);
+}
+#endif
+
+#if defined(GREX_SSE2)
+static inline unsigned bytes_match_sse2(__m128i v, const __m128i* needle, unsigned width) {
+  __m128i m = _mm_cmpeq_epi8(v, needle[0]);
+  for (unsigned i = 1; i < width; i++) {
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(v, needle[i]));
+  }
+  return (unsigned)_mm_movemask_epi8(m);
+}
+
+static inline const unsigned char* bytes_loop_sse2(const unsigned char* s, const unsigned char* end, const __m128i* needle, unsigned width) {
+  while (end - s >= 32) {
+    unsigned lo = bytes_match_sse2(_mm_loadu_si128((const __m128i*)s), needle, width);
+    unsigned hi = bytes_match_sse2(_mm_loadu_si128((const __m128i*)(s + 16)), needle, width);
+    unsigned mask = lo | (hi << 16);
+    if (mask) {
+      return s + ctz32(mask);
+    }
+    s += 32;
+  }
+
+  while (end - s >= 16) {
+    unsigned mask = bytes_match_sse2(_mm_loadu_si128((const __m128i*)s), needle, width);
+    if (mask) {
+      return s + ctz32(mask);
+    }
+    s += 16;
+  }
+
+  return s;
+}
+
+static const unsigned char* bytes_scan_sse2(const unsigned char* s, const unsigned char* end, const unsigned char* bytes, unsigned count) {
+  __m128i needle[GREX_UNTIL_ANY_MAX];
+  unsigned width = bytes_width(count);
+
+  for (unsigned i = 0; i < width; i++) {
+    needle[i] = _mm_set1_epi8((char)bytes[i < count ? i : 0]);
+  }
+
+  if (width == 1) {
+    if (end - s >= 80) {
+      // Check one unaligned block, then continue from the next 16-byte boundary
+      unsigned mask = bytes_match_sse2(_mm_loadu_si128((const __m128i*)s), needle, 1);
+      if (mask) {
+        return s + ctz32(mask);
+      }
+      s = (const unsigned char*)(((size_t)s + 16) & ~(size_t)15);
+
+      while (end - s >= 64) {
+        __m128i a = _mm_cmpeq_epi8(_mm_load_si128((const __m128i*)s), needle[0]);
+        __m128i b = _mm_cmpeq_epi8(_mm_load_si128((const __m128i*)(s + 16)), needle[0]);
+        __m128i c = _mm_cmpeq_epi8(_mm_load_si128((const __m128i*)(s + 32)), needle[0]);
+        __m128i d = _mm_cmpeq_epi8(_mm_load_si128((const __m128i*)(s + 48)), needle[0]);
+        if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)))) {
+          break;
+        }
+        s += 64;
+      }
+    }
+    return bytes_loop_sse2(s, end, needle, 1);
+  }
+
+  if (width == 4) {
+    return bytes_loop_sse2(s, end, needle, 4);
+  }
+  return bytes_loop_sse2(s, end, needle, 8);
+}
+#endif
+
+// Returns the first character in [s, end) equal to any of the `count` bytes, or end.
+// count must be between 1 and GREX_UNTIL_ANY_MAX.
+static const char* bytes_scan(const char* s, const char* end, const unsigned char* bytes, unsigned count) {
+  const unsigned char* u = (const unsigned char*)s;
+  const unsigned char* e = (const unsigned char*)end;
+
+#if defined(GREX_AVX2)
+  u = bytes_scan_avx2(u, e, bytes, count);
+  if (e - u >= 32) {
+    return (const char*)u;
+  }
+#endif
+#if defined(GREX_SSE2)
+  u = bytes_scan_sse2(u, e, bytes, count);
+  if (e - u >= 16) {
+    return (const char*)u;
+  }
+#else
+  if (count == 1) {
+    const void* hit = memchr(u, bytes[0], e - u);
+    return hit ? (const char*)hit : end;
+  }
+#endif
+
+  for (; u < e; u++) {
+    for (unsigned i = 0; i < count; i++) {
+      if (*u == bytes[i]) {
+        return (const char*)u;
+      }
+    }
+  }
+  return end;
+}
+
+grex_result_t grex_parser_set_structural(grex_parser_t* p, const char* chars, size_t block_size) {
+  if (p->structural) {
+    free(p->structural->bits);
+    free(p->structural);
+    p->structural = NULL;
+  }
+  if (!chars) {
+    return GREX_OK;
+  }
+
+  // Whole words only, so a block never ends in the middle of a bitmap word
+  block_size = block_size ? (block_size + 63) & ~(size_t)63 : GREX_STRUCTURAL_BLOCK;
+
+  grex_structural_t* st = malloc(sizeof(*st));
+  unsigned long long* bits = malloc(block_size / 64 * 2 * sizeof(*bits));
+  if (!st || !bits) {
+    free(st);
+    free(bits);
+    return GREX_ALLOC_ERR;
+  }
+
+  st->bits = bits;
+  st->escaped = bits + block_size / 64;
+  st->start = 0;
+  st->length = 0;
+  st->capacity = block_size;
+  st->carry = 0;
+  st->window_carry = 0;
+  grex_class_clear(&st->chars);
+  grex_class_add_set(&st->chars, chars);
+
+  // nibbles[c >> 7][c & 15] has bit (c >> 4) & 7 set for every structural character c
+  memset(st->nibbles, 0, sizeof(st->nibbles));
+  for (unsigned c = 0; c < 256; c++) {
+    if (class_has(&st->chars, (unsigned char)c)) {
+      st->nibbles[c >> 7][c & 15] |= (unsigned char)(1 << ((c >> 4) & 7));
+    }
+  }
+  p->structural = st;
+  return GREX_OK;
+}
+
+// Returns the characters escaped by a backslash, given the backslashes of a word and whether its first
+// character is escaped. Sets *escapes to the backslashes that escape the character after them.
+static inline unsigned long long structural_escaped(unsigned long long backslashes, int carry, unsigned long long* escapes) {
+  const unsigned long long odd = 0xAAAAAAAAAAAAAAAAULL;
+
+  // An escaped backslash can't start a run, then each run escapes the characters at an odd distance from its start
+  unsigned long long starts = backslashes & ~(unsigned long long)carry;
+  unsigned long long runs = ((starts << 1) | odd) - starts;
+  unsigned long long escape_and_terminal = runs ^ odd;
+
+  *escapes = escape_and_terminal & backslashes;
+  return escape_and_terminal ^ (backslashes | (unsigned long long)carry);
+}
+
+#if defined(GREX_AVX2)
+// Classifies 32 characters with two table lookups on their nibbles, for any set of characters
+static inline unsigned structural_classify_avx2(__m256i v, __m256i low_table, __m256i high_table, __m256i bit_table) {
+  __m256i low = _mm256_and_si256(v, _mm256_set1_epi8(0x0f));
+  __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0f));
+  __m256i rows = _mm256_blendv_epi8(_mm256_shuffle_epi8(low_table, low), _mm256_shuffle_epi8(high_table, low), v);
+  __m256i hit = _mm256_and_si256(rows, _mm256_shuffle_epi8(bit_table, high));
+  return ~(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hit, _mm256_setzero_si256()));
+}
+
+// Marks the structural characters and the backslashes of the whole 64-character words at s
+static size_t structural_words_avx2(const grex_structural_t* st, const unsigned char* s, size_t words, unsigned long long* bits, unsigned long long* backslashes) {
+  __m256i low_table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)st->nibbles[0]));
+  __m256i high_table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)st->nibbles[1]));
+  __m256i bit_table = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+                                       1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+  __m256i backslash = _mm256_set1_epi8('\\');
+
+  for (size_t w = 0; w < words; w++, s += 64) {
+    __m256i lo = _mm256_loadu_si256((const __m256i*)s);
+    __m256i hi = _mm256_loadu_si256((const __m256i*)(s + 32));
+    bits[w] = structural_classify_avx2(lo, low_table, high_table, bit_table)
+      | (unsigned long long)structural_classify_avx2(hi, low_table, high_table, bit_table) << 32;
+    backslashes[w] = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, backslash))
+      | (unsigned long long)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, backslash)) << 32;
+  }
+  return words;
+}
+#endif
+
+#if defined(GREX_SSE2) && !defined(GREX_AVX2)
+static size_t structural_words_sse2(const grex_class_t* cls, const unsigned char* s, size_t words, unsigned long long* bits, unsigned long long* backslashes) {
+  __m128i first[GREX_CLASS_MAX_RANGES];
+  __m128i width[GREX_CLASS_MAX_RANGES];
+  __m128i backslash = _mm_set1_epi8('\\');
+  unsigned n = cls->range_count;
+
+  for (unsigned i = 0; i < n; i++) {
+    first[i] = _mm_set1_epi8((char)cls->ranges[i][0]);
+    width[i] = _mm_set1_epi8((char)(cls->ranges[i][1] - cls->ranges[i][0]));
+  }
+
+  for (size_t w = 0; w < words; w++, s += 64) {
+    unsigned long long m = 0, b = 0;
+    for (int k = 0; k < 4; k++) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(s + k * 16));
+      __m128i in = _mm_setzero_si128();
+      for (unsigned i = 0; i < n; i++) {
+        __m128i d = _mm_sub_epi8(v, first[i]);
+        in = _mm_or_si128(in, _mm_cmpeq_epi8(_mm_min_epu8(d, width[i]), d));
+      }
+      m |= (unsigned long long)(unsigned)_mm_movemask_epi8(in) << (k * 16);
+      b |= (unsigned long long)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)) << (k * 16);
+    }
+    bits[w] = m;
+    backslashes[w] = b;
+  }
+  return words;
+}
+#endif
+
+// Streaming mode: the first n characters of the window are about to be discarded, so the parity of the
+// backslash run they end with is kept for a block that starts where the window will
+static void structural_discard(grex_parser_t* p, size_t n) {
+  grex_structural_t* st = p->structural;
+  size_t i = n;
+  while (i > 0 && p->input[i - 1] == '\\') {
+    i--;
+  }
+
+  int carry = (int)((n - i) & 1);
+  if (i == 0) {
+    carry ^= st->window_carry;
+  }
+  st->window_carry = carry;
+}
+
+// Indexes the block that starts at window offset s
+static void structural_build(grex_parser_t* p, size_t s) {
+  grex_structural_t* st = p->structural;
+  unsigned long long start = p->stream_offset + s;
+  size_t length = p->input_length - s;
+  if (length > st->capacity) {
+    length = st->capacity;
+  }
+
+  // A block right after the previous one takes its escape state, any other block counts the backslashes before it
+  int carry = 0;
+  if (start == st->start + st->length && st->length) {
+    carry = st->carry;
+  }
+  else {
+    size_t i = s;
+    while (i > 0 && p->input[i - 1] == '\\') {
+      carry = !carry;
+      i--;
+    }
+    if (i == 0) {
+      carry ^= st->window_carry;
+    }
+  }
+
+  // The backslashes go in the escaped bitmap first, then are replaced by the characters they escape
+  const unsigned char* u = (const unsigned char*)&p->input[s];
+  size_t w = 0;
+#if defined(GREX_AVX2)
+  w = structural_words_avx2(st, u, length / 64, st->bits, st->escaped);
+#elif defined(GREX_SSE2)
+  if (st->chars.range_count <= GREX_CLASS_MAX_RANGES) {
+    w = structural_words_sse2(&st->chars, u, length / 64, st->bits, st->escaped);
+  }
+#endif
+
+  for (; w * 64 < length; w++) {
+    size_t n = length - w * 64 < 64 ? length - w * 64 : 64;
+    unsigned long long m = 0, b = 0;
+    for (size_t i = 0; i < n; i++) {
+      m |= (unsigned long long)class_has(&st->chars, u[w * 64 + i]) << i;
+      b |= (unsigned long long)(u[w * 64 + i] == '\\') << i;
+    }
+    st->bits[w] = m;
+    st->escaped[w] = b;
+  }
+
+  for (w = 0; w * 64 < length; w++) {
+    unsigned long long backslashes = st->escaped[w];
+    if (!backslashes) {
+      st->escaped[w] = (unsigned long long)carry;
+      carry = 0;
+      continue;
+    }
+
+    unsigned long long escapes;
+    size_t last = length - w * 64 < 64 ? length - w * 64 - 1 : 63;
+    st->escaped[w] = structural_escaped(backslashes, carry, &escapes);
+    carry = (int)((escapes >> last) & 1);
+  }
+
+  st->start = start;
+  st->length = length;
+  st->carry = carry;
+}
+
+// Returns the window offset of the first structural character at or after s, or input_length.
+// The block holding the returned character is the one indexed.
+static size_t structural_next_block(grex_parser_t* p, size_t s) {
+  grex_structural_t* st = p->structural;
+
+  while (s < p->input_length) {
+    unsigned long long at = p->stream_offset + s;
+    if (at < st->start || at >= st->start + st->length) {
+      structural_build(p, s);
+    }
+
+    size_t i = (size_t)(at - st->start);
+    size_t words = (st->length + 63) / 64;
+    size_t w = i / 64;
+    unsigned long long bits = st->bits[w] & (~0ULL << (i % 64));
+    while (!bits && ++w < words) {
+      bits = st->bits[w];
+    }
+    if (bits) {
+      return (size_t)(st->start - p->stream_offset) + w * 64 + ctz64(bits);
+    }
+    s = (size_t)(st->start + st->length - p->stream_offset);
+  }
+  return p->input_length;
+}
+
+// Most hops land in the same bitmap word
+static inline size_t structural_next(grex_parser_t* p, size_t s) {
+  const grex_structural_t* st = p->structural;
+  size_t i = (size_t)(p->stream_offset + s - st->start);
+
+  if (i < st->length) {
+    unsigned long long bits = st->bits[i / 64] >> (i % 64);
+    if (bits) {
+      return s + ctz64(bits);
+    }
+  }
+  return structural_next_block(p, s);
+}
+
+// Whether the character at window offset s, in the indexed block, is escaped by a backslash
+static inline int structural_is_escaped(const grex_parser_t* p, size_t s) {
+  const grex_structural_t* st = p->structural;
+  size_t i = (size_t)(p->stream_offset + s - st->start);
+  return (int)((st->escaped[i / 64] >> (i % 64)) & 1);
+}
+
+// Whether every one of the bytes is structural, so a scan for them can walk the index
+static inline int structural_covers(const grex_parser_t* p, const unsigned char* bytes, unsigned count) {
+  if (!p->structural) {
+    return 0;
+  }
+  for (unsigned i = 0; i < count; i++) {
+    if (!class_has(&p->structural->chars, bytes[i])) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+// Same as bytes_scan over [s, input_end), through the structural index
+static const char* structural_scan(grex_parser_t* p, size_t s, const unsigned char* bytes, unsigned count) {
+  while ((s = structural_next(p, s)) < p->input_length) {
+    for (unsigned i = 0; i < count; i++) {
+      if ((unsigned char)p->input[s] == bytes[i]) {
+        return &p->input[s];
+      }
+    }
+    s++;
+  }
+  return p->input_end;
+}
+
+static grex_result_t scan_bytes(grex_parser_t* p, const unsigned char* bytes, unsigned count, grex_span_t* span, grex_primitive_t where) {
+  GREX_EOF_CHECK(p);
+
+  unsigned long long begin = grex_parser_tell(p);
+  size_t s = p->parsing_offset;
+  int indexed = structural_covers(p, bytes, count);
+  const char* stop;
+
+  while ((stop = indexed ? structural_scan(p, s, bytes, count) : bytes_scan(&p->input[s], p->input_end, bytes, count)) == p->input_end) {
+    if (!scan_refill(p, &s, span)) {
+      return stop_at_eof(p);
+    }
+  }
+
+  return scan_done(p, stop, span, begin, where);
+}
+
+static grex_result_t until_any(grex_parser_t* p, const char* set, grex_span_t* span) {
+  size_t count = strlen(set);
+
+  if (count == 0 || count > GREX_UNTIL_ANY_MAX) {
+    grex_class_t cls;
+    grex_class_clear(&cls);
+    grex_class_add_set(&cls, set);
+    return scan_class(p, &cls, 0, span, GREX_PRIMITIVE_UNTIL_ANY);
+  }
+
+  return scan_bytes(p, (const unsigned char*)set, (unsigned)count, span, GREX_PRIMITIVE_UNTIL_ANY);
+}
+
+grex_result_t GREX_IMPL(grex_until)(grex_parser_t* p, unsigned c) {
+  unsigned char byte = (unsigned char)c;
+  return scan_bytes(p, &byte, 1, NULL, GREX_PRIMITIVE_UNTIL);
+}
+
+grex_result_t GREX_IMPL(grex_until_any)(grex_parser_t* p, const char* set) {
+  return until_any(p, set, NULL);
+}
+
+grex_result_t GREX_IMPL(grex_while_class)(grex_parser_t* p, const grex_class_t* cls) {
+  return scan_class(p, cls, 1, NULL, GREX_PRIMITIVE_WHILE_CLASS);
+}
+
+grex_result_t GREX_IMPL(grex_until_class)(grex_parser_t* p, const grex_class_t* cls) {
+  return scan_class(p, cls, 0, NULL, GREX_PRIMITIVE_UNTIL_CLASS);
+}
+
+#if defined(GREX_AVX2)
+static const unsigned char* count_avx2(const unsigned char* s, const unsigned char* end, unsigned char c, size_t* count) {
+  __m256i needle = _mm256_set1_epi8((char)c);
+
+  while (end - s >= 32) {
+    // Matches are counted down from zero in 8-bit lanes, which overflow after 255 blocks
+    __m256i acc = _mm256_setzero_si256();
+    for (int i = 0; i < 255 && end - s >= 32; i++, s += 32) {
+      acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)s), needle));
+    }
+
+    __m256i sums = _mm256_sad_epu8(acc, _mm256_setzero_si256());
+    __m128i half = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+    *count += (size_t)_mm_cvtsi128_si32(half) + (size_t)_mm_cvtsi128_si32(_mm_srli_si128(half, 8));
+  }
+  return s;
+}
+#endif
+
+#if defined(GREX_SSE2)
+static const unsigned char* count_sse2(const unsigned char* s, const unsigned char* end, unsigned char c, size_t* count) {
+  __m128i needle = _mm_set1_epi8((char)c);
+
+  while (end - s >= 16) {
+    __m128i acc = _mm_setzero_si128();
+    for (int i = 0; i < 255 && end - s >= 16; i++, s += 16) {
+      acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)s), needle));
+    }
+
+    __m128i sums = _mm_sad_epu8(acc, _mm_setzero_si128());
+    *count += (size_t)_mm_cvtsi128_si32(sums) + (size_t)_mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+  }
+  return s;
+}
+#endif
+
+// Counts the occurrences of a character in [s, end)
+static size_t count_byte(const char* s, const char* end, unsigned char c) {
+  const unsigned char* u = (const unsigned char*)s;
+  const unsigned char* e = (const unsigned char*)end;
+  size_t count = 0;
+
+#if defined(GREX_AVX2)
+  u = count_avx2(u, e, c, &count);
+#endif
+#if defined(GREX_SSE2)
+  u = count_sse2(u, e, c, &count);
+#endif
+
+  for (; u < e; u++) {
+    count += *u == c;
+  }
+  return count;
+}
+
+// The line index keeps the offset of every GREX_LINE_MARK_STRIDE-th line start, so it takes
+// a fraction of the input's size. Positions between two marks are counted with SIMD.
+#define GREX_LINE_MARK_STRIDE 32
+
+static void line_index_free(grex_parser_t* p) {
+  free(p->line_index.marks);
+  p->line_index.marks = NULL;
+  p->line_index.count = 0;
+  p->line_index.capacity = 0;
+}
+
+// Streaming mode: the first n characters of the window are about to be discarded, so only their
+// line count is kept and the marks, which are window offsets, start over. A parser that doesn't
+// report errors doesn't pay for the count, and its lines start over at the window.
+static void line_index_discard(grex_parser_t* p, size_t n) {
+  grex_line_index_t* index = &p->line_index;
+  index->count = 0;
+  index->indexed = 0;
+  index->lines = 0;
+  if (!reports_errors(p)) {
+    index->base_line = 0;
+    index->base_start = p->stream_offset + n;
+    return;
+  }
+
+  const char* end = p->input + n;
+  size_t lines = count_byte(p->input, end, '\n');
+
+  if (lines > 0) {
+    const char* s = end;
+    while (s[-1] != '\n') {
+      s--;
+    }
+    index->base_start = p->stream_offset + (s - p->input);
+  }
+
+  index->base_line += lines;
+}
+
+// Finds the newlines up to the window offset `to`, adding a mark every GREX_LINE_MARK_STRIDE lines
+static grex_result_t line_index_extend(grex_parser_t* p, size_t to) {
+  grex_line_index_t* index = &p->line_index;
+  const unsigned char newline = '\n';
+  const char* s = p->input + index->indexed;
+  const char* end = p->input + to;
+
+  while ((s = bytes_scan(s, end, &newline, 1)) < end) {
+    s++;
+    if (++index->lines % GREX_LINE_MARK_STRIDE == 0) {
+      if (index->count == index->capacity) {
+        size_t capacity = index->capacity ? index->capacity * 2 : 64;
+        size_t* marks = realloc(index->marks, capacity * sizeof(*marks));
+        if (!marks) {
+          index->lines--;
+          index->indexed = (s - 1) - p->input;
+          return GREX_ALLOC_ERR;
+        }
+        index->marks = marks;
+        index->capacity = capacity;
+      }
+      index->marks[index->count++] = s - p->input;
+    }
+  }
+
+  index->indexed = to;
+  return GREX_OK;
+}
+
+grex_result_t grex_parser_position(grex_parser_t* p, unsigned long long offset, unsigned long long* line, unsigned long long* column) {
+  grex_line_index_t* index = &p->line_index;
+
+  if (offset < p->stream_offset || offset - p->stream_offset > p->input_length) {
+    return GREX_NO_MATCH;
+  }
+
+  size_t o = (size_t)(offset - p->stream_offset);
+  if (o > index->indexed) {
+    grex_result_t result = line_index_extend(p, o);
+    if (result != GREX_OK) {
+      return result;
+    }
+  }
+
+  // Last mark at or before the offset
+  size_t lo = 0, hi = index->count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (index->marks[mid] <= o) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+
+  size_t start = lo ? index->marks[lo - 1] : 0;
+  size_t lines = lo * GREX_LINE_MARK_STRIDE + count_byte(p->input + start, p->input + o, '\n');
+
+  unsigned long long line_start = index->base_start;
+  if (lines > 0) {
+    size_t s = o;
+    while (p->input[s - 1] != '\n') {
+      s--;
+    }
+    line_start = p->stream_offset + s;
+  }
+
+  *line = index->base_line + lines + 1;
+  *column = offset - line_start + 1;
+  return GREX_OK;
+}
+
+// Two-Way reads the needle and the haystack with a stride of +1 or -1, so the same code
+// searches in both directions. TW(x, i, step) is the i-th character in search order.
+#define TW(x, i, step) ((x)[(ptrdiff_t)(i) * (step)])
+
+static size_t critical_factorization(const unsigned char* x, ptrdiff_t step, size_t m, size_t* period) {
+  size_t max_suffix, max_suffix_rev, j, k, per;
+
+  if (m < 3) {
+    *period = 1;
+    return m - 1;
+  }
+
+  // Maximal suffix for the regular order
+  max_suffix = (size_t)-1;
+  j = 0;
+  k = per = 1;
+  while (j + k < m) {
+    unsigned char a = TW(x, j + k, step);
+    unsigned char b = TW(x, max_suffix + k, step);
+    if (a < b) {
+      j += k;
+      k = 1;
+      per = j - max_suffix;
+    }
+    else if (a == b) {
+      if (k != per) {
+        k++;
+      }
+      else {
+        j += per;
+        k = 1;
+      }
+    }
+    else {
+      max_suffix = j++;
+      k = per = 1;
+    }
+  }
+  *period = per;
+
+  // Maximal suffix for the reversed order
+  max_suffix_rev = (size_t)-1;
+  j = 0;
+  k = per = 1;
+  while (j + k < m) {
+    unsigned char a = TW(x, j + k, step);
+    unsigned char b = TW(x, max_suffix_rev + k, step);
+    if (b < a) {
+      j += k;
+      k = 1;
+      per = j - max_suffix_rev;
+    }
+    else if (a == b) {
+      if (k != per) {
+        k++;
+      }
+      else {
+        j += per;
+        k = 1;
+      }
+    }
+    else {
+      max_suffix_rev = j++;
+      k = per = 1;
+    }
+  }
+
+  if (max_suffix_rev + 1 < max_suffix + 1) {
+    return max_suffix + 1;
+  }
+  *period = per;
+  return max_suffix_rev + 1;
+}
+
+static void needle_factorize(const unsigned char* x, ptrdiff_t step, size_t m, size_t* suffix, size_t* period, int* periodic) {
+  *suffix = critical_factorization(x, step, m, period);
+
+  size_t i = 0;
+  while (i < *suffix && TW(x, i, step) == TW(x, i + *period, step)) {
+    i++;
+  }
+
+  *periodic = (i == *suffix);
+  if (!*periodic) {
+    *period = (*suffix > m - *suffix ? *suffix : m - *suffix) + 1;
+  }
+}
+
+// Returns the position of the first occurrence of the needle in the first `length`
+// characters of y, in search order, or (size_t)-1
+static size_t two_way(const unsigned char* x, const unsigned char* y, ptrdiff_t step, size_t m, size_t length,
+                      size_t suffix, size_t period, int periodic) {
+  size_t i, j = 0;
+
+  if (periodic) {
+    size_t memory = 0;
+    while (j + m <= length) {
+      i = suffix > memory ? suffix : memory;
+      while (i < m && TW(x, i, step) == TW(y, i + j, step)) {
+        i++;
+      }
+      if (i >= m) {
+        i = suffix - 1;
+        while (memory < i + 1 && TW(x, i, step) == TW(y, i + j, step)) {
+          i--;
+        }
+        if (i + 1 < memory + 1) {
+          return j;
+        }
+        j += period;
+        memory = m - period;
+      }
+      else {
+        j += i - suffix + 1;
+        memory = 0;
+      }
+    }
+  }
+  else {
+    while (j + m <= length) {
+      i = suffix;
+      while (i < m && TW(x, i, step) == TW(y, i + j, step)) {
+        i++;
+      }
+      if (i >= m) {
+        i = suffix - 1;
+        while (i != (size_t)-1 && TW(x, i, step) == TW(y, i + j, step)) {
+          i--;
+        }
+        if (i == (size_t)-1) {
+          return j;
+        }
+        j += period;
+      }
+      else {
+        j += i - suffix + 1;
+      }
+    }
+  }
+
+  return (size_t)-1;
+}
+
+void grex_needle_init_length(grex_needle_t* n, const char* seq, size_t length) {
+  const unsigned char* x = (const unsigned char*)seq;
+
+  n->seq = seq;
+  n->length = length;
+
+  if (length == 0) {
+    n->suffix = n->reverse_suffix = 0;
+    n->period = n->reverse_period = 1;
+    n->periodic = n->reverse_periodic = 1;
+    return;
+  }
+
+  needle_factorize(x, 1, length, &n->suffix, &n->period, &n->periodic);
+  needle_factorize(x + length - 1, -1, length, &n->reverse_suffix, &n->reverse_period, &n->reverse_periodic);
+}
+
+void grex_needle_init(grex_needle_t* n, const char* seq) {
+  grex_needle_init_length(n, seq, strlen(seq));
+}
+
+// Candidates that pass the first/last character filter are verified with memcmp. Each verification
+// spends `m` from a budget that grows with the bytes skipped; when it runs out the input is
+// pathological for the filter and Two-Way takes over.
+#define NEEDLE_BUDGET 4096
+
+static inline int needle_verify(const unsigned char* x, size_t m, const unsigned char* s) {
+  return m <= 2 || memcmp(s + 1, x + 1, m - 2) == 0;
+}
+
+enum { FILTER_DONE, FILTER_FOUND, FILTER_EXHAUSTED };
+
+#if defined(GREX_SSE2)
+// Tests starts [*pos, *pos + count) 16 at a time, leaving *pos on a match, on the candidate
+// that exhausted the budget, or on the first start it did not test
+static int needle_filter_sse2(const unsigned char* x, size_t m, const unsigned char** pos, size_t count, size_t* budget) {
+  const unsigned char* s = *pos;
+  const unsigned char* end = s + count;
+  __m128i first = _mm_set1_epi8((char)x[0]);
+  __m128i last = _mm_set1_epi8((char)x[m - 1]);
+
+  while (end - s >= 16) {
+    __m128i a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)s), first);
+    __m128i b = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(s + m - 1)), last);
+    unsigned mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(a, b));
+
+    while (mask) {
+      const unsigned char* candidate = s + ctz32(mask);
+      if (needle_verify(x, m, candidate)) {
+        *pos = candidate;
+        return FILTER_FOUND;
+      }
+      if (*budget < m) {
+        *pos = candidate;
+        return FILTER_EXHAUSTED;
+      }
+      *budget -= m;
+      mask &= mask - 1;
+    }
+
+    *budget += 16;
+    s += 16;
+  }
+
+  *pos = s;
+  return FILTER_DONE;
+}
+
+// Same as needle_filter_sse2, but tests the starts [base, base + *count) from the last one
+// down, leaving *count as the number of starts below *pos it did not test
+static int needle_filter_reverse_sse2(const unsigned char* x, size_t m, const unsigned char* base, size_t* count, const unsigned char** pos, size_t* budget) {
+  __m128i first = _mm_set1_epi8((char)x[0]);
+  __m128i last = _mm_set1_epi8((char)x[m - 1]);
+
+  while (*count >= 16) {
+    const unsigned char* s = base + *count - 16;
+    __m128i a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)s), first);
+    __m128i b = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(s + m - 1)), last);
+    unsigned mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(a, b));
+
+    while (mask) {
+      int i = 31 - clz32(mask);
+      if (needle_verify(x, m, s + i)) {
+        *pos = s + i;
+        return FILTER_FOUND;
+      }
+      if (*budget < m) {
+        *count = (s - base) + i + 1;
+        return FILTER_EXHAUSTED;
+      }
+      *budget -= m;
+      mask &= ~(1u << i);
+    }
+
+    *budget += 16;
+    *count -= 16;
+  }
+
+  return FILTER_DONE;
+}
+#endif
+
+// Returns the first occurrence of the needle in [s, end), or NULL
+static const char* needle_find(const grex_needle_t* n, const char* s, const char* end) {
+  const unsigned char* x = (const unsigned char*)n->seq;
+  size_t m = n->length;
+
+  if (m == 0) {
+    return s;
+  }
+  if ((size_t)(end - s) < m) {
+    return NULL;
+  }
+  if (m == 1) {
+    const char* hit = bytes_scan(s, end, x, 1);
+    return hit == end ? NULL : hit;
+  }
+
+  const unsigned char* u = (const unsigned char*)s;
+  const unsigned char* e = (const unsigned char*)end;
+  size_t budget = NEEDLE_BUDGET;
+
+#if defined(GREX_SSE2)
+  // Loading the last character of each start needs m - 1 bytes past the block
+  int status = needle_filter_sse2(x, m, &u, (size_t)(e - u) - m + 1, &budget);
+  if (status == FILTER_FOUND) {
+    return (const char*)u;
+  }
+  if (status == FILTER_EXHAUSTED) {
+    goto two_way_search;
+  }
+#endif
+
+  for (; (size_t)(e - u) >= m; u++) {
+    if (u[0] == x[0] && u[m - 1] == x[m - 1]) {
+      if (needle_verify(x, m, u)) {
+        return (const char*)u;
+      }
+      if (budget < m) {
+        goto two_way_search;
+      }
+      budget -= m;
+    }
+    budget++;
+  }
+  return NULL;
+
+two_way_search:;
+  size_t j = two_way(x, u, 1, m, e - u, n->suffix, n->period, n->periodic);
+  return j == (size_t)-1 ? NULL : (const char*)u + j;
+}
+
+// Returns the last occurrence of the needle that lies entirely in [s, end), or NULL
+static const char* needle_find_reverse(const grex_needle_t* n, const char* s, const char* end) {
+  const unsigned char* x = (const unsigned char*)n->seq;
+  const unsigned char* u = (const unsigned char*)s;
+  size_t m = n->length;
+
+  if (m == 0) {
+    return end;
+  }
+  if ((size_t)(end - s) < m) {
+    return NULL;
+  }
+
+  // Starts [0, count) relative to s are still to be tested, from the last one down
+  size_t count = (size_t)(end - s) - m + 1;
+  size_t budget = NEEDLE_BUDGET;
+
+#if defined(GREX_SSE2)
+  const unsigned char* hit = NULL;
+  int status = needle_filter_reverse_sse2(x, m, u, &count, &hit, &budget);
+  if (status == FILTER_FOUND) {
+    return (const char*)hit;
+  }
+  if (status == FILTER_EXHAUSTED) {
+    goto two_way_search;
+  }
+#endif
+
+  while (count > 0) {
+    const unsigned char* candidate = u + count - 1;
+    if (candidate[0] == x[0] && candidate[m - 1] == x[m - 1]) {
+      if (needle_verify(x, m, candidate)) {
+        return (const char*)candidate;
+      }
+      if (budget < m) {
+        goto two_way_search;
+      }
+      budget -= m;
+    }
+    budget++;
+    count--;
+  }
+  return NULL;
+
+two_way_search:;
+  // Search the reversed needle in the reversed haystack that holds the remaining starts
+  size_t length = count - 1 + m;
+  size_t j = two_way(x + m - 1, u + length - 1, -1, m, length,
+                     n->reverse_suffix, n->reverse_period, n->reverse_periodic);
+  return j == (size_t)-1 ? NULL : (const char*)u + (count - 1 - j);
+}
+
+grex_result_t GREX_IMPL(grex_sequence_needle)(grex_parser_t* p, const grex_needle_t* n) {
+  GREX_EOF_CHECK(p);
+
+  if (!ensure(p, n->length) ||
+      memcmp(&p->input[p->parsing_offset], n->seq, n->length)) {
+    report_error(p, GREX_PRIMITIVE_SEQUENCE_NEEDLE);
+    return GREX_NO_MATCH;
+  }
+
+  p->parsing_offset += n->length;
+  return GREX_OK;
+}
+
+static grex_result_t while_needle(grex_parser_t* p, const grex_needle_t* n, grex_primitive_t where) {
+  GREX_EOF_CHECK(p);
+
+  size_t m = n->length;
+  unsigned long long begin = grex_parser_tell(p);
+
+  if (m == 0) {
+    return GREX_OK;
+  }
+
+  while (ensure(p, m) && memcmp(&p->input[p->parsing_offset], n->seq, m) == 0) {
+    p->parsing_offset += m;
+  }
+
+  if (p->parsing_offset >= p->input_length) {
+    return GREX_EOF;
+  }
+  if (grex_parser_tell(p) > begin) {
+    return GREX_OK;
+  }
+
+  report_error(p, where);
+  return GREX_NO_MATCH;
+}
+
+static grex_result_t while_needle_reverse(grex_parser_t* p, const grex_needle_t* n, grex_primitive_t where) {
+  GREX_REVERSE_EOF_CHECK(p);
+
+  size_t m = n->length;
+  const char* begin = &p->input[p->parsing_offset];
+  const char* s = begin;
+
+  if (m == 0) {
+    return GREX_OK;
+  }
+
+  while ((size_t)(s - p->input) >= m && memcmp(s - m, n->seq, m) == 0) {
+    s -= m;
+  }
+
+  p->parsing_offset = s - p->input;
+  if (s < begin) {
+    return GREX_OK;
+  }
+
+  report_error(p, where);
+  return GREX_NO_MATCH;
+}
+
+grex_result_t GREX_IMPL(grex_while_needle)(grex_parser_t* p, const grex_needle_t* n) {
+  return while_needle(p, n, GREX_PRIMITIVE_WHILE_NEEDLE);
+}
+
+grex_result_t GREX_IMPL(grex_while_needle_reverse)(grex_parser_t* p, const grex_needle_t* n) {
+  return while_needle_reverse(p, n, GREX_PRIMITIVE_WHILE_NEEDLE_REVERSE);
+}
+
+grex_result_t GREX_IMPL(grex_until_needle)(grex_parser_t* p, const grex_needle_t* n) {
+  GREX_EOF_CHECK(p);
+
+  const char* hit;
+  size_t s = p->parsing_offset;
+
+  while (!(hit = needle_find(n, &p->input[s], p->input_end))) {
+    // Keep the last length - 1 characters, a match may start in them and end in the new input
+    if (p->input_length - s >= n->length) {
+      s = p->input_length - n->length + 1;
+      p->parsing_offset = s;
+    }
+    if (!refill(p, &s)) {
+      return stop_at_eof(p);
+    }
+  }
+
+  p->parsing_offset = (hit - p->input) + n->length;
+  return GREX_OK;
+}
+
+grex_result_t GREX_IMPL(grex_until_needle_reverse)(grex_parser_t* p, const grex_needle_t* n) {
+  GREX_REVERSE_EOF_CHECK(p);
+
+  const char* hit = needle_find_reverse(n, p->input, &p->input[p->parsing_offset]);
+  if (!hit) {
+    p->parsing_offset = 0;
+    return GREX_EOF;
+  }
+
+  p->parsing_offset = hit - p->input;
+  return GREX_OK;
+}
+
+grex_result_t GREX_IMPL(grex_while_sequence)(grex_parser_t* p, const char* seq) {
+  // Repeated matching never searches, so the needle does not need its factorization
+  grex_needle_t n;
+  n.seq = seq;
+  n.length = strlen(seq);
+  return while_needle(p, &n, GREX_PRIMITIVE_WHILE_SEQUENCE);
+}
+
+grex_result_t GREX_IMPL(grex_while_sequence_reverse)(grex_parser_t* p, const char* seq) {
+  grex_needle_t n;
+  n.seq = seq;
+  n.length = strlen(seq);
+  return while_needle_reverse(p, &n, GREX_PRIMITIVE_WHILE_SEQUENCE_REVERSE);
+}
+
+grex_result_t GREX_IMPL(grex_until_sequence)(grex_parser_t* p, const char* seq) {
+  grex_needle_t n;
+  grex_needle_init(&n, seq);
+  return grex_until_needle(p, &n);
+}
+
+grex_result_t GREX_IMPL(grex_until_sequence_reverse)(grex_parser_t* p, const char* seq) {
+  grex_needle_t n;
+  grex_needle_init(&n, seq);
+  return grex_until_needle_reverse(p, &n);
+}
+
+// Marks a state without output, and a transition not in the trie while the automaton is built
+#define SEQUENCES_NONE ((unsigned)-1)
+
+// Builds the trie of the sequences (read backwards for the reverse automaton), then fills in every
+// missing transition with the one of the failure state, so searching is one table lookup per character.
+static grex_result_t automaton_build(grex_automaton_t* a, const grex_sequences_t* set, int reverse) {
+  size_t states = 1;
+  for (unsigned i = 0; i < set->count; i++) {
+    states += set->lengths[i];
+  }
+
+  size_t alphabet = set->alphabet_size;
+
+  // next, depth, output and output_link share one allocation
+  unsigned* block = malloc((states * alphabet + states * 3) * sizeof(*block));
+  unsigned* fail = malloc(states * 2 * sizeof(*fail));
+  if (!block || !fail) {
+    free(block);
+    free(fail);
+    return GREX_ALLOC_ERR;
+  }
+  a->next = block;
+  a->depth = block + states * alphabet;
+  a->output = a->depth + states;
+  a->output_link = a->output + states;
+
+  unsigned* queue = fail + states;
+  unsigned* next = a->next;
+
+  memset(next, 0xff, states * alphabet * sizeof(*next));
+  a->depth[0] = 0;
+  a->output[0] = SEQUENCES_NONE;
+  a->output_link[0] = 0;
+  a->state_count = 1;
+
+  for (unsigned i = 0; i < set->count; i++) {
+    const unsigned char* seq = (const unsigned char*)set->seqs[i];
+    unsigned length = set->lengths[i];
+    unsigned state = 0;
+
+    for (unsigned j = 0; j < length; j++) {
+      unsigned char c = reverse ? seq[length - 1 - j] : seq[j];
+      unsigned* slot = &next[state * alphabet + set->byte_class[c]];
+      if (*slot == SEQUENCES_NONE) {
+        *slot = a->state_count;
+        a->depth[a->state_count] = j + 1;
+        a->output[a->state_count] = SEQUENCES_NONE;
+        a->state_count++;
+      }
+      state = *slot;
+    }
+
+    // Duplicates keep their first position in the list
+    if (a->output[state] == SEQUENCES_NONE) {
+      a->output[state] = i;
+    }
+  }
+
+  // Breadth first, so the failure state of every state is complete before its own transitions are filled in
+  size_t head = 0, tail = 0;
+  for (size_t c = 0; c < alphabet; c++) {
+    unsigned v = next[c];
+    if (v == SEQUENCES_NONE) {
+      next[c] = 0;
+    }
+    else {
+      fail[v] = 0;
+      a->output_link[v] = 0;
+      queue[tail++] = v;
+    }
+  }
+
+  while (head < tail) {
+    unsigned u = queue[head++];
+    for (size_t c = 0; c < alphabet; c++) {
+      unsigned v = next[u * alphabet + c];
+      unsigned f = next[fail[u] * alphabet + c];
+      if (v == SEQUENCES_NONE) {
+        next[u * alphabet + c] = f;
+      }
+      else {
+        fail[v] = f;
+        a->output_link[v] = a->output[f] != SEQUENCES_NONE ? f : a->output_link[f];
+        queue[tail++] = v;
+      }
+    }
+  }
+
+  free(fail);
+  return GREX_OK;
+}
+
+grex_result_t grex_sequences_init(grex_sequences_t* set, const char* const* seqs, unsigned count) {
+  memset(set, 0, sizeof(*set));
+
+  // seqs and lengths share one allocation
+  char* block = malloc((count ? count : 1) * (sizeof(*set->seqs) + sizeof(*set->lengths)));
+  if (!block) {
+    return GREX_ALLOC_ERR;
+  }
+  set->seqs = (const char**)block;
+  set->lengths = (unsigned*)(set->seqs + count);
+  set->count = count;
+
+  for (unsigned i = 0; i < count; i++) {
+    set->seqs[i] = seqs[i];
+    set->lengths[i] = (unsigned)strlen(seqs[i]);
+    if (set->lengths[i] == 0) {
+      grex_sequences_destroy(set);
+      return GREX_NO_MATCH;
+    }
+
+    const unsigned char* seq = (const unsigned char*)seqs[i];
+    for (unsigned j = 0; j < set->lengths[i]; j++) {
+      set->byte_class[seq[j]] = 1;
+    }
+    grex_class_add_range(&set->first, seq[0], seq[0]);
+    grex_class_add_range(&set->last, seq[set->lengths[i] - 1], seq[set->lengths[i] - 1]);
+  }
+
+  // Column 0 is every byte that appears in no sequence
+  set->alphabet_size = 1;
+  for (unsigned c = 0; c < 256; c++) {
+    if (set->byte_class[c]) {
+      set->byte_class[c] = (unsigned char)set->alphabet_size++;
+    }
+  }
+
+  // A few first bytes are found faster with the grex_until_any kernel than with the class kernel
+  unsigned first_count = 0;
+  for (unsigned c = 0; c < 256 && first_count <= GREX_UNTIL_ANY_MAX; c++) {
+    if (class_has(&set->first, (unsigned char)c)) {
+      if (first_count < GREX_UNTIL_ANY_MAX) {
+        set->first_bytes[first_count] = (unsigned char)c;
+      }
+      first_count++;
+    }
+  }
+  set->first_count = first_count <= GREX_UNTIL_ANY_MAX ? first_count : 0;
+
+  if (automaton_build(&set->forward, set, 0) != GREX_OK || automaton_build(&set->reverse, set, 1) != GREX_OK) {
+    grex_sequences_destroy(set);
+    return GREX_ALLOC_ERR;
+  }
+  return GREX_OK;
+}
+
+void grex_sequences_destroy(grex_sequences_t* set) {
+  free((void*)set->seqs);
+  free(set->forward.next);
+  free(set->reverse.next);
+  memset(set, 0, sizeof(*set));
+}
+
+// Returns the first character in [s, end) that can start a sequence of the set, or end
+static const char* sequences_skip(const grex_sequences_t* set, const char* s, const char* end) {
+  if (set->first_count) {
+    return bytes_scan(s, end, set->first_bytes, set->first_count);
+  }
+  return class_scan(&set->first, s, end, 0);
+}
+
+grex_result_t GREX_IMPL(grex_until_any_sequence)(grex_parser_t* p, const grex_sequences_t* set, unsigned* index) {
+  GREX_EOF_CHECK(p);
+
+  const grex_automaton_t* a = &set->forward;
+  unsigned state = 0;
+  unsigned best = SEQUENCES_NONE;
+  unsigned long long best_start = 0, best_end = 0;
+  size_t s = p->parsing_offset;
+
+  for (;;) {
+    const unsigned char* u = (const unsigned char*)&p->input[s];
+    const unsigned char* e = (const unsigned char*)p->input_end;
+
+    while (u < e) {
+      // Nothing is partially matched, so skip to the next character that can start a sequence
+      if (state == 0) {
+        u = (const unsigned char*)sequences_skip(set, (const char*)u, (const char*)e);
+        if (u == e) {
+          break;
+        }
+      }
+
+      state = a->next[state * set->alphabet_size + set->byte_class[*u++]];
+      unsigned long long pos = p->stream_offset + (u - (const unsigned char*)p->input);
+
+      // The first state with output on the chain is the longest sequence ending here, so it starts first
+      unsigned t = a->output[state] != SEQUENCES_NONE ? state : a->output_link[state];
+      if (t && (best == SEQUENCES_NONE || pos - a->depth[t] <= best_start)) {
+        best = a->output[t];
+        best_start = pos - a->depth[t];
+        best_end = pos;
+      }
+
+      // A later match can't start before the partial match of the current state
+      if (best != SEQUENCES_NONE && pos - a->depth[state] > best_start) {
+        *index = best;
+        p->parsing_offset = (size_t)(best_end - p->stream_offset);
+        return GREX_OK;
+      }
+    }
+
+    // The automaton state carries the partial match, so only the end of the best match must be kept
+    p->parsing_offset = best != SEQUENCES_NONE ? (size_t)(best_end - p->stream_offset) : p->input_length;
+    s = p->input_length;
+    if (!refill(p, &s)) {
+      if (best != SEQUENCES_NONE) {
+        *index = best;
+        p->parsing_offset = (size_t)(best_end - p->stream_offset);
+        return GREX_OK;
+      }
+      return stop_at_eof(p);
+    }
+  }
+}
+
+grex_result_t GREX_IMPL(grex_until_any_sequence_reverse)(grex_parser_t* p, const grex_sequences_t* set, unsigned* index) {
+  GREX_REVERSE_EOF_CHECK(p);
+
+  const grex_automaton_t* a = &set->reverse;
+  const unsigned char* input = (const unsigned char*)p->input;
+  unsigned state = 0;
+  size_t s = p->parsing_offset;
+
+  while (s > 0) {
+    // Nothing is partially matched, so skip back to the next character that can end a sequence
+    if (state == 0) {
+      while (s > 0 && !class_has(&set->last, input[s - 1])) {
+        s--;
+      }
+      if (s == 0) {
+        break;
+      }
+    }
+
+    state = a->next[state * set->alphabet_size + set->byte_class[input[--s]]];
+
+    // Sequences are read backwards, so the first output is the longest sequence starting here
+    unsigned t = a->output[state] != SEQUENCES_NONE ? state : a->output_link[state];
+    if (t) {
+      *index = a->output[t];
+      p->parsing_offset = s;
+      return GREX_OK;
+    }
+  }
+
+  p->parsing_offset = 0;
+  return GREX_EOF;
+}
+
+typedef struct keyword_entry {
+  const char* word;
+  unsigned length;
+  unsigned index;
+} keyword_entry_t;
+
+// Orders by bytes, then shorter first, then by position in the list
+static int compare_keywords(const void* a, const void* b) {
+  const keyword_entry_t* x = a;
+  const keyword_entry_t* y = b;
+  int cmp = memcmp(x->word, y->word, x->length < y->length ? x->length : y->length);
+
+  if (cmp) {
+    return cmp;
+  }
+  if (x->length != y->length) {
+    return x->length < y->length ? -1 : 1;
+  }
+  return x->index < y->index ? -1 : x->index > y->index;
+}
+
+grex_result_t grex_keywords_init(grex_keywords_t* kw, const char* const* words, unsigned count, unsigned flags) {
+  memset(kw, 0, sizeof(*kw));
+  kw->flags = flags;
+
+  keyword_entry_t* entries = malloc((count ? count : 1) * sizeof(*entries));
+  if (!entries) {
+    return GREX_ALLOC_ERR;
+  }
+
+  for (unsigned i = 0; i < count; i++) {
+    entries[i].word = words[i];
+    entries[i].length = (unsigned)strlen(words[i]);
+    entries[i].index = i;
+    if (entries[i].length == 0) {
+      free(entries);
+      return GREX_NO_MATCH;
+    }
+  }
+  qsort(entries, count, sizeof(*entries), compare_keywords);
+
+  // words, lengths and indices share one allocation
+  char* block = malloc((count ? count : 1) * (sizeof(*kw->words) + sizeof(*kw->lengths) + sizeof(*kw->indices)));
+  if (!block) {
+    free(entries);
+    return GREX_ALLOC_ERR;
+  }
+  kw->words = (const char**)block;
+  kw->lengths = (unsigned*)(kw->words + count);
+  kw->indices = kw->lengths + count;
+
+  // Duplicates keep their first position in the list
+  unsigned n = 0;
+  for (unsigned i = 0; i < count; i++) {
+    if (n > 0 && entries[i].length == kw->lengths[n - 1] && memcmp(entries[i].word, kw->words[n - 1], entries[i].length) == 0) {
+      continue;
+    }
+    kw->words[n] = entries[i].word;
+    kw->lengths[n] = entries[i].length;
+    kw->indices[n] = entries[i].index;
+    if (entries[i].length > kw->max_length) {
+      kw->max_length = entries[i].length;
+    }
+    n++;
+  }
+  kw->count = n;
+  free(entries);
+
+  // root[c] .. root[c + 1] are the keywords starting with c
+  unsigned k = 0;
+  for (unsigned c = 0; c < 256; c++) {
+    kw->root[c] = k;
+    while (k < n && (unsigned char)kw->words[k][0] == c) {
+      k++;
+    }
+  }
+  kw->root[256] = n;
+  return GREX_OK;
+}
+
+void grex_keywords_destroy(grex_keywords_t* kw) {
+  free((void*)kw->words);
+  memset(kw, 0, sizeof(*kw));
+}
+
+// First keyword in [lo, hi) whose character at depth is above c, all of them are longer than depth
+static unsigned keywords_upper_bound(const grex_keywords_t* kw, unsigned lo, unsigned hi, size_t depth, unsigned char c) {
+  while (lo < hi) {
+    unsigned mid = lo + (hi - lo) / 2;
+    if ((unsigned char)kw->words[mid][depth] <= c) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+grex_result_t GREX_IMPL(grex_keyword)(grex_parser_t* p, const grex_keywords_t* kw, unsigned* index) {
+  GREX_EOF_CHECK(p);
+
+  // The whole-word check looks at one more character
+  ensure(p, kw->max_length + 1);
+
+  const unsigned char* s = (const unsigned char*)&p->input[p->parsing_offset];
+  size_t available = p->input_length - p->parsing_offset;
+  unsigned lo = kw->root[s[0]], hi = kw->root[s[0] + 1];
+  unsigned best = kw->count;
+  size_t best_length = 0;
+
+  // Every keyword in [lo, hi) starts with the depth characters read so far
+  for (size_t depth = 1; lo < hi; depth++) {
+    // The keyword that ends here sorts first
+    if (kw->lengths[lo] == depth) {
+      int whole = !(kw->flags & GREX_KEYWORDS_WHOLE_WORD) || depth == available || !class_has(&identifier_class, s[depth]);
+      if (whole && (best == kw->count || !(kw->flags & GREX_KEYWORDS_FIRST) || kw->indices[lo] < kw->indices[best])) {
+        best = lo;
+        best_length = depth;
+      }
+      lo++;
+    }
+
+    if (lo == hi || depth == available) {
+      break;
+    }
+
+    lo = s[depth] ? keywords_upper_bound(kw, lo, hi, depth, s[depth] - 1) : lo;
+    hi = keywords_upper_bound(kw, lo, hi, depth, s[depth]);
+  }
+
+  if (best == kw->count) {
+    report_error(p, GREX_PRIMITIVE_KEYWORD);
+    return GREX_NO_MATCH;
+  }
+
+  *index = kw->indices[best];
+  p->parsing_offset += best_length;
+  return GREX_OK;
+}
+
+// Value of each character as a digit in bases up to 36, or 255
+static const unsigned char digit_values[256] = {
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 255, 255, 255, 255, 255, 255,
+  255, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24,
+  25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 255, 255, 255, 255, 255,
+  255, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24,
+  25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+};
+
+static inline unsigned long long load_le64(const char* s) {
+  unsigned long long v;
+  memcpy(&v, s, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap64(v);
+#endif
+  return v;
+}
+
+// SWAR count of the ASCII digits at the start of 8 bytes
+static inline int leading_digits(unsigned long long v) {
+  // Non-zero in every byte that is not a digit. The +6 can carry into the next byte, but only
+  // out of a byte that is not a digit, so the first non-digit byte is still found.
+  unsigned long long x = ((v & 0xF0F0F0F0F0F0F0F0ULL) |
+                          (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ^ 0x3333333333333333ULL;
+  return x ? ctz64(x) >> 3 : 8;
+}
+
+// SWAR conversion of 8 ASCII digits, the first one being the most significant
+static inline unsigned long long eight_digits_value(unsigned long long v) {
+  v -= 0x3030303030303030ULL;
+  v = (v * 10) + (v >> 8);
+  v = (((v & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+       (((v >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+  return v;
+}
+
+static inline int is_c_space(int c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// [0-9A-Za-z_.+()-], every character a number can hold after its leading whitespace
+static const grex_class_t number_class = {
+  { 0x03FF6B0000000000ULL, 0x07FFFFFE87FFFFFEULL, 0, 0 }, 7,
+  { { '(', ')' }, { '+', '+' }, { '-', '.' }, { '0', '9' }, { 'A', 'Z' }, { '_', '_' }, { 'a', 'z' } }
+};
+
+// Streaming mode: reads until the window holds the whole number at the head and the character after it.
+// The number parsers never look further than that, so they see the same input as with the whole file in memory.
+static void load_number(grex_parser_t* p) {
+  size_t s = p->parsing_offset;
+  int leading = 1;
+
+  while (p->read_callback) {
+    for (; s < p->input_length; s++) {
+      int c = (unsigned char)p->input[s];
+      if (leading && is_c_space(c)) {
+        continue;
+      }
+      if (!class_has(&number_class, c)) {
+        return;
+      }
+      leading = 0;
+    }
+    if (!refill(p, &s)) {
+      return;
+    }
+  }
+}
+
+// Parses an integer with the same grammar as strtoull, never reading past `end` and independent
+// of the locale. Base 0 detects the 0x, 0b and 0 prefixes. Returns the end of the number, which is
+// `s` when there is no number. *overflow is set when the magnitude does not fit in 64 bits.
+static const char* parse_integer(const char* s, const char* end, int base,
+                                 unsigned long long* magnitude, int* negative, int* overflow) {
+  const char* start = s;
+  unsigned long long v = 0;
+
+  *magnitude = 0;
+  *negative = 0;
+  *overflow = 0;
+
+  if (base < 0 || base == 1 || base > 36) {
+    return start;
+  }
+
+  while (s < end && is_c_space(*s)) {
+    s++;
+  }
+
+  if (s < end && (*s == '+' || *s == '-')) {
+    *negative = (*s == '-');
+    s++;
+  }
+
+  // A prefix only counts when a valid digit follows it
+  if (end - s >= 3 && s[0] == '0') {
+    int x = (s[1] | 0x20) == 'x';
+    int b = (s[1] | 0x20) == 'b';
+    if (x && (base == 0 || base == 16) && digit_values[(unsigned char)s[2]] < 16) {
+      base = 16;
+      s += 2;
+    }
+    else if (b && (base == 0 || base == 2) && digit_values[(unsigned char)s[2]] < 2) {
+      base = 2;
+      s += 2;
+    }
+  }
+  if (base == 0) {
+    base = (s < end && s[0] == '0') ? 8 : 10;
+  }
+
+  const char* digits = s;
+
+  if (base == 10) {
+    static const unsigned long long powers[9] = {
+      1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000
+    };
+
+    // Up to 19 decimal digits always fit in 64 bits. Runs shorter than 8 digits are
+    // padded with leading zeros, so they also take a single SWAR conversion.
+    while (end - s >= 8 && s - digits <= 11) {
+      unsigned long long chunk = load_le64(s);
+      int n = leading_digits(chunk);
+      if (n == 0) {
+        break;
+      }
+      if (n < 8) {
+        chunk = (chunk << (8 * (8 - n))) | (0x3030303030303030ULL >> (8 * n));
+      }
+      v = v * powers[n] + eight_digits_value(chunk);
+      s += n;
+      if (n < 8) {
+        break;
+      }
+    }
+    while (s < end && (unsigned)(*s - '0') < 10 && s - digits < 19) {
+      v = v * 10 + (*s - '0');
+      s++;
+    }
+  }
+
+  for (; s < end; s++) {
+    unsigned d = digit_values[(unsigned char)*s];
+    if (d >= (unsigned)base) {
+      break;
+    }
+    // Below 2^58 another digit cannot overflow for any base, so the exact check is rare
+    if ((v >> 58) && (v > (~0ULL - d) / base)) {
+      *overflow = 1;
+    }
+    else {
+      v = v * base + d;
+    }
+  }
+
+  if (s == digits) {
+    return start;
+  }
+
+  *magnitude = v;
+  return s;
+}
+
+// An integer followed by a '.' and a digit is the start of a decimal number
+static inline int followed_by_fraction(const char* s, const char* end) {
+  return end - s >= 2 && s[0] == '.' && (unsigned)(s[1] - '0') < 10;
+}
+
+grex_result_t GREX_IMPL(grex_integer)(grex_parser_t* p, int base, long long *value) {
+  GREX_EOF_CHECK(p);
+  load_number(p);
+
+  const char* str = &p->input[p->parsing_offset];
+  unsigned long long magnitude;
+  int negative, overflow;
+  const char* endptr = parse_integer(str, p->input_end, base, &magnitude, &negative, &overflow);
+
+  if (endptr > str) {
+    if (followed_by_fraction(endptr, p->input_end)) {
+      return GREX_NO_MATCH;
+    }
+
+    // Out of range values are clamped like strtoll does
+    unsigned long long max = negative ? (1ULL << 63) : (1ULL << 63) - 1;
+    if (overflow || magnitude > max) {
+      overflow = 1;
+      magnitude = max;
+    }
+
+    *value = negative ? (magnitude ? -(long long)(magnitude - 1) - 1 : 0) : (long long)magnitude;
+    p->parsing_offset = endptr - p->input;
+    if (overflow) {
+      return GREX_RANGE_ERR;
+    }
+    return GREX_OK;
+  }
+
+  report_error(p, GREX_PRIMITIVE_INTEGER);
+  return GREX_NO_MATCH;
+}
+
+grex_result_t GREX_IMPL(grex_uinteger)(grex_parser_t* p, int base, unsigned long long* value) {
+  GREX_EOF_CHECK(p);
+  load_number(p);
+
+  const char* str = &p->input[p->parsing_offset];
+  unsigned long long magnitude;
+  int negative, overflow;
+  const char* endptr = parse_integer(str, p->input_end, base, &magnitude, &negative, &overflow);
+
+  if (endptr > str) {
+    if (followed_by_fraction(endptr, p->input_end)) {
+      return GREX_NO_MATCH;
+    }
+
+    // Like strtoull, a minus sign negates the value and out of range values are clamped
+    if (overflow) {
+      *value = ~0ULL;
+    }
+    else {
+      *value = negative ? 0 - magnitude : magnitude;
+    }
+
+    p->parsing_offset = endptr - p->input;
+    if (overflow) {
+      return GREX_RANGE_ERR;
+    }
+    return GREX_OK;
+  }
+
+  report_error(p, GREX_PRIMITIVE_UINTEGER);
+  return GREX_NO_MATCH;
+}
+
+// 128-bit approximations of the powers of five from 5^-342 to 5^308, normalized so the
+// most significant bit is set, for the Eisel-Lemire float conversion
+static const unsigned long long powers_of_five[651 * 2] = {
+  0xEEF453D6923BD65AULL, 0x113FAA2906A13B3FULL,
+  0x9558B4661B6565F8ULL, 0x4AC7CA59A424C507ULL,
+  0xBAAEE17FA23EBF76ULL, 0x5D79BCF00D2DF649ULL,
+  0xE95A99DF8ACE6F53ULL, 0xF4D82C2C107973DCULL,
+  0x91D8A02BB6C10594ULL, 0x79071B9B8A4BE869ULL,
+  0xB64EC836A47146F9ULL, 0x9748E2826CDEE284ULL,
+  0xE3E27A444D8D98B7ULL, 0xFD1B1B2308169B25ULL,
+  0x8E6D8C6AB0787F72ULL, 0xFE30F0F5E50E20F7ULL,
+  0xB208EF855C969F4FULL, 0xBDBD2D335E51A935ULL,
+  0xDE8B2B66B3BC4723ULL, 0xAD2C788035E61382ULL,
+  0x8B16FB203055AC76ULL, 0x4C3BCB5021AFCC31ULL,
+  0xADDCB9E83C6B1793ULL, 0xDF4ABE242A1BBF3DULL,
+  0xD953E8624B85DD78ULL, 0xD71D6DAD34A2AF0DULL,
+  0x87D4713D6F33AA6BULL, 0x8672648C40E5AD68ULL,
+  0xA9C98D8CCB009506ULL, 0x680EFDAF511F18C2ULL,
+  0xD43BF0EFFDC0BA48ULL, 0x0212BD1B2566DEF2ULL,
+  0x84A57695FE98746DULL, 0x014BB630F7604B57ULL,
+  0xA5CED43B7E3E9188ULL, 0x419EA3BD35385E2DULL,
+  0xCF42894A5DCE35EAULL, 0x52064CAC828675B9ULL,
+  0x818995CE7AA0E1B2ULL, 0x7343EFEBD1940993ULL,
+  0xA1EBFB4219491A1FULL, 0x1014EBE6C5F90BF8ULL,
+  0xCA66FA129F9B60A6ULL, 0xD41A26E077774EF6ULL,
+  0xFD00B897478238D0ULL, 0x8920B098955522B4ULL,
+  0x9E20735E8CB16382ULL, 0x55B46E5F5D5535B0ULL,
+  0xC5A890362FDDBC62ULL, 0xEB2189F734AA831DULL,
+  0xF712B443BBD52B7BULL, 0xA5E9EC7501D523E4ULL,
+  0x9A6BB0AA55653B2DULL, 0x47B233C92125366EULL,
+  0xC1069CD4EABE89F8ULL, 0x999EC0BB696E840AULL,
+  0xF148440A256E2C76ULL, 0xC00670EA43CA250DULL,
+  0x96CD2A865764DBCAULL, 0x380406926A5E5728ULL,
+  0xBC807527ED3E12BCULL, 0xC605083704F5ECF2ULL,
+  0xEBA09271E88D976BULL, 0xF7864A44C633682EULL,
+  0x93445B8731587EA3ULL, 0x7AB3EE6AFBE0211DULL,
+  0xB8157268FDAE9E4CULL, 0x5960EA05BAD82964ULL,
+  0xE61ACF033D1A45DFULL, 0x6FB92487298E33BDULL,
+  0x8FD0C16206306BABULL, 0xA5D3B6D479F8E056ULL,
+  0xB3C4F1BA87BC8696ULL, 0x8F48A4899877186CULL,
+  0xE0B62E2929ABA83CULL, 0x331ACDABFE94DE87ULL,
+  0x8C71DCD9BA0B4925ULL, 0x9FF0C08B7F1D0B14ULL,
+  0xAF8E5410288E1B6FULL, 0x07ECF0AE5EE44DD9ULL,
+  0xDB71E91432B1A24AULL, 0xC9E82CD9F69D6150ULL,
+  0x892731AC9FAF056EULL, 0xBE311C083A225CD2ULL,
+  0xAB70FE17C79AC6CAULL, 0x6DBD630A48AAF406ULL,
+  0xD64D3D9DB981787DULL, 0x092CBBCCDAD5B108ULL,
+  0x85F0468293F0EB4EULL, 0x25BBF56008C58EA5ULL,
+  0xA76C582338ED2621ULL, 0xAF2AF2B80AF6F24EULL,
+  0xD1476E2C07286FAAULL, 0x1AF5AF660DB4AEE1ULL,
+  0x82CCA4DB847945CAULL, 0x50D98D9FC890ED4DULL,
+  0xA37FCE126597973CULL, 0xE50FF107BAB528A0ULL,
+  0xCC5FC196FEFD7D0CULL, 0x1E53ED49A96272C8ULL,
+  0xFF77B1FCBEBCDC4FULL, 0x25E8E89C13BB0F7AULL,
+  0x9FAACF3DF73609B1ULL, 0x77B191618C54E9ACULL,
+  0xC795830D75038C1DULL, 0xD59DF5B9EF6A2417ULL,
+  0xF97AE3D0D2446F25ULL, 0x4B0573286B44AD1DULL,
+  0x9BECCE62836AC577ULL, 0x4EE367F9430AEC32ULL,
+  0xC2E801FB244576D5ULL, 0x229C41F793CDA73FULL,
+  0xF3A20279ED56D48AULL, 0x6B43527578C1110FULL,
+  0x9845418C345644D6ULL, 0x830A13896B78AAA9ULL,
+  0xBE5691EF416BD60CULL, 0x23CC986BC656D553ULL,
+  0xEDEC366B11C6CB8FULL, 0x2CBFBE86B7EC8AA8ULL,
+  0x94B3A202EB1C3F39ULL, 0x7BF7D71432F3D6A9ULL,
+  0xB9E08A83A5E34F07ULL, 0xDAF5CCD93FB0CC53ULL,
+  0xE858AD248F5C22C9ULL, 0xD1B3400F8F9CFF68ULL,
+  0x91376C36D99995BEULL, 0x23100809B9C21FA1ULL,
+  0xB58547448FFFFB2DULL, 0xABD40A0C2832A78AULL,
+  0xE2E69915B3FFF9F9ULL, 0x16C90C8F323F516CULL,
+  0x8DD01FAD907FFC3BULL, 0xAE3DA7D97F6792E3ULL,
+  0xB1442798F49FFB4AULL, 0x99CD11CFDF41779CULL,
+  0xDD95317F31C7FA1DULL, 0x40405643D711D583ULL,
+  0x8A7D3EEF7F1CFC52ULL, 0x482835EA666B2572ULL,
+  0xAD1C8EAB5EE43B66ULL, 0xDA3243650005EECFULL,
+  0xD863B256369D4A40ULL, 0x90BED43E40076A82ULL,
+  0x873E4F75E2224E68ULL, 0x5A7744A6E804A291ULL,
+  0xA90DE3535AAAE202ULL, 0x711515D0A205CB36ULL,
+  0xD3515C2831559A83ULL, 0x0D5A5B44CA873E03ULL,
+  0x8412D9991ED58091ULL, 0xE858790AFE9486C2ULL,
+  0xA5178FFF668AE0B6ULL, 0x626E974DBE39A872ULL,
+  0xCE5D73FF402D98E3ULL, 0xFB0A3D212DC8128FULL,
+  0x80FA687F881C7F8EULL, 0x7CE66634BC9D0B99ULL,
+  0xA139029F6A239F72ULL, 0x1C1FFFC1EBC44E80ULL,
+  0xC987434744AC874EULL, 0xA327FFB266B56220ULL,
+  0xFBE9141915D7A922ULL, 0x4BF1FF9F0062BAA8ULL,
+  0x9D71AC8FADA6C9B5ULL, 0x6F773FC3603DB4A9ULL,
+  0xC4CE17B399107C22ULL, 0xCB550FB4384D21D3ULL,
+  0xF6019DA07F549B2BULL, 0x7E2A53A146606A48ULL,
+  0x99C102844F94E0FBULL, 0x2EDA7444CBFC426DULL,
+  0xC0314325637A1939ULL, 0xFA911155FEFB5308ULL,
+  0xF03D93EEBC589F88ULL, 0x793555AB7EBA27CAULL,
+  0x96267C7535B763B5ULL, 0x4BC1558B2F3458DEULL,
+  0xBBB01B9283253CA2ULL, 0x9EB1AAEDFB016F16ULL,
+  0xEA9C227723EE8BCBULL, 0x465E15A979C1CADCULL,
+  0x92A1958A7675175FULL, 0x0BFACD89EC191EC9ULL,
+  0xB749FAED14125D36ULL, 0xCEF980EC671F667BULL,
+  0xE51C79A85916F484ULL, 0x82B7E12780E7401AULL,
+  0x8F31CC0937AE58D2ULL, 0xD1B2ECB8B0908810ULL,
+  0xB2FE3F0B8599EF07ULL, 0x861FA7E6DCB4AA15ULL,
+  0xDFBDCECE67006AC9ULL, 0x67A791E093E1D49AULL,
+  0x8BD6A141006042BDULL, 0xE0C8BB2C5C6D24E0ULL,
+  0xAECC49914078536DULL, 0x58FAE9F773886E18ULL,
+  0xDA7F5BF590966848ULL, 0xAF39A475506A899EULL,
+  0x888F99797A5E012DULL, 0x6D8406C952429603ULL,
+  0xAAB37FD7D8F58178ULL, 0xC8E5087BA6D33B83ULL,
+  0xD5605FCDCF32E1D6ULL, 0xFB1E4A9A90880A64ULL,
+  0x855C3BE0A17FCD26ULL, 0x5CF2EEA09A55067FULL,
+  0xA6B34AD8C9DFC06FULL, 0xF42FAA48C0EA481EULL,
+  0xD0601D8EFC57B08BULL, 0xF13B94DAF124DA26ULL,
+  0x823C12795DB6CE57ULL, 0x76C53D08D6B70858ULL,
+  0xA2CB1717B52481EDULL, 0x54768C4B0C64CA6EULL,
+  0xCB7DDCDDA26DA268ULL, 0xA9942F5DCF7DFD09ULL,
+  0xFE5D54150B090B02ULL, 0xD3F93B35435D7C4CULL,
+  0x9EFA548D26E5A6E1ULL, 0xC47BC5014A1A6DAFULL,
+  0xC6B8E9B0709F109AULL, 0x359AB6419CA1091BULL,
+  0xF867241C8CC6D4C0ULL, 0xC30163D203C94B62ULL,
+  0x9B407691D7FC44F8ULL, 0x79E0DE63425DCF1DULL,
+  0xC21094364DFB5636ULL, 0x985915FC12F542E4ULL,
+  0xF294B943E17A2BC4ULL, 0x3E6F5B7B17B2939DULL,
+  0x979CF3CA6CEC5B5AULL, 0xA705992CEECF9C42ULL,
+  0xBD8430BD08277231ULL, 0x50C6FF782A838353ULL,
+  0xECE53CEC4A314EBDULL, 0xA4F8BF5635246428ULL,
+  0x940F4613AE5ED136ULL, 0x871B7795E136BE99ULL,
+  0xB913179899F68584ULL, 0x28E2557B59846E3FULL,
+  0xE757DD7EC07426E5ULL, 0x331AEADA2FE589CFULL,
+  0x9096EA6F3848984FULL, 0x3FF0D2C85DEF7621ULL,
+  0xB4BCA50B065ABE63ULL, 0x0FED077A756B53A9ULL,
+  0xE1EBCE4DC7F16DFBULL, 0xD3E8495912C62894ULL,
+  0x8D3360F09CF6E4BDULL, 0x64712DD7ABBBD95CULL,
+  0xB080392CC4349DECULL, 0xBD8D794D96AACFB3ULL,
+  0xDCA04777F541C567ULL, 0xECF0D7A0FC5583A0ULL,
+  0x89E42CAAF9491B60ULL, 0xF41686C49DB57244ULL,
+  0xAC5D37D5B79B6239ULL, 0x311C2875C522CED5ULL,
+  0xD77485CB25823AC7ULL, 0x7D633293366B828BULL,
+  0x86A8D39EF77164BCULL, 0xAE5DFF9C02033197ULL,
+  0xA8530886B54DBDEBULL, 0xD9F57F830283FDFCULL,
+  0xD267CAA862A12D66ULL, 0xD072DF63C324FD7BULL,
+  0x8380DEA93DA4BC60ULL, 0x4247CB9E59F71E6DULL,
+  0xA46116538D0DEB78ULL, 0x52D9BE85F074E608ULL,
+  0xCD795BE870516656ULL, 0x67902E276C921F8BULL,
+  0x806BD9714632DFF6ULL, 0x00BA1CD8A3DB53B6ULL,
+  0xA086CFCD97BF97F3ULL, 0x80E8A40ECCD228A4ULL,
+  0xC8A883C0FDAF7DF0ULL, 0x6122CD128006B2CDULL,
+  0xFAD2A4B13D1B5D6CULL, 0x796B805720085F81ULL,
+  0x9CC3A6EEC6311A63ULL, 0xCBE3303674053BB0ULL,
+  0xC3F490AA77BD60FCULL, 0xBEDBFC4411068A9CULL,
+  0xF4F1B4D515ACB93BULL, 0xEE92FB5515482D44ULL,
+  0x991711052D8BF3C5ULL, 0x751BDD152D4D1C4AULL,
+  0xBF5CD54678EEF0B6ULL, 0xD262D45A78A0635DULL,
+  0xEF340A98172AACE4ULL, 0x86FB897116C87C34ULL,
+  0x9580869F0E7AAC0EULL, 0xD45D35E6AE3D4DA0ULL,
+  0xBAE0A846D2195712ULL, 0x8974836059CCA109ULL,
+  0xE998D258869FACD7ULL, 0x2BD1A438703FC94BULL,
+  0x91FF83775423CC06ULL, 0x7B6306A34627DDCFULL,
+  0xB67F6455292CBF08ULL, 0x1A3BC84C17B1D542ULL,
+  0xE41F3D6A7377EECAULL, 0x20CABA5F1D9E4A93ULL,
+  0x8E938662882AF53EULL, 0x547EB47B7282EE9CULL,
+  0xB23867FB2A35B28DULL, 0xE99E619A4F23AA43ULL,
+  0xDEC681F9F4C31F31ULL, 0x6405FA00E2EC94D4ULL,
+  0x8B3C113C38F9F37EULL, 0xDE83BC408DD3DD04ULL,
+  0xAE0B158B4738705EULL, 0x9624AB50B148D445ULL,
+  0xD98DDAEE19068C76ULL, 0x3BADD624DD9B0957ULL,
+  0x87F8A8D4CFA417C9ULL, 0xE54CA5D70A80E5D6ULL,
+  0xA9F6D30A038D1DBCULL, 0x5E9FCF4CCD211F4CULL,
+  0xD47487CC8470652BULL, 0x7647C3200069671FULL,
+  0x84C8D4DFD2C63F3BULL, 0x29ECD9F40041E073ULL,
+  0xA5FB0A17C777CF09ULL, 0xF468107100525890ULL,
+  0xCF79CC9DB955C2CCULL, 0x7182148D4066EEB4ULL,
+  0x81AC1FE293D599BFULL, 0xC6F14CD848405530ULL,
+  0xA21727DB38CB002FULL, 0xB8ADA00E5A506A7CULL,
+  0xCA9CF1D206FDC03BULL, 0xA6D90811F0E4851CULL,
+  0xFD442E4688BD304AULL, 0x908F4A166D1DA663ULL,
+  0x9E4A9CEC15763E2EULL, 0x9A598E4E043287FEULL,
+  0xC5DD44271AD3CDBAULL, 0x40EFF1E1853F29FDULL,
+  0xF7549530E188C128ULL, 0xD12BEE59E68EF47CULL,
+  0x9A94DD3E8CF578B9ULL, 0x82BB74F8301958CEULL,
+  0xC13A148E3032D6E7ULL, 0xE36A52363C1FAF01ULL,
+  0xF18899B1BC3F8CA1ULL, 0xDC44E6C3CB279AC1ULL,
+  0x96F5600F15A7B7E5ULL, 0x29AB103A5EF8C0B9ULL,
+  0xBCB2B812DB11A5DEULL, 0x7415D448F6B6F0E7ULL,
+  0xEBDF661791D60F56ULL, 0x111B495B3464AD21ULL,
+  0x936B9FCEBB25C995ULL, 0xCAB10DD900BEEC34ULL,
+  0xB84687C269EF3BFBULL, 0x3D5D514F40EEA742ULL,
+  0xE65829B3046B0AFAULL, 0x0CB4A5A3112A5112ULL,
+  0x8FF71A0FE2C2E6DCULL, 0x47F0E785EABA72ABULL,
+  0xB3F4E093DB73A093ULL, 0x59ED216765690F56ULL,
+  0xE0F218B8D25088B8ULL, 0x306869C13EC3532CULL,
+  0x8C974F7383725573ULL, 0x1E414218C73A13FBULL,
+  0xAFBD2350644EEACFULL, 0xE5D1929EF90898FAULL,
+  0xDBAC6C247D62A583ULL, 0xDF45F746B74ABF39ULL,
+  0x894BC396CE5DA772ULL, 0x6B8BBA8C328EB783ULL,
+  0xAB9EB47C81F5114FULL, 0x066EA92F3F326564ULL,
+  0xD686619BA27255A2ULL, 0xC80A537B0EFEFEBDULL,
+  0x8613FD0145877585ULL, 0xBD06742CE95F5F36ULL,
+  0xA798FC4196E952E7ULL, 0x2C48113823B73704ULL,
+  0xD17F3B51FCA3A7A0ULL, 0xF75A15862CA504C5ULL,
+  0x82EF85133DE648C4ULL, 0x9A984D73DBE722FBULL,
+  0xA3AB66580D5FDAF5ULL, 0xC13E60D0D2E0EBBAULL,
+  0xCC963FEE10B7D1B3ULL, 0x318DF905079926A8ULL,
+  0xFFBBCFE994E5C61FULL, 0xFDF17746497F7052ULL,
+  0x9FD561F1FD0F9BD3ULL, 0xFEB6EA8BEDEFA633ULL,
+  0xC7CABA6E7C5382C8ULL, 0xFE64A52EE96B8FC0ULL,
+  0xF9BD690A1B68637BULL, 0x3DFDCE7AA3C673B0ULL,
+  0x9C1661A651213E2DULL, 0x06BEA10CA65C084EULL,
+  0xC31BFA0FE5698DB8ULL, 0x486E494FCFF30A62ULL,
+  0xF3E2F893DEC3F126ULL, 0x5A89DBA3C3EFCCFAULL,
+  0x986DDB5C6B3A76B7ULL, 0xF89629465A75E01CULL,
+  0xBE89523386091465ULL, 0xF6BBB397F1135823ULL,
+  0xEE2BA6C0678B597FULL, 0x746AA07DED582E2CULL,
+  0x94DB483840B717EFULL, 0xA8C2A44EB4571CDCULL,
+  0xBA121A4650E4DDEBULL, 0x92F34D62616CE413ULL,
+  0xE896A0D7E51E1566ULL, 0x77B020BAF9C81D17ULL,
+  0x915E2486EF32CD60ULL, 0x0ACE1474DC1D122EULL,
+  0xB5B5ADA8AAFF80B8ULL, 0x0D819992132456BAULL,
+  0xE3231912D5BF60E6ULL, 0x10E1FFF697ED6C69ULL,
+  0x8DF5EFABC5979C8FULL, 0xCA8D3FFA1EF463C1ULL,
+  0xB1736B96B6FD83B3ULL, 0xBD308FF8A6B17CB2ULL,
+  0xDDD0467C64BCE4A0ULL, 0xAC7CB3F6D05DDBDEULL,
+  0x8AA22C0DBEF60EE4ULL, 0x6BCDF07A423AA96BULL,
+  0xAD4AB7112EB3929DULL, 0x86C16C98D2C953C6ULL,
+  0xD89D64D57A607744ULL, 0xE871C7BF077BA8B7ULL,
+  0x87625F056C7C4A8BULL, 0x11471CD764AD4972ULL,
+  0xA93AF6C6C79B5D2DULL, 0xD598E40D3DD89BCFULL,
+  0xD389B47879823479ULL, 0x4AFF1D108D4EC2C3ULL,
+  0x843610CB4BF160CBULL, 0xCEDF722A585139BAULL,
+  0xA54394FE1EEDB8FEULL, 0xC2974EB4EE658828ULL,
+  0xCE947A3DA6A9273EULL, 0x733D226229FEEA32ULL,
+  0x811CCC668829B887ULL, 0x0806357D5A3F525FULL,
+  0xA163FF802A3426A8ULL, 0xCA07C2DCB0CF26F7ULL,
+  0xC9BCFF6034C13052ULL, 0xFC89B393DD02F0B5ULL,
+  0xFC2C3F3841F17C67ULL, 0xBBAC2078D443ACE2ULL,
+  0x9D9BA7832936EDC0ULL, 0xD54B944B84AA4C0DULL,
+  0xC5029163F384A931ULL, 0x0A9E795E65D4DF11ULL,
+  0xF64335BCF065D37DULL, 0x4D4617B5FF4A16D5ULL,
+  0x99EA0196163FA42EULL, 0x504BCED1BF8E4E45ULL,
+  0xC06481FB9BCF8D39ULL, 0xE45EC2862F71E1D6ULL,
+  0xF07DA27A82C37088ULL, 0x5D767327BB4E5A4CULL,
+  0x964E858C91BA2655ULL, 0x3A6A07F8D510F86FULL,
+  0xBBE226EFB628AFEAULL, 0x890489F70A55368BULL,
+  0xEADAB0ABA3B2DBE5ULL, 0x2B45AC74CCEA842EULL,
+  0x92C8AE6B464FC96FULL, 0x3B0B8BC90012929DULL,
+  0xB77ADA0617E3BBCBULL, 0x09CE6EBB40173744ULL,
+  0xE55990879DDCAABDULL, 0xCC420A6A101D0515ULL,
+  0x8F57FA54C2A9EAB6ULL, 0x9FA946824A12232DULL,
+  0xB32DF8E9F3546564ULL, 0x47939822DC96ABF9ULL,
+  0xDFF9772470297EBDULL, 0x59787E2B93BC56F7ULL,
+  0x8BFBEA76C619EF36ULL, 0x57EB4EDB3C55B65AULL,
+  0xAEFAE51477A06B03ULL, 0xEDE622920B6B23F1ULL,
+  0xDAB99E59958885C4ULL, 0xE95FAB368E45ECEDULL,
+  0x88B402F7FD75539BULL, 0x11DBCB0218EBB414ULL,
+  0xAAE103B5FCD2A881ULL, 0xD652BDC29F26A119ULL,
+  0xD59944A37C0752A2ULL, 0x4BE76D3346F0495FULL,
+  0x857FCAE62D8493A5ULL, 0x6F70A4400C562DDBULL,
+  0xA6DFBD9FB8E5B88EULL, 0xCB4CCD500F6BB952ULL,
+  0xD097AD07A71F26B2ULL, 0x7E2000A41346A7A7ULL,
+  0x825ECC24C873782FULL, 0x8ED400668C0C28C8ULL,
+  0xA2F67F2DFA90563BULL, 0x728900802F0F32FAULL,
+  0xCBB41EF979346BCAULL, 0x4F2B40A03AD2FFB9ULL,
+  0xFEA126B7D78186BCULL, 0xE2F610C84987BFA8ULL,
+  0x9F24B832E6B0F436ULL, 0x0DD9CA7D2DF4D7C9ULL,
+  0xC6EDE63FA05D3143ULL, 0x91503D1C79720DBBULL,
+  0xF8A95FCF88747D94ULL, 0x75A44C6397CE912AULL,
+  0x9B69DBE1B548CE7CULL, 0xC986AFBE3EE11ABAULL,
+  0xC24452DA229B021BULL, 0xFBE85BADCE996168ULL,
+  0xF2D56790AB41C2A2ULL, 0xFAE27299423FB9C3ULL,
+  0x97C560BA6B0919A5ULL, 0xDCCD879FC967D41AULL,
+  0xBDB6B8E905CB600FULL, 0x5400E987BBC1C920ULL,
+  0xED246723473E3813ULL, 0x290123E9AAB23B68ULL,
+  0x9436C0760C86E30BULL, 0xF9A0B6720AAF6521ULL,
+  0xB94470938FA89BCEULL, 0xF808E40E8D5B3E69ULL,
+  0xE7958CB87392C2C2ULL, 0xB60B1D1230B20E04ULL,
+  0x90BD77F3483BB9B9ULL, 0xB1C6F22B5E6F48C2ULL,
+  0xB4ECD5F01A4AA828ULL, 0x1E38AEB6360B1AF3ULL,
+  0xE2280B6C20DD5232ULL, 0x25C6DA63C38DE1B0ULL,
+  0x8D590723948A535FULL, 0x579C487E5A38AD0EULL,
+  0xB0AF48EC79ACE837ULL, 0x2D835A9DF0C6D851ULL,
+  0xDCDB1B2798182244ULL, 0xF8E431456CF88E65ULL,
+  0x8A08F0F8BF0F156BULL, 0x1B8E9ECB641B58FFULL,
+  0xAC8B2D36EED2DAC5ULL, 0xE272467E3D222F3FULL,
+  0xD7ADF884AA879177ULL, 0x5B0ED81DCC6ABB0FULL,
+  0x86CCBB52EA94BAEAULL, 0x98E947129FC2B4E9ULL,
+  0xA87FEA27A539E9A5ULL, 0x3F2398D747B36224ULL,
+  0xD29FE4B18E88640EULL, 0x8EEC7F0D19A03AADULL,
+  0x83A3EEEEF9153E89ULL, 0x1953CF68300424ACULL,
+  0xA48CEAAAB75A8E2BULL, 0x5FA8C3423C052DD7ULL,
+  0xCDB02555653131B6ULL, 0x3792F412CB06794DULL,
+  0x808E17555F3EBF11ULL, 0xE2BBD88BBEE40BD0ULL,
+  0xA0B19D2AB70E6ED6ULL, 0x5B6ACEAEAE9D0EC4ULL,
+  0xC8DE047564D20A8BULL, 0xF245825A5A445275ULL,
+  0xFB158592BE068D2EULL, 0xEED6E2F0F0D56712ULL,
+  0x9CED737BB6C4183DULL, 0x55464DD69685606BULL,
+  0xC428D05AA4751E4CULL, 0xAA97E14C3C26B886ULL,
+  0xF53304714D9265DFULL, 0xD53DD99F4B3066A8ULL,
+  0x993FE2C6D07B7FABULL, 0xE546A8038EFE4029ULL,
+  0xBF8FDB78849A5F96ULL, 0xDE98520472BDD033ULL,
+  0xEF73D256A5C0F77CULL, 0x963E66858F6D4440ULL,
+  0x95A8637627989AADULL, 0xDDE7001379A44AA8ULL,
+  0xBB127C53B17EC159ULL, 0x5560C018580D5D52ULL,
+  0xE9D71B689DDE71AFULL, 0xAAB8F01E6E10B4A6ULL,
+  0x9226712162AB070DULL, 0xCAB3961304CA70E8ULL,
+  0xB6B00D69BB55C8D1ULL, 0x3D607B97C5FD0D22ULL,
+  0xE45C10C42A2B3B05ULL, 0x8CB89A7DB77C506AULL,
+  0x8EB98A7A9A5B04E3ULL, 0x77F3608E92ADB242ULL,
+  0xB267ED1940F1C61CULL, 0x55F038B237591ED3ULL,
+  0xDF01E85F912E37A3ULL, 0x6B6C46DEC52F6688ULL,
+  0x8B61313BBABCE2C6ULL, 0x2323AC4B3B3DA015ULL,
+  0xAE397D8AA96C1B77ULL, 0xABEC975E0A0D081AULL,
+  0xD9C7DCED53C72255ULL, 0x96E7BD358C904A21ULL,
+  0x881CEA14545C7575ULL, 0x7E50D64177DA2E54ULL,
+  0xAA242499697392D2ULL, 0xDDE50BD1D5D0B9E9ULL,
+  0xD4AD2DBFC3D07787ULL, 0x955E4EC64B44E864ULL,
+  0x84EC3C97DA624AB4ULL, 0xBD5AF13BEF0B113EULL,
+  0xA6274BBDD0FADD61ULL, 0xECB1AD8AEACDD58EULL,
+  0xCFB11EAD453994BAULL, 0x67DE18EDA5814AF2ULL,
+  0x81CEB32C4B43FCF4ULL, 0x80EACF948770CED7ULL,
+  0xA2425FF75E14FC31ULL, 0xA1258379A94D028DULL,
+  0xCAD2F7F5359A3B3EULL, 0x096EE45813A04330ULL,
+  0xFD87B5F28300CA0DULL, 0x8BCA9D6E188853FCULL,
+  0x9E74D1B791E07E48ULL, 0x775EA264CF55347EULL,
+  0xC612062576589DDAULL, 0x95364AFE032A819EULL,
+  0xF79687AED3EEC551ULL, 0x3A83DDBD83F52205ULL,
+  0x9ABE14CD44753B52ULL, 0xC4926A9672793543ULL,
+  0xC16D9A0095928A27ULL, 0x75B7053C0F178294ULL,
+  0xF1C90080BAF72CB1ULL, 0x5324C68B12DD6339ULL,
+  0x971DA05074DA7BEEULL, 0xD3F6FC16EBCA5E04ULL,
+  0xBCE5086492111AEAULL, 0x88F4BB1CA6BCF585ULL,
+  0xEC1E4A7DB69561A5ULL, 0x2B31E9E3D06C32E6ULL,
+  0x9392EE8E921D5D07ULL, 0x3AFF322E62439FD0ULL,
+  0xB877AA3236A4B449ULL, 0x09BEFEB9FAD487C3ULL,
+  0xE69594BEC44DE15BULL, 0x4C2EBE687989A9B4ULL,
+  0x901D7CF73AB0ACD9ULL, 0x0F9D37014BF60A11ULL,
+  0xB424DC35095CD80FULL, 0x538484C19EF38C95ULL,
+  0xE12E13424BB40E13ULL, 0x2865A5F206B06FBAULL,
+  0x8CBCCC096F5088CBULL, 0xF93F87B7442E45D4ULL,
+  0xAFEBFF0BCB24AAFEULL, 0xF78F69A51539D749ULL,
+  0xDBE6FECEBDEDD5BEULL, 0xB573440E5A884D1CULL,
+  0x89705F4136B4A597ULL, 0x31680A88F8953031ULL,
+  0xABCC77118461CEFCULL, 0xFDC20D2B36BA7C3EULL,
+  0xD6BF94D5E57A42BCULL, 0x3D32907604691B4DULL,
+  0x8637BD05AF6C69B5ULL, 0xA63F9A49C2C1B110ULL,
+  0xA7C5AC471B478423ULL, 0x0FCF80DC33721D54ULL,
+  0xD1B71758E219652BULL, 0xD3C36113404EA4A9ULL,
+  0x83126E978D4FDF3BULL, 0x645A1CAC083126EAULL,
+  0xA3D70A3D70A3D70AULL, 0x3D70A3D70A3D70A4ULL,
+  0xCCCCCCCCCCCCCCCCULL, 0xCCCCCCCCCCCCCCCDULL,
+  0x8000000000000000ULL, 0x0000000000000000ULL,
+  0xA000000000000000ULL, 0x0000000000000000ULL,
+  0xC800000000000000ULL, 0x0000000000000000ULL,
+  0xFA00000000000000ULL, 0x0000000000000000ULL,
+  0x9C40000000000000ULL, 0x0000000000000000ULL,
+  0xC350000000000000ULL, 0x0000000000000000ULL,
+  0xF424000000000000ULL, 0x0000000000000000ULL,
+  0x9896800000000000ULL, 0x0000000000000000ULL,
+  0xBEBC200000000000ULL, 0x0000000000000000ULL,
+  0xEE6B280000000000ULL, 0x0000000000000000ULL,
+  0x9502F90000000000ULL, 0x0000000000000000ULL,
+  0xBA43B74000000000ULL, 0x0000000000000000ULL,
+  0xE8D4A51000000000ULL, 0x0000000000000000ULL,
+  0x9184E72A00000000ULL, 0x0000000000000000ULL,
+  0xB5E620F480000000ULL, 0x0000000000000000ULL,
+  0xE35FA931A0000000ULL, 0x0000000000000000ULL,
+  0x8E1BC9BF04000000ULL, 0x0000000000000000ULL,
+  0xB1A2BC2EC5000000ULL, 0x0000000000000000ULL,
+  0xDE0B6B3A76400000ULL, 0x0000000000000000ULL,
+  0x8AC7230489E80000ULL, 0x0000000000000000ULL,
+  0xAD78EBC5AC620000ULL, 0x0000000000000000ULL,
+  0xD8D726B7177A8000ULL, 0x0000000000000000ULL,
+  0x878678326EAC9000ULL, 0x0000000000000000ULL,
+  0xA968163F0A57B400ULL, 0x0000000000000000ULL,
+  0xD3C21BCECCEDA100ULL, 0x0000000000000000ULL,
+  0x84595161401484A0ULL, 0x0000000000000000ULL,
+  0xA56FA5B99019A5C8ULL, 0x0000000000000000ULL,
+  0xCECB8F27F4200F3AULL, 0x0000000000000000ULL,
+  0x813F3978F8940984ULL, 0x4000000000000000ULL,
+  0xA18F07D736B90BE5ULL, 0x5000000000000000ULL,
+  0xC9F2C9CD04674EDEULL, 0xA400000000000000ULL,
+  0xFC6F7C4045812296ULL, 0x4D00000000000000ULL,
+  0x9DC5ADA82B70B59DULL, 0xF020000000000000ULL,
+  0xC5371912364CE305ULL, 0x6C28000000000000ULL,
+  0xF684DF56C3E01BC6ULL, 0xC732000000000000ULL,
+  0x9A130B963A6C115CULL, 0x3C7F400000000000ULL,
+  0xC097CE7BC90715B3ULL, 0x4B9F100000000000ULL,
+  0xF0BDC21ABB48DB20ULL, 0x1E86D40000000000ULL,
+  0x96769950B50D88F4ULL, 0x1314448000000000ULL,
+  0xBC143FA4E250EB31ULL, 0x17D955A000000000ULL,
+  0xEB194F8E1AE525FDULL, 0x5DCFAB0800000000ULL,
+  0x92EFD1B8D0CF37BEULL, 0x5AA1CAE500000000ULL,
+  0xB7ABC627050305ADULL, 0xF14A3D9E40000000ULL,
+  0xE596B7B0C643C719ULL, 0x6D9CCD05D0000000ULL,
+  0x8F7E32CE7BEA5C6FULL, 0xE4820023A2000000ULL,
+  0xB35DBF821AE4F38BULL, 0xDDA2802C8A800000ULL,
+  0xE0352F62A19E306EULL, 0xD50B2037AD200000ULL,
+  0x8C213D9DA502DE45ULL, 0x4526F422CC340000ULL,
+  0xAF298D050E4395D6ULL, 0x9670B12B7F410000ULL,
+  0xDAF3F04651D47B4CULL, 0x3C0CDD765F114000ULL,
+  0x88D8762BF324CD0FULL, 0xA5880A69FB6AC800ULL,
+  0xAB0E93B6EFEE0053ULL, 0x8EEA0D047A457A00ULL,
+  0xD5D238A4ABE98068ULL, 0x72A4904598D6D880ULL,
+  0x85A36366EB71F041ULL, 0x47A6DA2B7F864750ULL,
+  0xA70C3C40A64E6C51ULL, 0x999090B65F67D924ULL,
+  0xD0CF4B50CFE20765ULL, 0xFFF4B4E3F741CF6DULL,
+  0x82818F1281ED449FULL, 0xBFF8F10E7A8921A4ULL,
+  0xA321F2D7226895C7ULL, 0xAFF72D52192B6A0DULL,
+  0xCBEA6F8CEB02BB39ULL, 0x9BF4F8A69F764490ULL,
+  0xFEE50B7025C36A08ULL, 0x02F236D04753D5B4ULL,
+  0x9F4F2726179A2245ULL, 0x01D762422C946590ULL,
+  0xC722F0EF9D80AAD6ULL, 0x424D3AD2B7B97EF5ULL,
+  0xF8EBAD2B84E0D58BULL, 0xD2E0898765A7DEB2ULL,
+  0x9B934C3B330C8577ULL, 0x63CC55F49F88EB2FULL,
+  0xC2781F49FFCFA6D5ULL, 0x3CBF6B71C76B25FBULL,
+  0xF316271C7FC3908AULL, 0x8BEF464E3945EF7AULL,
+  0x97EDD871CFDA3A56ULL, 0x97758BF0E3CBB5ACULL,
+  0xBDE94E8E43D0C8ECULL, 0x3D52EEED1CBEA317ULL,
+  0xED63A231D4C4FB27ULL, 0x4CA7AAA863EE4BDDULL,
+  0x945E455F24FB1CF8ULL, 0x8FE8CAA93E74EF6AULL,
+  0xB975D6B6EE39E436ULL, 0xB3E2FD538E122B44ULL,
+  0xE7D34C64A9C85D44ULL, 0x60DBBCA87196B616ULL,
+  0x90E40FBEEA1D3A4AULL, 0xBC8955E946FE31CDULL,
+  0xB51D13AEA4A488DDULL, 0x6BABAB6398BDBE41ULL,
+  0xE264589A4DCDAB14ULL, 0xC696963C7EED2DD1ULL,
+  0x8D7EB76070A08AECULL, 0xFC1E1DE5CF543CA2ULL,
+  0xB0DE65388CC8ADA8ULL, 0x3B25A55F43294BCBULL,
+  0xDD15FE86AFFAD912ULL, 0x49EF0EB713F39EBEULL,
+  0x8A2DBF142DFCC7ABULL, 0x6E3569326C784337ULL,
+  0xACB92ED9397BF996ULL, 0x49C2C37F07965404ULL,
+  0xD7E77A8F87DAF7FBULL, 0xDC33745EC97BE906ULL,
+  0x86F0AC99B4E8DAFDULL, 0x69A028BB3DED71A3ULL,
+  0xA8ACD7C0222311BCULL, 0xC40832EA0D68CE0CULL,
+  0xD2D80DB02AABD62BULL, 0xF50A3FA490C30190ULL,
+  0x83C7088E1AAB65DBULL, 0x792667C6DA79E0FAULL,
+  0xA4B8CAB1A1563F52ULL, 0x577001B891185938ULL,
+  0xCDE6FD5E09ABCF26ULL, 0xED4C0226B55E6F86ULL,
+  0x80B05E5AC60B6178ULL, 0x544F8158315B05B4ULL,
+  0xA0DC75F1778E39D6ULL, 0x696361AE3DB1C721ULL,
+  0xC913936DD571C84CULL, 0x03BC3A19CD1E38E9ULL,
+  0xFB5878494ACE3A5FULL, 0x04AB48A04065C723ULL,
+  0x9D174B2DCEC0E47BULL, 0x62EB0D64283F9C76ULL,
+  0xC45D1DF942711D9AULL, 0x3BA5D0BD324F8394ULL,
+  0xF5746577930D6500ULL, 0xCA8F44EC7EE36479ULL,
+  0x9968BF6ABBE85F20ULL, 0x7E998B13CF4E1ECBULL,
+  0xBFC2EF456AE276E8ULL, 0x9E3FEDD8C321A67EULL,
+  0xEFB3AB16C59B14A2ULL, 0xC5CFE94EF3EA101EULL,
+  0x95D04AEE3B80ECE5ULL, 0xBBA1F1D158724A12ULL,
+  0xBB445DA9CA61281FULL, 0x2A8A6E45AE8EDC97ULL,
+  0xEA1575143CF97226ULL, 0xF52D09D71A3293BDULL,
+  0x924D692CA61BE758ULL, 0x593C2626705F9C56ULL,
+  0xB6E0C377CFA2E12EULL, 0x6F8B2FB00C77836CULL,
+  0xE498F455C38B997AULL, 0x0B6DFB9C0F956447ULL,
+  0x8EDF98B59A373FECULL, 0x4724BD4189BD5EACULL,
+  0xB2977EE300C50FE7ULL, 0x58EDEC91EC2CB657ULL,
+  0xDF3D5E9BC0F653E1ULL, 0x2F2967B66737E3EDULL,
+  0x8B865B215899F46CULL, 0xBD79E0D20082EE74ULL,
+  0xAE67F1E9AEC07187ULL, 0xECD8590680A3AA11ULL,
+  0xDA01EE641A708DE9ULL, 0xE80E6F4820CC9495ULL,
+  0x884134FE908658B2ULL, 0x3109058D147FDCDDULL,
+  0xAA51823E34A7EEDEULL, 0xBD4B46F0599FD415ULL,
+  0xD4E5E2CDC1D1EA96ULL, 0x6C9E18AC7007C91AULL,
+  0x850FADC09923329EULL, 0x03E2CF6BC604DDB0ULL,
+  0xA6539930BF6BFF45ULL, 0x84DB8346B786151CULL,
+  0xCFE87F7CEF46FF16ULL, 0xE612641865679A63ULL,
+  0x81F14FAE158C5F6EULL, 0x4FCB7E8F3F60C07EULL,
+  0xA26DA3999AEF7749ULL, 0xE3BE5E330F38F09DULL,
+  0xCB090C8001AB551CULL, 0x5CADF5BFD3072CC5ULL,
+  0xFDCB4FA002162A63ULL, 0x73D9732FC7C8F7F6ULL,
+  0x9E9F11C4014DDA7EULL, 0x2867E7FDDCDD9AFAULL,
+  0xC646D63501A1511DULL, 0xB281E1FD541501B8ULL,
+  0xF7D88BC24209A565ULL, 0x1F225A7CA91A4226ULL,
+  0x9AE757596946075FULL, 0x3375788DE9B06958ULL,
+  0xC1A12D2FC3978937ULL, 0x0052D6B1641C83AEULL,
+  0xF209787BB47D6B84ULL, 0xC0678C5DBD23A49AULL,
+  0x9745EB4D50CE6332ULL, 0xF840B7BA963646E0ULL,
+  0xBD176620A501FBFFULL, 0xB650E5A93BC3D898ULL,
+  0xEC5D3FA8CE427AFFULL, 0xA3E51F138AB4CEBEULL,
+  0x93BA47C980E98CDFULL, 0xC66F336C36B10137ULL,
+  0xB8A8D9BBE123F017ULL, 0xB80B0047445D4184ULL,
+  0xE6D3102AD96CEC1DULL, 0xA60DC059157491E5ULL,
+  0x9043EA1AC7E41392ULL, 0x87C89837AD68DB2FULL,
+  0xB454E4A179DD1877ULL, 0x29BABE4598C311FBULL,
+  0xE16A1DC9D8545E94ULL, 0xF4296DD6FEF3D67AULL,
+  0x8CE2529E2734BB1DULL, 0x1899E4A65F58660CULL,
+  0xB01AE745B101E9E4ULL, 0x5EC05DCFF72E7F8FULL,
+  0xDC21A1171D42645DULL, 0x76707543F4FA1F73ULL,
+  0x899504AE72497EBAULL, 0x6A06494A791C53A8ULL,
+  0xABFA45DA0EDBDE69ULL, 0x0487DB9D17636892ULL,
+  0xD6F8D7509292D603ULL, 0x45A9D2845D3C42B6ULL,
+  0x865B86925B9BC5C2ULL, 0x0B8A2392BA45A9B2ULL,
+  0xA7F26836F282B732ULL, 0x8E6CAC7768D7141EULL,
+  0xD1EF0244AF2364FFULL, 0x3207D795430CD926ULL,
+  0x8335616AED761F1FULL, 0x7F44E6BD49E807B8ULL,
+  0xA402B9C5A8D3A6E7ULL, 0x5F16206C9C6209A6ULL,
+  0xCD036837130890A1ULL, 0x36DBA887C37A8C0FULL,
+  0x802221226BE55A64ULL, 0xC2494954DA2C9789ULL,
+  0xA02AA96B06DEB0FDULL, 0xF2DB9BAA10B7BD6CULL,
+  0xC83553C5C8965D3DULL, 0x6F92829494E5ACC7ULL,
+  0xFA42A8B73ABBF48CULL, 0xCB772339BA1F17F9ULL,
+  0x9C69A97284B578D7ULL, 0xFF2A760414536EFBULL,
+  0xC38413CF25E2D70DULL, 0xFEF5138519684ABAULL,
+  0xF46518C2EF5B8CD1ULL, 0x7EB258665FC25D69ULL,
+  0x98BF2F79D5993802ULL, 0xEF2F773FFBD97A61ULL,
+  0xBEEEFB584AFF8603ULL, 0xAAFB550FFACFD8FAULL,
+  0xEEAABA2E5DBF6784ULL, 0x95BA2A53F983CF38ULL,
+  0x952AB45CFA97A0B2ULL, 0xDD945A747BF26183ULL,
+  0xBA756174393D88DFULL, 0x94F971119AEEF9E4ULL,
+  0xE912B9D1478CEB17ULL, 0x7A37CD5601AAB85DULL,
+  0x91ABB422CCB812EEULL, 0xAC62E055C10AB33AULL,
+  0xB616A12B7FE617AAULL, 0x577B986B314D6009ULL,
+  0xE39C49765FDF9D94ULL, 0xED5A7E85FDA0B80BULL,
+  0x8E41ADE9FBEBC27DULL, 0x14588F13BE847307ULL,
+  0xB1D219647AE6B31CULL, 0x596EB2D8AE258FC8ULL,
+  0xDE469FBD99A05FE3ULL, 0x6FCA5F8ED9AEF3BBULL,
+  0x8AEC23D680043BEEULL, 0x25DE7BB9480D5854ULL,
+  0xADA72CCC20054AE9ULL, 0xAF561AA79A10AE6AULL,
+  0xD910F7FF28069DA4ULL, 0x1B2BA1518094DA04ULL,
+  0x87AA9AFF79042286ULL, 0x90FB44D2F05D0842ULL,
+  0xA99541BF57452B28ULL, 0x353A1607AC744A53ULL,
+  0xD3FA922F2D1675F2ULL, 0x42889B8997915CE8ULL,
+  0x847C9B5D7C2E09B7ULL, 0x69956135FEBADA11ULL,
+  0xA59BC234DB398C25ULL, 0x43FAB9837E699095ULL,
+  0xCF02B2C21207EF2EULL, 0x94F967E45E03F4BBULL,
+  0x8161AFB94B44F57DULL, 0x1D1BE0EEBAC278F5ULL,
+  0xA1BA1BA79E1632DCULL, 0x6462D92A69731732ULL,
+  0xCA28A291859BBF93ULL, 0x7D7B8F7503CFDCFEULL,
+  0xFCB2CB35E702AF78ULL, 0x5CDA735244C3D43EULL,
+  0x9DEFBF01B061ADABULL, 0x3A0888136AFA64A7ULL,
+  0xC56BAEC21C7A1916ULL, 0x088AAA1845B8FDD0ULL,
+  0xF6C69A72A3989F5BULL, 0x8AAD549E57273D45ULL,
+  0x9A3C2087A63F6399ULL, 0x36AC54E2F678864BULL,
+  0xC0CB28A98FCF3C7FULL, 0x84576A1BB416A7DDULL,
+  0xF0FDF2D3F3C30B9FULL, 0x656D44A2A11C51D5ULL,
+  0x969EB7C47859E743ULL, 0x9F644AE5A4B1B325ULL,
+  0xBC4665B596706114ULL, 0x873D5D9F0DDE1FEEULL,
+  0xEB57FF22FC0C7959ULL, 0xA90CB506D155A7EAULL,
+  0x9316FF75DD87CBD8ULL, 0x09A7F12442D588F2ULL,
+  0xB7DCBF5354E9BECEULL, 0x0C11ED6D538AEB2FULL,
+  0xE5D3EF282A242E81ULL, 0x8F1668C8A86DA5FAULL,
+  0x8FA475791A569D10ULL, 0xF96E017D694487BCULL,
+  0xB38D92D760EC4455ULL, 0x37C981DCC395A9ACULL,
+  0xE070F78D3927556AULL, 0x85BBE253F47B1417ULL,
+  0x8C469AB843B89562ULL, 0x93956D7478CCEC8EULL,
+  0xAF58416654A6BABBULL, 0x387AC8D1970027B2ULL,
+  0xDB2E51BFE9D0696AULL, 0x06997B05FCC0319EULL,
+  0x88FCF317F22241E2ULL, 0x441FECE3BDF81F03ULL,
+  0xAB3C2FDDEEAAD25AULL, 0xD527E81CAD7626C3ULL,
+  0xD60B3BD56A5586F1ULL, 0x8A71E223D8D3B074ULL,
+  0x85C7056562757456ULL, 0xF6872D5667844E49ULL,
+  0xA738C6BEBB12D16CULL, 0xB428F8AC016561DBULL,
+  0xD106F86E69D785C7ULL, 0xE13336D701BEBA52ULL,
+  0x82A45B450226B39CULL, 0xECC0024661173473ULL,
+  0xA34D721642B06084ULL, 0x27F002D7F95D0190ULL,
+  0xCC20CE9BD35C78A5ULL, 0x31EC038DF7B441F4ULL,
+  0xFF290242C83396CEULL, 0x7E67047175A15271ULL,
+  0x9F79A169BD203E41ULL, 0x0F0062C6E984D386ULL,
+  0xC75809C42C684DD1ULL, 0x52C07B78A3E60868ULL,
+  0xF92E0C3537826145ULL, 0xA7709A56CCDF8A82ULL,
+  0x9BBCC7A142B17CCBULL, 0x88A66076400BB691ULL,
+  0xC2ABF989935DDBFEULL, 0x6ACFF893D00EA435ULL,
+  0xF356F7EBF83552FEULL, 0x0583F6B8C4124D43ULL,
+  0x98165AF37B2153DEULL, 0xC3727A337A8B704AULL,
+  0xBE1BF1B059E9A8D6ULL, 0x744F18C0592E4C5CULL,
+  0xEDA2EE1C7064130CULL, 0x1162DEF06F79DF73ULL,
+  0x9485D4D1C63E8BE7ULL, 0x8ADDCB5645AC2BA8ULL,
+  0xB9A74A0637CE2EE1ULL, 0x6D953E2BD7173692ULL,
+  0xE8111C87C5C1BA99ULL, 0xC8FA8DB6CCDD0437ULL,
+  0x910AB1D4DB9914A0ULL, 0x1D9C9892400A22A2ULL,
+  0xB54D5E4A127F59C8ULL, 0x2503BEB6D00CAB4BULL,
+  0xE2A0B5DC971F303AULL, 0x2E44AE64840FD61DULL,
+  0x8DA471A9DE737E24ULL, 0x5CEAECFED289E5D2ULL,
+  0xB10D8E1456105DADULL, 0x7425A83E872C5F47ULL,
+  0xDD50F1996B947518ULL, 0xD12F124E28F77719ULL,
+  0x8A5296FFE33CC92FULL, 0x82BD6B70D99AAA6FULL,
+  0xACE73CBFDC0BFB7BULL, 0x636CC64D1001550BULL,
+  0xD8210BEFD30EFA5AULL, 0x3C47F7E05401AA4EULL,
+  0x8714A775E3E95C78ULL, 0x65ACFAEC34810A71ULL,
+  0xA8D9D1535CE3B396ULL, 0x7F1839A741A14D0DULL,
+  0xD31045A8341CA07CULL, 0x1EDE48111209A050ULL,
+  0x83EA2B892091E44DULL, 0x934AED0AAB460432ULL,
+  0xA4E4B66B68B65D60ULL, 0xF81DA84D5617853FULL,
+  0xCE1DE40642E3F4B9ULL, 0x36251260AB9D668EULL,
+  0x80D2AE83E9CE78F3ULL, 0xC1D72B7C6B426019ULL,
+  0xA1075A24E4421730ULL, 0xB24CF65B8612F81FULL,
+  0xC94930AE1D529CFCULL, 0xDEE033F26797B627ULL,
+  0xFB9B7CD9A4A7443CULL, 0x169840EF017DA3B1ULL,
+  0x9D412E0806E88AA5ULL, 0x8E1F289560EE864EULL,
+  0xC491798A08A2AD4EULL, 0xF1A6F2BAB92A27E2ULL,
+  0xF5B5D7EC8ACB58A2ULL, 0xAE10AF696774B1DBULL,
+  0x9991A6F3D6BF1765ULL, 0xACCA6DA1E0A8EF29ULL,
+  0xBFF610B0CC6EDD3FULL, 0x17FD090A58D32AF3ULL,
+  0xEFF394DCFF8A948EULL, 0xDDFC4B4CEF07F5B0ULL,
+  0x95F83D0A1FB69CD9ULL, 0x4ABDAF101564F98EULL,
+  0xBB764C4CA7A4440FULL, 0x9D6D1AD41ABE37F1ULL,
+  0xEA53DF5FD18D5513ULL, 0x84C86189216DC5EDULL,
+  0x92746B9BE2F8552CULL, 0x32FD3CF5B4E49BB4ULL,
+  0xB7118682DBB66A77ULL, 0x3FBC8C33221DC2A1ULL,
+  0xE4D5E82392A40515ULL, 0x0FABAF3FEAA5334AULL,
+  0x8F05B1163BA6832DULL, 0x29CB4D87F2A7400EULL,
+  0xB2C71D5BCA9023F8ULL, 0x743E20E9EF511012ULL,
+  0xDF78E4B2BD342CF6ULL, 0x914DA9246B255416ULL,
+  0x8BAB8EEFB6409C1AULL, 0x1AD089B6C2F7548EULL,
+  0xAE9672ABA3D0C320ULL, 0xA184AC2473B529B1ULL,
+  0xDA3C0F568CC4F3E8ULL, 0xC9E5D72D90A2741EULL,
+  0x8865899617FB1871ULL, 0x7E2FA67C7A658892ULL,
+  0xAA7EEBFB9DF9DE8DULL, 0xDDBB901B98FEEAB7ULL,
+  0xD51EA6FA85785631ULL, 0x552A74227F3EA565ULL,
+  0x8533285C936B35DEULL, 0xD53A88958F87275FULL,
+  0xA67FF273B8460356ULL, 0x8A892ABAF368F137ULL,
+  0xD01FEF10A657842CULL, 0x2D2B7569B0432D85ULL,
+  0x8213F56A67F6B29BULL, 0x9C3B29620E29FC73ULL,
+  0xA298F2C501F45F42ULL, 0x8349F3BA91B47B8FULL,
+  0xCB3F2F7642717713ULL, 0x241C70A936219A73ULL,
+  0xFE0EFB53D30DD4D7ULL, 0xED238CD383AA0110ULL,
+  0x9EC95D1463E8A506ULL, 0xF4363804324A40AAULL,
+  0xC67BB4597CE2CE48ULL, 0xB143C6053EDCD0D5ULL,
+  0xF81AA16FDC1B81DAULL, 0xDD94B7868E94050AULL,
+  0x9B10A4E5E9913128ULL, 0xCA7CF2B4191C8326ULL,
+  0xC1D4CE1F63F57D72ULL, 0xFD1C2F611F63A3F0ULL,
+  0xF24A01A73CF2DCCFULL, 0xBC633B39673C8CECULL,
+  0x976E41088617CA01ULL, 0xD5BE0503E085D813ULL,
+  0xBD49D14AA79DBC82ULL, 0x4B2D8644D8A74E18ULL,
+  0xEC9C459D51852BA2ULL, 0xDDF8E7D60ED1219EULL,
+  0x93E1AB8252F33B45ULL, 0xCABB90E5C942B503ULL,
+  0xB8DA1662E7B00A17ULL, 0x3D6A751F3B936243ULL,
+  0xE7109BFBA19C0C9DULL, 0x0CC512670A783AD4ULL,
+  0x906A617D450187E2ULL, 0x27FB2B80668B24C5ULL,
+  0xB484F9DC9641E9DAULL, 0xB1F9F660802DEDF6ULL,
+  0xE1A63853BBD26451ULL, 0x5E7873F8A0396973ULL,
+  0x8D07E33455637EB2ULL, 0xDB0B487B6423E1E8ULL,
+  0xB049DC016ABC5E5FULL, 0x91CE1A9A3D2CDA62ULL,
+  0xDC5C5301C56B75F7ULL, 0x7641A140CC7810FBULL,
+  0x89B9B3E11B6329BAULL, 0xA9E904C87FCB0A9DULL,
+  0xAC2820D9623BF429ULL, 0x546345FA9FBDCD44ULL,
+  0xD732290FBACAF133ULL, 0xA97C177947AD4095ULL,
+  0x867F59A9D4BED6C0ULL, 0x49ED8EABCCCC485DULL,
+  0xA81F301449EE8C70ULL, 0x5C68F256BFFF5A74ULL,
+  0xD226FC195C6A2F8CULL, 0x73832EEC6FFF3111ULL,
+  0x83585D8FD9C25DB7ULL, 0xC831FD53C5FF7EABULL,
+  0xA42E74F3D032F525ULL, 0xBA3E7CA8B77F5E55ULL,
+  0xCD3A1230C43FB26FULL, 0x28CE1BD2E55F35EBULL,
+  0x80444B5E7AA7CF85ULL, 0x7980D163CF5B81B3ULL,
+  0xA0555E361951C366ULL, 0xD7E105BCC332621FULL,
+  0xC86AB5C39FA63440ULL, 0x8DD9472BF3FEFAA7ULL,
+  0xFA856334878FC150ULL, 0xB14F98F6F0FEB951ULL,
+  0x9C935E00D4B9D8D2ULL, 0x6ED1BF9A569F33D3ULL,
+  0xC3B8358109E84F07ULL, 0x0A862F80EC4700C8ULL,
+  0xF4A642E14C6262C8ULL, 0xCD27BB612758C0FAULL,
+  0x98E7E9CCCFBD7DBDULL, 0x8038D51CB897789CULL,
+  0xBF21E44003ACDD2CULL, 0xE0470A63E6BD56C3ULL,
+  0xEEEA5D5004981478ULL, 0x1858CCFCE06CAC74ULL,
+  0x95527A5202DF0CCBULL, 0x0F37801E0C43EBC8ULL,
+  0xBAA718E68396CFFDULL, 0xD30560258F54E6BAULL,
+  0xE950DF20247C83FDULL, 0x47C6B82EF32A2069ULL,
+  0x91D28B7416CDD27EULL, 0x4CDC331D57FA5441ULL,
+  0xB6472E511C81471DULL, 0xE0133FE4ADF8E952ULL,
+  0xE3D8F9E563A198E5ULL, 0x58180FDDD97723A6ULL,
+  0x8E679C2F5E44FF8FULL, 0x570F09EAA7EA7648ULL,
+};
+
+// Powers of ten that are exact in binary64, for the Clinger fast path
+static const double exact_powers_of_ten[23] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// High and low halves of a * b
+static inline unsigned long long mul_128(unsigned long long a, unsigned long long b, unsigned long long* low) {
+#if defined(__SIZEOF_INT128__)
+  __extension__ unsigned __int128 r = (unsigned __int128)a * b;
+  *low = (unsigned long long)r;
+  return (unsigned long long)(r >> 64);
+#else
+  unsigned long long a_lo = a & 0xFFFFFFFFu, a_hi = a >> 32;
+  unsigned long long b_lo = b & 0xFFFFFFFFu, b_hi = b >> 32;
+  unsigned long long p0 = a_lo * b_lo, p1 = a_lo * b_hi, p2 = a_hi * b_lo, p3 = a_hi * b_hi;
+  unsigned long long mid = (p0 >> 32) + (p1 & 0xFFFFFFFFu) + (p2 & 0xFFFFFFFFu);
+  *low = (mid << 32) | (p0 & 0xFFFFFFFFu);
+  return p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+#endif
+}
+
+// Eisel-Lemire: the bits of the binary64 closest to w * 10^q, without the sign.
+// The 128-bit product is always precise enough when w holds every digit of the number.
+static unsigned long long eisel_lemire(unsigned long long w, long long q) {
+  if (w == 0 || q < -342) {
+    return 0;
+  }
+  if (q > 308) {
+    return 0x7FFULL << 52;
+  }
+
+  int lz = clz64(w);
+  w <<= lz;
+
+  const unsigned long long* power = &powers_of_five[2 * (q + 342)];
+  unsigned long long low;
+  unsigned long long high = mul_128(w, power[0], &low);
+
+  // Only the top 55 bits are needed, the second half matters when the rest are all ones
+  if ((high & 0x1FF) == 0x1FF) {
+    unsigned long long low2;
+    unsigned long long high2 = mul_128(w, power[1], &low2);
+    low += high2;
+    if (high2 > low) {
+      high++;
+    }
+  }
+
+  int upperbit = (int)(high >> 63);
+  int shift = upperbit + 64 - 52 - 3;
+  unsigned long long mantissa = high >> shift;
+  // floor(log2(10^q)) + 63, with an arithmetic shift
+  int power2 = (int)(((152170 + 65536) * q) >> 16) + 63 + upperbit - lz + 1023;
+
+  if (power2 <= 0) {
+    // Subnormal, or zero when even the last mantissa bit is shifted out
+    if (-power2 + 1 >= 64) {
+      return 0;
+    }
+    mantissa >>= -power2 + 1;
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    // Rounding up can carry into the smallest normal number
+    power2 = mantissa < (1ULL << 52) ? 0 : 1;
+    return mantissa | ((unsigned long long)power2 << 52);
+  }
+
+  // Exactly halfway between two floats can only happen for small q, where 5^q is exact.
+  // Round to even instead of up.
+  if (low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == high) {
+    mantissa &= ~1ULL;
+  }
+
+  mantissa += mantissa & 1;
+  mantissa >>= 1;
+  if (mantissa >= (2ULL << 52)) {
+    mantissa = 1ULL << 52;
+    power2++;
+  }
+  mantissa &= ~(1ULL << 52);
+
+  if (power2 >= 0x7FF) {
+    return 0x7FFULL << 52;
+  }
+  return mantissa | ((unsigned long long)power2 << 52);
+}
+
+static inline double bits_to_double(unsigned long long bits, int negative) {
+  double d;
+  bits |= (unsigned long long)negative << 63;
+  memcpy(&d, &bits, sizeof(d));
+  return d;
+}
+
+static inline int is_digit(int c) {
+  return (unsigned)(c - '0') < 10;
+}
+
+// Reads an exponent, which only counts when at least one digit follows the marker and sign
+static const char* parse_exponent(const char* s, const char* end, long long* exponent) {
+  const char* t = s + 1;
+  int negative = 0;
+  long long e = 0;
+
+  if (t < end && (*t == '+' || *t == '-')) {
+    negative = (*t == '-');
+    t++;
+  }
+  if (t >= end || !is_digit(*t)) {
+    return s;
+  }
+
+  for (; t < end && is_digit(*t); t++) {
+    // Anything this large already overflows or underflows, keep it from wrapping
+    if (e < 100000000) {
+      e = e * 10 + (*t - '0');
+    }
+  }
+
+  *exponent = negative ? -e : e;
+  return t;
+}
+
+// Slow path for decimals with more than 19 significant digits that Eisel-Lemire cannot settle.
+// strtod is given the digits without a decimal point, so the locale does not matter, and
+// 768 digits plus a sticky one are enough to round any binary64 correctly.
+static double decimal_fallback(const char* s, const char* end, long long exponent) {
+  char buf[768 + 2 + 24];
+  size_t n = 0;
+  int point = 0, sticky = 0;
+
+  for (; s < end; s++) {
+    if (*s == '.') {
+      point = 1;
+      continue;
+    }
+    if (n == 0 && *s == '0') {
+      exponent -= point;
+      continue;
+    }
+    if (n < 768) {
+      buf[n++] = *s;
+      exponent -= point;
+    }
+    else {
+      sticky |= (*s != '0');
+      exponent += !point;
+    }
+  }
+
+  if (n == 0) {
+    return 0.0;
+  }
+  if (sticky) {
+    buf[n++] = '1';
+    exponent--;
+  }
+  snprintf(buf + n, sizeof(buf) - n, "e%lld", exponent);
+  return strtod(buf, NULL);
+}
+
+// Hexadecimal floats are rare, so they are normalized to digits without a point and handed to strtod
+static const char* parse_hex_float(const char* s, const char* end, int negative, double* value) {
+  char buf[2 + 24 + 1 + 24];
+  size_t n = 2;
+  long long exponent = 0, binary_exponent = 0;
+  int point = 0, sticky = 0;
+
+  buf[0] = '0';
+  buf[1] = 'x';
+
+  for (; s < end; s++) {
+    if (*s == '.' && !point) {
+      point = 1;
+      continue;
+    }
+    unsigned d = digit_values[(unsigned char)*s];
+    if (d >= 16) {
+      break;
+    }
+    if (n == 2 && d == 0) {
+      exponent -= 4 * point;
+      continue;
+    }
+    // 24 hex digits are far more than a binary64 mantissa holds
+    if (n < 2 + 24) {
+      buf[n++] = *s;
+      exponent -= 4 * point;
+    }
+    else {
+      sticky |= (d != 0);
+      exponent += 4 * !point;
+    }
+  }
+
+  if (s < end && (*s | 0x20) == 'p') {
+    s = parse_exponent(s, end, &binary_exponent);
+  }
+
+  if (n == 2) {
+    buf[n++] = '0';
+  }
+  if (sticky) {
+    buf[n++] = '1';
+    exponent -= 4;
+  }
+  snprintf(buf + n, sizeof(buf) - n, "p%lld", exponent + binary_exponent);
+
+  double d = strtod(buf, NULL);
+  *value = negative ? -d : d;
+  return s;
+}
+
+static int match_word(const char* s, const char* end, const char* word) {
+  size_t n = strlen(word);
+  if ((size_t)(end - s) < n) {
+    return 0;
+  }
+  for (size_t i = 0; i < n; i++) {
+    if ((s[i] | 0x20) != word[i]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static const char* parse_inf_nan(const char* start, const char* s, const char* end, int negative, double* value) {
+  if (match_word(s, end, "inf")) {
+    s += 3;
+    if (match_word(s, end, "inity")) {
+      s += 5;
+    }
+    *value = bits_to_double(0x7FFULL << 52, negative);
+    return s;
+  }
+
+  if (match_word(s, end, "nan")) {
+    const char* begin = s;
+    s += 3;
+
+    if (s < end && *s == '(') {
+      const char* t = s + 1;
+      while (t < end && class_has(&identifier_class, *t)) {
+        t++;
+      }
+      if (t < end && *t == ')') {
+        s = t + 1;
+      }
+    }
+
+    // Let strtod decode the payload, so the bits are the same as it would return.
+    // A payload too long for the stack goes on the heap.
+    char stack[64];
+    char* buf = stack;
+    size_t n = s - begin;
+    if (n >= sizeof(stack) && !(buf = malloc(n + 1))) {
+      return start;
+    }
+    memcpy(buf, begin, n);
+    buf[n] = 0;
+    double d = strtod(buf, NULL);
+    if (buf != stack) {
+      free(buf);
+    }
+    *value = negative ? -d : d;
+    return s;
+  }
+
+  return start;
+}
+
+// Parses a float with the same grammar and result as strtod in the "C" locale, never reading
+// past `end`. Returns the end of the number, which is `s` when there is no number.
+static const char* parse_float(const char* s, const char* end, unsigned flags, double* value) {
+  const char* start = s;
+
+  while (s < end && is_c_space(*s)) {
+    s++;
+  }
+
+  int negative = 0;
+  if (s < end && (*s == '+' || *s == '-')) {
+    negative = (*s == '-');
+    s++;
+  }
+  if (s >= end) {
+    return start;
+  }
+
+  if ((*s | 0x20) == 'i' || (*s | 0x20) == 'n') {
+    if (flags & GREX_FLOAT_NO_INF_NAN) {
+      return start;
+    }
+    return parse_inf_nan(start, s, end, negative, value);
+  }
+
+  if (end - s >= 3 && s[0] == '0' && (s[1] | 0x20) == 'x' &&
+      (digit_values[(unsigned char)s[2]] < 16 ||
+       (s[2] == '.' && end - s >= 4 && digit_values[(unsigned char)s[3]] < 16))) {
+    if (flags & GREX_FLOAT_NO_HEX) {
+      return start;
+    }
+    return parse_hex_float(s + 2, end, negative, value);
+  }
+
+  // The first 19 significant digits go into w, the value is w * 10^q
+  const char* mantissa = s;
+  unsigned long long w = 0;
+  long long q = 0;
+  int count = 0, truncated = 0, any = 0;
+
+  for (; s < end && is_digit(*s); s++) {
+    any = 1;
+    if (count == 0 && *s == '0') {
+      continue;
+    }
+    if (count + 8 <= 19 && count > 0 && end - s >= 8) {
+      unsigned long long chunk = load_le64(s);
+      if (leading_digits(chunk) == 8) {
+        w = w * 100000000ULL + eight_digits_value(chunk);
+        count += 8;
+        s += 7;
+        continue;
+      }
+    }
+    if (count < 19) {
+      w = w * 10 + (*s - '0');
+      count++;
+    }
+    else {
+      truncated |= (*s != '0');
+      q++;
+    }
+  }
+
+  if (s < end && *s == '.') {
+    s++;
+    for (; s < end && is_digit(*s); s++) {
+      any = 1;
+      if (count == 0 && *s == '0') {
+        q--;
+        continue;
+      }
+      if (count + 8 <= 19 && count > 0 && end - s >= 8) {
+        unsigned long long chunk = load_le64(s);
+        if (leading_digits(chunk) == 8) {
+          w = w * 100000000ULL + eight_digits_value(chunk);
+          count += 8;
+          q -= 8;
+          s += 7;
+          continue;
+        }
+      }
+      if (count < 19) {
+        w = w * 10 + (*s - '0');
+        count++;
+        q--;
+      }
+      else {
+        truncated |= (*s != '0');
+      }
+    }
+  }
+
+  if (!any) {
+    return start;
+  }
+
+  const char* mantissa_end = s;
+  long long exponent = 0;
+  if (s < end && (*s | 0x20) == 'e') {
+    s = parse_exponent(s, end, &exponent);
+  }
+  q += exponent;
+
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+  // Clinger: both operands are exact, so one correctly rounded operation gives the answer
+  if (!truncated && w <= (1ULL << 53) && q >= -22 && q <= 22) {
+    double d = (double)w;
+    d = q < 0 ? d / exact_powers_of_ten[-q] : d * exact_powers_of_ten[q];
+    *value = negative ? -d : d;
+    return s;
+  }
+#endif
+
+  unsigned long long bits = eisel_lemire(w, q);
+
+  // With dropped digits the value lies between w and w + 1, if both round the same way that is the answer
+  if (truncated && bits != eisel_lemire(w + 1, q)) {
+    double d = decimal_fallback(mantissa, mantissa_end, exponent);
+    *value = negative ? -d : d;
+    return s;
+  }
+
+  *value = bits_to_double(bits, negative);
+  return s;
+}
+
+grex_result_t GREX_IMPL(grex_float_ex)(grex_parser_t* p, double* value, unsigned flags) {
+  GREX_EOF_CHECK(p);
+  load_number(p);
+
+  const char* str = &p->input[p->parsing_offset];
+  const char* endptr = parse_float(str, p->input_end, flags, value);
+
+  if (endptr > str) {
+    p->parsing_offset = endptr - p->input;
+    return GREX_OK;
+  }
+
+  report_error(p, GREX_PRIMITIVE_FLOAT);
+  return GREX_NO_MATCH;
+}
+
+grex_result_t GREX_IMPL(grex_float)(grex_parser_t* p, double* value) {
+  return grex_float_ex(p, value, 0);
+}
+
+static void set_span(grex_span_t* span, const char* begin, const char* end, unsigned flags) {
+  span->ptr = begin;
+  span->len = end - begin;
+  span->flags = flags;
+}
+
+// Copies a span into a null-terminated buffer, truncating it to size - 1 characters
+static void copy_span(const grex_span_t* span, char* buf, unsigned size) {
+  if (size == 0) {
+    return;
+  }
+
+  size_t n = span->len;
+  if (n >= size) {
+    n = size - 1;
+  }
+  memcpy(buf, span->ptr, n);
+  buf[n] = 0;
+}
+
+grex_result_t GREX_IMPL(grex_identifier_span)(grex_parser_t* p, grex_span_t* span) {
+  GREX_EOF_CHECK(p);
+
+  if (!class_has(&identifier_start_class, cur(p))) {
+    report_error(p, GREX_PRIMITIVE_IDENTIFIER);
+    return GREX_NO_MATCH;
+  }
+
+  size_t s = p->parsing_offset + 1;
+  const char* end;
+
+  while ((end = class_scan(&identifier_class, &p->input[s], p->input_end, 1)) == p->input_end) {
+    if (!scan_refill(p, &s, span)) {
+      end = p->input_end;
+      break;
+    }
+  }
+
+  set_span(span, &p->input[p->parsing_offset], end, 0);
+  p->parsing_offset = end - p->input;
+  return GREX_OK;
+}
+
+grex_result_t GREX_IMPL(grex_identifier)(grex_parser_t* p, char* buf, unsigned size) {
+  grex_span_t span;
+
+  int result = grex_identifier_span(p, &span);
+
+  if (result == GREX_OK) {
+    copy_span(&span, buf, size);
+  }
+
+  return result;
+}
+
+grex_result_t GREX_IMPL(grex_identifier_alloc)(grex_parser_t* p, grex_span_t* span) {
+  grex_mark_t mark;
+  grex_parser_mark(p, &mark);
+  return alloc_result(p, &mark, grex_identifier_span(p, span), span);
+}
+
+grex_result_t GREX_IMPL(grex_identifier_intern)(grex_parser_t* p, unsigned* id, grex_span_t* span) {
+  if (!p->intern || !p->intern->slots) {
+    return GREX_ALLOC_ERR;
+  }
+
+  GREX_EOF_CHECK(p);
+
+  unsigned char c = cur(p);
+  if (!class_has(&identifier_start_class, c)) {
+    report_error(p, GREX_PRIMITIVE_IDENTIFIER);
+    return GREX_NO_MATCH;
+  }
+
+  // Identifiers are short, so a scalar loop that hashes as it matches beats a vector scan and a second pass
+  unsigned h = intern_hash_step(GREX_INTERN_SEED, c);
+  size_t s = p->parsing_offset + 1;
+  for (;;) {
+    const unsigned char* t = (const unsigned char*)&p->input[s];
+    const unsigned char* end = (const unsigned char*)p->input_end;
+    while (t < end && class_has(&identifier_class, *t)) {
+      h = intern_hash_step(h, *t++);
+    }
+    s = (const char*)t - p->input;
+    if (t < end || !scan_refill(p, &s, span)) {
+      break;
+    }
+  }
+
+  const char* str = &p->input[p->parsing_offset];
+  grex_result_t result = intern_insert(p->intern, str, &p->input[s] - str, h, id);
+  if (result != GREX_OK) {
+    return result;
+  }
+
+  *span = p->intern->names[*id];
+  p->parsing_offset = s;
+  return GREX_OK;
+}
+
+static grex_result_t parse_string(grex_parser_t* p, int delim, grex_span_t* span) {
+  GREX_EOF_CHECK(p);
+
+  if (cur(p) != delim) {
+    return GREX_NO_MATCH;
+  }
+
+  size_t s = p->parsing_offset + 1;
+  unsigned char stops[2] = { (unsigned char)delim, '\\' };
+  unsigned flags = 0;
+
+  // The index already knows which delimiters are escaped, so the closing one is the first that isn't
+  if (structural_covers(p, stops, 2)) {
+    for (;;) {
+      s = structural_next(p, s);
+      if (s == p->input_length) {
+        if (!scan_refill(p, &s, span)) {
+          return GREX_EOF;
+        }
+        continue;
+      }
+
+      if (p->input[s] == '\\') {
+        flags |= GREX_SPAN_ESCAPED;
+      }
+      else if ((unsigned char)p->input[s] == (unsigned char)delim && !structural_is_escaped(p, s)) {
+        break;
+      }
+      s++;
+    }
+
+    set_span(span, &p->input[p->parsing_offset + 1], &p->input[s], flags);
+    p->parsing_offset = s + 1;
+    return GREX_OK;
+  }
+
+  for (;;) {
+    const char* stop = bytes_scan(&p->input[s], p->input_end, stops, 2);
+    if (stop == p->input_end) {
+      if (!scan_refill(p, &s, span)) {
+        return GREX_EOF;
+      }
+      continue;
+    }
+
+    s = stop - p->input;
+    if (*stop == delim) {
+      break;
+    }
+
+    // A backslash escapes whatever character follows it
+    flags |= GREX_SPAN_ESCAPED;
+    while (p->input_length - s <= 2) {
+      if (!refill(p, &s)) {
+        return GREX_EOF;
+      }
+    }
+    s += 2;
+  }
+
+  // consume end delimiter
+  set_span(span, &p->input[p->parsing_offset + 1], &p->input[s], flags);
+  p->parsing_offset = s + 1;
+  return GREX_OK;
+}
+
+// The longest escape after its backslash: a surrogate pair, uD83D\uDE00
+#define GREX_ESCAPE_MAX 11
+
+// Reads up to `digits` hexadecimal digits from [s, end), setting *count to how many were read
+static unsigned long read_hex(const unsigned char* s, const unsigned char* end, size_t digits, size_t* count) {
+  unsigned long value = 0;
+  size_t n = 0;
+
+  while (n < digits && s + n < end && digit_values[s[n]] < 16) {
+    value = value * 16 + digit_values[s[n]];
+    n++;
+  }
+  *count = n;
+  return value;
+}
+
+static size_t utf8_encode(unsigned long cp, char* out) {
+  if (cp < 0x80) {
+    out[0] = (char)cp;
+    return 1;
+  }
+  if (cp < 0x800) {
+    out[0] = (char)(0xC0 | (cp >> 6));
+    out[1] = (char)(0x80 | (cp & 0x3F));
+    return 2;
+  }
+  if (cp < 0x10000) {
+    out[0] = (char)(0xE0 | (cp >> 12));
+    out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[2] = (char)(0x80 | (cp & 0x3F));
+    return 3;
+  }
+  out[0] = (char)(0xF0 | (cp >> 18));
+  out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+  out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+  out[3] = (char)(0x80 | (cp & 0x3F));
+  return 4;
+}
+
+// Decodes the escape that follows a backslash, in [s, end), into out (4 characters at most).
+// Returns how many characters after the backslash it used and sets *written.
+// An unknown escape keeps the backslash and the character, a backslash at the end is kept alone.
+static size_t decode_escape(const unsigned char* s, const unsigned char* end, int delim, char* out, size_t* written) {
+  static const char simple[][2] = {
+    { 'n', '\n' }, { 't', '\t' }, { 'r', '\r' }, { 'b', '\b' }, { 'f', '\f' }, { 'v', '\v' }, { 'a', '\a' },
+    { '\\', '\\' }, { '"', '"' }, { '\'', '\'' }, { '/', '/' }, { '?', '?' },
+  };
+
+  *written = 1;
+  if (s == end) {
+    out[0] = '\\';
+    return 0;
+  }
+
+  unsigned char c = *s;
+  for (size_t i = 0; i < sizeof(simple) / sizeof(simple[0]); i++) {
+    if (c == (unsigned char)simple[i][0]) {
+      out[0] = simple[i][1];
+      return 1;
+    }
+  }
+
+  size_t n;
+  if (c >= '0' && c <= '7') {
+    unsigned value = 0;
+    for (n = 0; n < 3 && s + n < end && s[n] >= '0' && s[n] <= '7'; n++) {
+      value = value * 8 + (s[n] - '0');
+    }
+    out[0] = (char)(value & 0xFF);
+    return n;
+  }
+
+  if (c == 'x') {
+    unsigned long value = read_hex(s + 1, end, 2, &n);
+    if (n) {
+      out[0] = (char)value;
+      return 1 + n;
+    }
+  }
+
+  if (c == 'u' || c == 'U') {
+    size_t digits = c == 'u' ? 4 : 8;
+    unsigned long cp = read_hex(s + 1, end, digits, &n);
+    if (n == digits) {
+      size_t used = 1 + n;
+
+      // A high surrogate takes the low surrogate that follows it
+      if (c == 'u' && cp >= 0xD800 && cp < 0xDC00 && end - (s + used) >= 6 && s[used] == '\\' && s[used + 1] == 'u') {
+        unsigned long low = read_hex(s + used + 2, end, 4, &n);
+        if (n == 4 && low >= 0xDC00 && low < 0xE000) {
+          cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+          used += 6;
+        }
+      }
+
+      // Lone surrogates and code points past Unicode become the replacement character
+      if ((cp >= 0xD800 && cp < 0xE000) || cp > 0x10FFFF) {
+        cp = 0xFFFD;
+      }
+      *written = utf8_encode(cp, out);
+      return used;
+    }
+  }
+
+  if (c == (unsigned char)delim) {
+    out[0] = (char)delim;
+    return 1;
+  }
+
+  out[0] = '\\';
+  out[1] = (char)c;
+  *written = 2;
+  return 1;
+}
+
+// Appends n characters to the buffer while they fit, returns the new length
+static inline size_t append(char* buf, size_t size, size_t length, const char* s, size_t n) {
+  if (length < size) {
+    memcpy(buf + length, s, n < size - length ? n : size - length);
+  }
+  return length + n;
+}
+
+size_t grex_span_unescape(const grex_span_t* span, int delim, char* buf, size_t size) {
+  const unsigned char* s = (const unsigned char*)span->ptr;
+  const unsigned char* end = s + span->len;
+  size_t room = size ? size - 1 : 0;
+  size_t n = 0;
+
+  while (s < end) {
+    const unsigned char* escape = end;
+    if (span->flags & GREX_SPAN_ESCAPED) {
+      escape = memchr(s, '\\', end - s);
+      if (!escape) {
+        escape = end;
+      }
+    }
+
+    // Copy the run up to the next backslash in one go
+    n = append(buf, room, n, (const char*)s, escape - s);
+    s = escape;
+
+    if (s < end) {
+      char out[4];
+      size_t written;
+      s += 1 + decode_escape(s + 1, end, delim, out, &written);
+      n = append(buf, room, n, out, written);
+    }
+  }
+
+  if (size > 0) {
+    buf[n < room ? n : room] = 0;
+  }
+  return n;
+}
+
+grex_result_t GREX_IMPL(grex_delimited_string_span)(grex_parser_t* p, int delim, grex_span_t* span) {
+  grex_mark_t mark;
+  grex_parser_mark(p, &mark);
+
+  int result = parse_string(p, delim, span);
+
+  if (result != GREX_OK) {
+    grex_parser_rewind(p, &mark);
+    report_error(p, GREX_PRIMITIVE_STRING);
+  }
+  grex_parser_release(p, &mark);
+
+  return result;
+}
+
+grex_result_t GREX_IMPL(grex_single_quoted_string_span)(grex_parser_t* p, grex_span_t* span) {
+  return grex_delimited_string_span(p, '\'', span);
+}
+
+grex_result_t GREX_IMPL(grex_double_quoted_string_span)(grex_parser_t* p, grex_span_t* span) {
+  return grex_delimited_string_span(p, '"', span);
+}
+
+grex_result_t GREX_IMPL(grex_string_span)(grex_parser_t* p, grex_span_t* span) {
+  int result = grex_double_quoted_string_span(p, span);
+  if (result == GREX_OK) {
+    return result;
+  }
+
+  result = grex_single_quoted_string_span(p, span);
+  return result;
+}
+
+grex_result_t GREX_IMPL(grex_delimited_string)(grex_parser_t* p, int delim, char* buf, unsigned size) {
+  grex_span_t span;
+
+  int result = grex_delimited_string_span(p, delim, &span);
+
+  if (result == GREX_OK && size > 0) {
+    grex_span_unescape(&span, delim, buf, size);
+  }
+
+  return result;
+}
+
+grex_result_t GREX_IMPL(grex_single_quoted_string)(grex_parser_t* p, char* buf, unsigned size) {
+  return grex_delimited_string(p, '\'', buf, size);
+}
+
+grex_result_t GREX_IMPL(grex_double_quoted_string)(grex_parser_t* p, char* buf, unsigned size) {
+  return grex_delimited_string(p, '"', buf, size);
+}
+
+grex_result_t GREX_IMPL(grex_string)(grex_parser_t* p, char* buf, unsigned size) {
+  int result = grex_double_quoted_string(p, buf, size);
+  if (result == GREX_OK) {
+    return result;
+  }
+
+  result = grex_single_quoted_string(p, buf, size);
+  return result;
+}
+
+grex_result_t GREX_IMPL(grex_delimited_string_decode)(grex_parser_t* p, int delim, char* buf, size_t size, grex_span_t* span) {
+  GREX_EOF_CHECK(p);
+
+  if (cur(p) != delim) {
+    report_error(p, GREX_PRIMITIVE_STRING);
+    return GREX_NO_MATCH;
+  }
+
+  // The mark keeps the string in the window, for the zero-copy span and for giving up
+  grex_mark_t mark;
+  grex_parser_mark(p, &mark);
+
+  unsigned char stops[2] = { (unsigned char)delim, '\\' };
+  int indexed = structural_covers(p, stops, 2);
+  size_t s = p->parsing_offset + 1;
+  size_t run = s;
+  size_t n = 0;
+  int escaped = 0;
+  grex_result_t result = GREX_OK;
+
+  for (;;) {
+    const char* stop = indexed ? structural_scan(p, s, stops, 2) : bytes_scan(&p->input[s], p->input_end, stops, 2);
+    if (stop == p->input_end) {
+      // Refilling moves the window, the run is found again from the distance to the head
+      size_t behind = run - p->parsing_offset;
+      s = p->input_length;
+      if (!refill(p, &s)) {
+        result = GREX_EOF;
+        break;
+      }
+      run = p->parsing_offset + behind;
+      continue;
+    }
+
+    s = stop - p->input;
+    if (*stop != '\\') {
+      break;
+    }
+
+    // The whole escape must be in the window, and a backslash must be followed by something
+    size_t behind = run - p->parsing_offset;
+    while (p->input_length - s <= GREX_ESCAPE_MAX && refill(p, &s)) {
+    }
+    run = p->parsing_offset + behind;
+    if (s + 1 == p->input_length) {
+      result = GREX_EOF;
+      break;
+    }
+
+    // Copy the run before the backslash in one go, then what the escape stands for
+    char out[4];
+    size_t written;
+    // The escape can't go past the closing delimiter, which may be a digit
+    size_t end = s + 2;
+    while (end < p->input_length && end <= s + GREX_ESCAPE_MAX && (unsigned char)p->input[end] != (unsigned char)delim) {
+      end++;
+    }
+
+    n = append(buf, size, n, &p->input[run], s - run);
+    s += 1 + decode_escape((const unsigned char*)&p->input[s + 1], (const unsigned char*)&p->input[end], delim, out, &written);
+    n = append(buf, size, n, out, written);
+    run = s;
+    escaped = 1;
+  }
+
+  if (result == GREX_OK) {
+    if (!escaped) {
+      span->ptr = &p->input[run];
+      span->len = s - run;
+      span->flags = 0;
+    }
+    else {
+      n = append(buf, size, n, &p->input[run], s - run);
+      span->ptr = buf;
+      span->len = n;
+      span->flags = 0;
+      if (n < size) {
+        buf[n] = 0;
+      }
+      else if (n > size) {
+        result = GREX_RANGE_ERR;
+      }
+    }
+  }
+
+  if (result == GREX_OK) {
+    p->parsing_offset = s + 1;
+  }
+  else {
+    grex_parser_rewind(p, &mark);
+    if (result == GREX_EOF) {
+      report_error(p, GREX_PRIMITIVE_STRING);
+    }
+  }
+  grex_parser_release(p, &mark);
+  return result;
+}
+
+grex_result_t GREX_IMPL(grex_string_decode)(grex_parser_t* p, char* buf, size_t size, grex_span_t* span) {
+  int result = grex_delimited_string_decode(p, '"', buf, size, span);
+  if (result == GREX_OK || result == GREX_RANGE_ERR) {
+    return result;
+  }
+
+  return grex_delimited_string_decode(p, '\'', buf, size, span);
+}
+
+grex_result_t GREX_IMPL(grex_delimited_string_alloc)(grex_parser_t* p, int delim, grex_span_t* span) {
+  grex_arena_t* a = p->arena;
+  if (!a) {
+    return GREX_ALLOC_ERR;
+  }
+
+  // Unescape straight into the free end of the current block, then keep only what the string took
+  char* room = a->current ? arena_data(a->current) + a->current->used : NULL;
+  size_t available = a->current ? a->current->size - a->current->used : 0;
+
+  grex_mark_t mark;
+  grex_parser_mark(p, &mark);
+  grex_result_t result = grex_delimited_string_decode(p, delim, room, available, span);
+
+  if (result == GREX_OK && span->ptr == room && span->len < available) {
+    a->current->used += span->len + 1;
+  }
+  else if (result == GREX_OK && span->ptr != room) {
+    // Not escaped, so the span is still the input
+    if ((result = arena_copy(p, span)) != GREX_OK) {
+      grex_parser_rewind(p, &mark);
+    }
+  }
+  else if (result == GREX_OK || result == GREX_RANGE_ERR) {
+    // The string needs a block with more room, and it is unescaped again there
+    grex_parser_rewind(p, &mark);
+    size_t size = span->len + 1;
+    char* buf = arena_bump(a, size, 1);
+    result = buf ? grex_delimited_string_decode(p, delim, buf, size, span) : GREX_ALLOC_ERR;
+  }
+
+  grex_parser_release(p, &mark);
+  return result;
+}
+
+grex_result_t GREX_IMPL(grex_string_alloc)(grex_parser_t* p, grex_span_t* span) {
+  int result = grex_delimited_string_alloc(p, '"', span);
+  if (result == GREX_OK || result == GREX_ALLOC_ERR) {
+    return result;
+  }
+
+  return grex_delimited_string_alloc(p, '\'', span);
+}
+
+grex_result_t GREX_IMPL(grex_capture_until_span)(grex_parser_t* p, int c, grex_span_t* span) {
+  unsigned char byte = (unsigned char)c;
+  return scan_bytes(p, &byte, 1, span, GREX_PRIMITIVE_UNTIL);
+}
+
+grex_result_t GREX_IMPL(grex_capture_until_alloc)(grex_parser_t* p, int c, grex_span_t* span) {
+  grex_mark_t mark;
+  grex_parser_mark(p, &mark);
+  return alloc_result(p, &mark, grex_capture_until_span(p, c, span), span);
+}
+
+grex_result_t GREX_IMPL(grex_capture_until_any_span)(grex_parser_t* p, const char* set, grex_span_t* span) {
+  return until_any(p, set, span);
+}
+
+grex_result_t GREX_IMPL(grex_capture_until_any_alloc)(grex_parser_t* p, const char* set, grex_span_t* span) {
+  grex_mark_t mark;
+  grex_parser_mark(p, &mark);
+  return alloc_result(p, &mark, until_any(p, set, span), span);
+}
+
+grex_result_t GREX_IMPL(grex_capture_until)(grex_parser_t* p, int c, char* buf, unsigned size) {
+  grex_span_t span;
+
+  int result = grex_capture_until_span(p, c, &span);
+
+  if (result == GREX_OK) {
+    copy_span(&span, buf, size);
+  }
+
+  return result;
+}
+
+grex_result_t GREX_IMPL(grex_capture_until_any)(grex_parser_t* p, const char* set, char* buf, unsigned size) {
+  grex_span_t span;
+
+  int result = grex_capture_until_any_span(p, set, &span);
+
+  if (result == GREX_OK) {
+    copy_span(&span, buf, size);
+  }
+
+  return result;
+}
+
+enum {
+  PATTERN_CHAR,
+  PATTERN_SEQUENCE,
+  PATTERN_CLASS,
+  PATTERN_WHILE_CLASS,
+  PATTERN_UNTIL_BYTES,
+  PATTERN_UNTIL_CLASS,
+  PATTERN_UNTIL_SEQUENCE,
+  PATTERN_INTEGER,
+  PATTERN_FLOAT,
+  PATTERN_IDENTIFIER,
+  PATTERN_STRING,
+  PATTERN_CAPTURE_BEGIN,
+  PATTERN_CAPTURE_END,
+};
+
+void grex_pattern_init(grex_pattern_t* pat) {
+  memset(pat, 0, sizeof(*pat));
+}
+
+void grex_pattern_destroy(grex_pattern_t* pat) {
+  free(pat->ops);
+  free(pat->classes);
+  free(pat->text);
+  free(pat->needles);
+  memset(pat, 0, sizeof(*pat));
+}
+
+// Grows one of the pattern arrays to fit one more element, or count more for the text
+static int pattern_reserve(grex_pattern_t* pat, void** items, size_t* capacity, size_t count, size_t item_size) {
+  if (count <= *capacity) {
+    return 1;
+  }
+
+  size_t grown = *capacity ? *capacity * 2 : 16;
+  while (grown < count) {
+    grown *= 2;
+  }
+
+  void* resized = realloc(*items, grown * item_size);
+  if (!resized) {
+    pat->error = GREX_ALLOC_ERR;
+    return 0;
+  }
+  *items = resized;
+  *capacity = grown;
+  return 1;
+}
+
+// Only compiling allocates the needles, which are sized for the ops there are, so a compiled pattern can't grow
+static int pattern_sealed(grex_pattern_t* pat) {
+  if (pat->needles && !pat->error) {
+    pat->error = GREX_NO_MATCH;
+  }
+  return pat->error != 0;
+}
+
+static grex_pattern_op_t* pattern_add(grex_pattern_t* pat, unsigned code, unsigned arg) {
+  if (pattern_sealed(pat) || !pattern_reserve(pat, (void**)&pat->ops, &pat->op_capacity, pat->op_count + 1, sizeof(*pat->ops))) {
+    return NULL;
+  }
+
+  grex_pattern_op_t* op = &pat->ops[pat->op_count++];
+  memset(op, 0, sizeof(*op));
+  op->code = (unsigned char)code;
+  op->arg = arg;
+  return op;
+}
+
+static void pattern_add_class(grex_pattern_t* pat, unsigned code, const grex_class_t* cls) {
+  if (pattern_sealed(pat) || !pattern_reserve(pat, (void**)&pat->classes, &pat->class_capacity, pat->class_count + 1, sizeof(*pat->classes))) {
+    return;
+  }
+
+  grex_pattern_op_t* op = pattern_add(pat, code, 0);
+  if (op) {
+    op->index = (unsigned)pat->class_count;
+    pat->classes[pat->class_count++] = *cls;
+  }
+}
+
+static void pattern_add_text(grex_pattern_t* pat, unsigned code, const char* text, size_t length) {
+  if (pattern_sealed(pat) || !pattern_reserve(pat, (void**)&pat->text, &pat->text_capacity, pat->text_length + length, 1)) {
+    return;
+  }
+
+  grex_pattern_op_t* op = pattern_add(pat, code, 0);
+  if (op) {
+    op->index = (unsigned)pat->text_length;
+    op->length = (unsigned)length;
+    memcpy(pat->text + pat->text_length, text, length);
+    pat->text_length += length;
+  }
+}
+
+void grex_pattern_char(grex_pattern_t* pat, int c) {
+  pattern_add(pat, PATTERN_CHAR, (unsigned char)c);
+}
+
+void grex_pattern_sequence(grex_pattern_t* pat, const char* seq) {
+  pattern_add_text(pat, PATTERN_SEQUENCE, seq, strlen(seq));
+}
+
+void grex_pattern_set(grex_pattern_t* pat, const char* set) {
+  grex_class_t cls;
+  grex_class_clear(&cls);
+  grex_class_add_set(&cls, set);
+  pattern_add_class(pat, PATTERN_CLASS, &cls);
+}
+
+void grex_pattern_range(grex_pattern_t* pat, int first, int last) {
+  grex_class_t cls;
+  grex_class_clear(&cls);
+  grex_class_add_range(&cls, first, last);
+  pattern_add_class(pat, PATTERN_CLASS, &cls);
+}
+
+void grex_pattern_class(grex_pattern_t* pat, const grex_class_t* cls) {
+  pattern_add_class(pat, PATTERN_CLASS, cls);
+}
+
+void grex_pattern_while(grex_pattern_t* pat, int c) {
+  grex_pattern_range(pat, c, c);
+  if (!pat->error) {
+    pat->ops[pat->op_count - 1].code = PATTERN_WHILE_CLASS;
+  }
+}
+
+void grex_pattern_while_class(grex_pattern_t* pat, const grex_class_t* cls) {
+  pattern_add_class(pat, PATTERN_WHILE_CLASS, cls);
+}
+
+void grex_pattern_until(grex_pattern_t* pat, int c) {
+  char byte = (char)c;
+  pattern_add_text(pat, PATTERN_UNTIL_BYTES, &byte, 1);
+}
+
+void grex_pattern_until_any(grex_pattern_t* pat, const char* set) {
+  size_t count = strlen(set);
+
+  if (count == 0 || count > GREX_UNTIL_ANY_MAX) {
+    grex_class_t cls;
+    grex_class_clear(&cls);
+    grex_class_add_set(&cls, set);
+    pattern_add_class(pat, PATTERN_UNTIL_CLASS, &cls);
+    return;
+  }
+
+  pattern_add_text(pat, PATTERN_UNTIL_BYTES, set, count);
+}
+
+void grex_pattern_until_class(grex_pattern_t* pat, const grex_class_t* cls) {
+  pattern_add_class(pat, PATTERN_UNTIL_CLASS, cls);
+}
+
+void grex_pattern_until_sequence(grex_pattern_t* pat, const char* seq) {
+  pattern_add_text(pat, PATTERN_UNTIL_SEQUENCE, seq, strlen(seq));
+}
+
+void grex_pattern_whitespace(grex_pattern_t* pat) {
+  pattern_add_class(pat, PATTERN_WHILE_CLASS, &whitespace_class);
+}
+
+void grex_pattern_whitespace_no_line(grex_pattern_t* pat) {
+  pattern_add_class(pat, PATTERN_WHILE_CLASS, &whitespace_no_line_class);
+}
+
+void grex_pattern_integer(grex_pattern_t* pat, int base) {
+  pattern_add(pat, PATTERN_INTEGER, (unsigned)base);
+}
+
+void grex_pattern_float(grex_pattern_t* pat) {
+  pattern_add(pat, PATTERN_FLOAT, 0);
+}
+
+void grex_pattern_identifier(grex_pattern_t* pat) {
+  pattern_add(pat, PATTERN_IDENTIFIER, 0);
+}
+
+void grex_pattern_string(grex_pattern_t* pat) {
+  pattern_add(pat, PATTERN_STRING, 0);
+}
+
+void grex_pattern_optional(grex_pattern_t* pat) {
+  if (pattern_sealed(pat)) {
+    return;
+  }
+
+  if (pat->op_count == 0 || pat->ops[pat->op_count - 1].code >= PATTERN_CAPTURE_BEGIN) {
+    pat->error = GREX_NO_MATCH;
+    return;
+  }
+  pat->ops[pat->op_count - 1].optional = 1;
+}
+
+unsigned grex_pattern_capture_begin(grex_pattern_t* pat) {
+  unsigned index = pat->capture_count;
+
+  if (pattern_sealed(pat)) {
+    return index;
+  }
+  if (pat->capture_count == GREX_PATTERN_MAX_CAPTURES) {
+    pat->error = GREX_NO_MATCH;
+    return index;
+  }
+
+  pat->capture_stack[pat->open_captures++] = index;
+  pat->capture_count++;
+  pattern_add(pat, PATTERN_CAPTURE_BEGIN, index);
+  return index;
+}
+
+void grex_pattern_capture_end(grex_pattern_t* pat) {
+  if (pattern_sealed(pat)) {
+    return;
+  }
+  if (pat->open_captures == 0) {
+    pat->error = GREX_NO_MATCH;
+    return;
+  }
+
+  pattern_add(pat, PATTERN_CAPTURE_END, pat->capture_stack[--pat->open_captures]);
+}
+
+grex_result_t grex_pattern_compile(grex_pattern_t* pat) {
+  if (pat->error) {
+    return (grex_result_t)pat->error;
+  }
+  if (pat->open_captures) {
+    return GREX_NO_MATCH;
+  }
+
+  size_t out = 0;
+  for (size_t i = 0; i < pat->op_count; i++) {
+    grex_pattern_op_t op = pat->ops[i];
+
+    // A capture around a lone string captures its contents, with the escape flag
+    if (op.code == PATTERN_CAPTURE_BEGIN && i + 2 < pat->op_count &&
+        pat->ops[i + 1].code == PATTERN_STRING && pat->ops[i + 2].code == PATTERN_CAPTURE_END &&
+        pat->ops[i + 2].arg == op.arg) {
+      op = pat->ops[i + 1];
+      op.capture = (unsigned short)(pat->ops[i].arg + 1);
+      i += 2;
+    }
+
+    // Runs of required characters become a single sequence compare
+    if (op.code == PATTERN_CHAR && !op.optional) {
+      size_t j = i;
+      while (j + 1 < pat->op_count && pat->ops[j + 1].code == PATTERN_CHAR && !pat->ops[j + 1].optional) {
+        j++;
+      }
+      if (j > i) {
+        if (!pattern_reserve(pat, (void**)&pat->text, &pat->text_capacity, pat->text_length + (j - i + 1), 1)) {
+          return GREX_ALLOC_ERR;
+        }
+        op.code = PATTERN_SEQUENCE;
+        op.index = (unsigned)pat->text_length;
+        op.length = (unsigned)(j - i + 1);
+        for (size_t k = i; k <= j; k++) {
+          pat->text[pat->text_length++] = (char)pat->ops[k].arg;
+        }
+        i = j;
+      }
+    }
+
+    pat->ops[out++] = op;
+  }
+  pat->op_count = out;
+
+  // The needles point into the text, which can't move anymore
+  free(pat->needles);
+  pat->needles = malloc((pat->op_count ? pat->op_count : 1) * sizeof(*pat->needles));
+  if (!pat->needles) {
+    return GREX_ALLOC_ERR;
+  }
+  for (size_t i = 0; i < pat->op_count; i++) {
+    if (pat->ops[i].code == PATTERN_UNTIL_SEQUENCE) {
+      grex_needle_init_length(&pat->needles[i], pat->text + pat->ops[i].index, pat->ops[i].length);
+    }
+  }
+
+  return GREX_OK;
+}
+
+// Moves the head over the characters that are (or are not) in the class, through refills.
+// Returns zero if it stopped at the end of the input.
+static int pattern_scan_class(grex_parser_t* p, const grex_class_t* cls, int member) {
+  size_t s = p->parsing_offset;
+
+  for (;;) {
+    const char* stop = class_scan(cls, &p->input[s], p->input_end, member);
+    if (stop < p->input_end) {
+      p->parsing_offset = stop - p->input;
+      return 1;
+    }
+
+    s = p->input_length;
+    p->parsing_offset = s;
+    if (!refill(p, &s)) {
+      return 0;
+    }
+  }
+}
+
+static int pattern_scan_bytes(grex_parser_t* p, const unsigned char* bytes, unsigned count) {
+  size_t s = p->parsing_offset;
+
+  for (;;) {
+    const char* stop = bytes_scan(&p->input[s], p->input_end, bytes, count);
+    if (stop < p->input_end) {
+      p->parsing_offset = stop - p->input;
+      return 1;
+    }
+
+    s = p->input_length;
+    p->parsing_offset = s;
+    if (!refill(p, &s)) {
+      return 0;
+    }
+  }
+}
+
+static grex_result_t pattern_step(grex_parser_t* p, const grex_pattern_t* pat, size_t i, unsigned long long* bounds) {
+  const grex_pattern_op_t* op = &pat->ops[i];
+  unsigned long long begin = grex_parser_tell(p);
+  grex_span_t span;
+
+  switch (op->code) {
+  case PATTERN_CHAR:
+    if (!ensure(p, 1)) {
+      return GREX_EOF;
+    }
+    if ((unsigned char)p->input[p->parsing_offset] != op->arg) {
+      return GREX_NO_MATCH;
+    }
+    p->parsing_offset++;
+    return GREX_OK;
+
+  case PATTERN_SEQUENCE:
+    if (!ensure(p, op->length)) {
+      return GREX_EOF;
+    }
+    if (memcmp(&p->input[p->parsing_offset], pat->text + op->index, op->length)) {
+      return GREX_NO_MATCH;
+    }
+    p->parsing_offset += op->length;
+    return GREX_OK;
+
+  case PATTERN_CLASS:
+    if (!ensure(p, 1)) {
+      return GREX_EOF;
+    }
+    if (!class_has(&pat->classes[op->index], p->input[p->parsing_offset])) {
+      return GREX_NO_MATCH;
+    }
+    p->parsing_offset++;
+    return GREX_OK;
+
+  case PATTERN_WHILE_CLASS:
+    pattern_scan_class(p, &pat->classes[op->index], 1);
+    return grex_parser_tell(p) > begin ? GREX_OK : GREX_NO_MATCH;
+
+  case PATTERN_UNTIL_CLASS:
+    if (!pattern_scan_class(p, &pat->classes[op->index], 0)) {
+      return GREX_EOF;
+    }
+    return grex_parser_tell(p) > begin ? GREX_OK : GREX_NO_MATCH;
+
+  case PATTERN_UNTIL_BYTES:
+    if (!pattern_scan_bytes(p, (const unsigned char*)pat->text + op->index, op->length)) {
+      return GREX_EOF;
+    }
+    return grex_parser_tell(p) > begin ? GREX_OK : GREX_NO_MATCH;
+
+  case PATTERN_UNTIL_SEQUENCE: {
+    if (p->parsing_offset >= p->input_length && !refill(p, NULL)) {
+      return GREX_EOF;
+    }
+    const grex_needle_t* n = &pat->needles[i];
+    const char* hit;
+    size_t s = p->parsing_offset;
+    while (!(hit = needle_find(n, &p->input[s], p->input_end))) {
+      if (p->input_length - s >= n->length) {
+        s = p->input_length - n->length + 1;
+        p->parsing_offset = s;
+      }
+      if (!refill(p, &s)) {
+        return GREX_EOF;
+      }
+    }
+    p->parsing_offset = (hit - p->input) + n->length;
+    return GREX_OK;
+  }
+
+  case PATTERN_INTEGER: {
+    long long value;
+    return grex_integer(p, (int)op->arg, &value);
+  }
+
+  case PATTERN_FLOAT: {
+    double value;
+    return grex_float(p, &value);
+  }
+
+  case PATTERN_IDENTIFIER:
+    return grex_identifier_span(p, &span);
+
+  case PATTERN_STRING: {
+    grex_result_t result = grex_string_span(p, &span);
+    if (result == GREX_OK && op->capture) {
+      unsigned long long* b = &bounds[(op->capture - 1) * 3];
+      b[0] = p->stream_offset + (span.ptr - p->input);
+      b[1] = b[0] + span.len;
+      b[2] = span.flags;
+    }
+    return result;
+  }
+
+  case PATTERN_CAPTURE_BEGIN:
+    bounds[op->arg * 3] = begin;
+    return GREX_OK;
+
+  case PATTERN_CAPTURE_END:
+    bounds[op->arg * 3 + 1] = begin;
+    bounds[op->arg * 3 + 2] = 0;
+    return GREX_OK;
+  }
+
+  return GREX_NO_MATCH;
+}
+
+grex_result_t GREX_IMPL(grex_pattern_match)(grex_parser_t* p, const grex_pattern_t* pat, grex_span_t* captures, unsigned capture_count) {
+  // Begin, end and flags of every capture, as absolute offsets since the window may move
+  unsigned long long bounds[GREX_PATTERN_MAX_CAPTURES * 3];
+  grex_mark_t mark;
+  grex_result_t result = GREX_OK;
+
+  // A pattern that was never compiled has no needles
+  if (!pat->needles) {
+    return GREX_NO_MATCH;
+  }
+
+  // Captures that nothing matched are empty spans at the head
+  grex_parser_mark(p, &mark);
+  for (unsigned i = 0; i < pat->capture_count; i++) {
+    bounds[i * 3] = bounds[i * 3 + 1] = mark.offset;
+    bounds[i * 3 + 2] = 0;
+  }
+
+  for (size_t i = 0; i < pat->op_count; i++) {
+    unsigned long long before = grex_parser_tell(p);
+
+    result = pattern_step(p, pat, i, bounds);
+    if (result != GREX_OK) {
+      if (!pat->ops[i].optional) {
+        break;
+      }
+      p->parsing_offset = (size_t)(before - p->stream_offset);
+      result = GREX_OK;
+
+      // A skipped string that is captured on its own leaves an empty capture where it would have been
+      if (pat->ops[i].capture) {
+        unsigned long long* b = &bounds[(pat->ops[i].capture - 1) * 3];
+        b[0] = b[1] = before;
+        b[2] = 0;
+      }
+    }
+  }
+
+  if (result != GREX_OK) {
+    grex_parser_rewind(p, &mark);
+    grex_parser_release(p, &mark);
+    return result;
+  }
+
+  grex_parser_release(p, &mark);
+  for (unsigned i = 0; i < capture_count && i < pat->capture_count; i++) {
+    captures[i].ptr = p->input + (size_t)(bounds[i * 3] - p->stream_offset);
+    captures[i].len = (size_t)(bounds[i * 3 + 1] - bounds[i * 3]);
+    captures[i].flags = (unsigned)bounds[i * 3 + 2];
+  }
+  return GREX_OK;
+}
+
+// Below this size a chunk costs more to hand to a thread than to parse, unless the chunk count is given
+#define GREX_PARALLEL_MIN_CHUNK (64 * 1024)
+
+typedef struct parallel_pool {
+  void (*work)(void* ctx, size_t i, grex_parser_t* p);
+  void* ctx;
+  size_t count;
+  size_t next;
+  unsigned char* done;
+#if defined(GREX_THREADS_POSIX)
+  pthread_mutex_t lock;
+  pthread_cond_t finished;
+#elif defined(GREX_THREADS_WIN32)
+  CRITICAL_SECTION lock;
+  CONDITION_VARIABLE finished;
+#endif
+} parallel_pool_t;
+
+#if defined(GREX_THREADS_POSIX)
+static inline void pool_lock(parallel_pool_t* pool) { pthread_mutex_lock(&pool->lock); }
+static inline void pool_unlock(parallel_pool_t* pool) { pthread_mutex_unlock(&pool->lock); }
+static inline void pool_wait(parallel_pool_t* pool) { pthread_cond_wait(&pool->finished, &pool->lock); }
+static inline void pool_signal(parallel_pool_t* pool) { pthread_cond_signal(&pool->finished); }
+#elif defined(GREX_THREADS_WIN32)
+static inline void pool_lock(parallel_pool_t* pool) { EnterCriticalSection(&pool->lock); }
+static inline void pool_unlock(parallel_pool_t* pool) { LeaveCriticalSection(&pool->lock); }
+static inline void pool_wait(parallel_pool_t* pool) { SleepConditionVariableCS(&pool->finished, &pool->lock, INFINITE); }
+static inline void pool_signal(parallel_pool_t* pool) { WakeConditionVariable(&pool->finished); }
+#endif
+
+static unsigned parallel_cpu_count(void) {
+#if defined(GREX_THREADS_POSIX) && defined(_SC_NPROCESSORS_ONLN)
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (unsigned)n : 1;
+#elif defined(GREX_THREADS_WIN32)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwNumberOfProcessors ? (unsigned)info.dwNumberOfProcessors : 1;
+#else
+  return 1;
+#endif
+}
+
+#if defined(GREX_THREADS_POSIX) || defined(GREX_THREADS_WIN32)
+// Each worker takes the next item until there are none left, with a parser of its own
+static void pool_run(parallel_pool_t* pool) {
+  grex_parser_t p;
+  memset(&p, 0, sizeof(p));
+
+  for (;;) {
+    pool_lock(pool);
+    size_t i = pool->next++;
+    pool_unlock(pool);
+    if (i >= pool->count) {
+      break;
+    }
+
+    pool->work(pool->ctx, i, &p);
+
+    pool_lock(pool);
+    pool->done[i] = 1;
+    pool_signal(pool);
+    pool_unlock(pool);
+  }
+}
+
+#if defined(GREX_THREADS_POSIX)
+static void* pool_worker(void* arg) {
+  pool_run(arg);
+  return NULL;
+}
+#else
+static DWORD WINAPI pool_worker(LPVOID arg) {
+  pool_run(arg);
+  return 0;
+}
+#endif
+#endif
+
+// Runs work on every item from 0 to count - 1, calling done on the calling thread in item order
+// as the items are finished. Falls back to the calling thread when no worker can be started.
+static grex_result_t parallel_for(unsigned threads, size_t count, void (*work)(void*, size_t, grex_parser_t*),
+                                  void (*done)(void*, size_t), void* ctx) {
+  if (threads > count) {
+    threads = (unsigned)count;
+  }
+
+#if defined(GREX_THREADS_POSIX) || defined(GREX_THREADS_WIN32)
+  if (threads > 1) {
+    parallel_pool_t pool;
+    pool.work = work;
+    pool.ctx = ctx;
+    pool.count = count;
+    pool.next = 0;
+    pool.done = calloc(count, 1);
+#if defined(GREX_THREADS_POSIX)
+    pthread_t* workers = malloc(threads * sizeof(*workers));
+#else
+    HANDLE* workers = malloc(threads * sizeof(*workers));
+#endif
+    if (!pool.done || !workers) {
+      free(pool.done);
+      free(workers);
+      return GREX_ALLOC_ERR;
+    }
+
+#if defined(GREX_THREADS_POSIX)
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.finished, NULL);
+#else
+    InitializeCriticalSection(&pool.lock);
+    InitializeConditionVariable(&pool.finished);
+#endif
+
+    unsigned started = 0;
+    for (; started < threads; started++) {
+#if defined(GREX_THREADS_POSIX)
+      if (pthread_create(&workers[started], NULL, pool_worker, &pool)) {
+        break;
+      }
+#else
+      if (!(workers[started] = CreateThread(NULL, 0, pool_worker, &pool, 0, NULL))) {
+        break;
+      }
+#endif
+    }
+
+    // Without any worker the calling thread takes all the items, and finds them done below
+    if (!started) {
+      pool_run(&pool);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+      pool_lock(&pool);
+      while (!pool.done[i]) {
+        pool_wait(&pool);
+      }
+      pool_unlock(&pool);
+      if (done) {
+        done(ctx, i);
+      }
+    }
+
+    for (unsigned t = 0; t < started; t++) {
+#if defined(GREX_THREADS_POSIX)
+      pthread_join(workers[t], NULL);
+#else
+      WaitForSingleObject(workers[t], INFINITE);
+      CloseHandle(workers[t]);
+#endif
+    }
+
+#if defined(GREX_THREADS_POSIX)
+    pthread_cond_destroy(&pool.finished);
+    pthread_mutex_destroy(&pool.lock);
+#else
+    DeleteCriticalSection(&pool.lock);
+#endif
+    free(workers);
+    free(pool.done);
+    return GREX_OK;
+  }
+#endif
+
+  grex_parser_t p;
+  memset(&p, 0, sizeof(p));
+  for (size_t i = 0; i < count; i++) {
+    work(ctx, i, &p);
+    if (done) {
+      done(ctx, i);
+    }
+  }
+  return GREX_OK;
+}
+
+typedef struct parallel_job {
+  const grex_parallel_t* par;
+  const char* input;
+  size_t length;
+  size_t split_count;
+  size_t* quotes;
+  grex_chunk_t* chunks;
+} parallel_job_t;
+
+// Split points before they are moved to a record boundary, the last one is the end of the input
+static inline size_t parallel_split(const parallel_job_t* job, size_t k) {
+  return k == job->split_count ? job->length : job->length / job->split_count * k;
+}
+
+static void parallel_count_quotes(void* ctx, size_t i, grex_parser_t* p) {
+  parallel_job_t* job = ctx;
+  (void)p;
+  job->quotes[i] = count_byte(job->input + parallel_split(job, i), job->input + parallel_split(job, i + 1), '"');
+}
+
+static void parallel_parse(void* ctx, size_t i, grex_parser_t* p) {
+  parallel_job_t* job = ctx;
+  grex_chunk_t* chunk = &job->chunks[i];
+
+  // Every chunk starts with a fresh parser, so the error state of the previous one doesn't leak
+  memset(p, 0, sizeof(*p));
+  grex_parser_init(p, job->input + chunk->offset, chunk->length);
+  chunk->result = job->par->parse(p, chunk, job->par->arg);
+  grex_parser_destroy(p);
+}
+
+static void parallel_deliver(void* ctx, size_t i) {
+  parallel_job_t* job = ctx;
+  job->par->deliver(&job->chunks[i], job->par->arg);
+}
+
+// Returns the offset after the first newline in [offset, length) outside of double quotes, or length.
+// quoted is whether offset is between quotes.
+static size_t unquoted_newline(const char* input, size_t length, size_t offset, int quoted) {
+  static const unsigned char stops[2] = { '"', '\n' };
+  const char* end = input + length;
+
+  for (const char* s = input + offset; (s = bytes_scan(s, end, stops, 2)) < end; s++) {
+    if (*s == '"') {
+      quoted = !quoted;
+    }
+    else if (!quoted) {
+      return (size_t)(s + 1 - input);
+    }
+  }
+  return length;
+}
+
+void grex_parallel_init(grex_parallel_t* par, grex_chunk_callback_t parse, grex_deliver_callback_t deliver, void* arg) {
+  par->threads = 0;
+  par->chunks = 0;
+  par->boundary = NULL;
+  par->boundary_arg = NULL;
+  par->parse = parse;
+  par->deliver = deliver;
+  par->arg = arg;
+}
+
+grex_result_t grex_parse_parallel(const grex_parallel_t* par, const char* input, size_t length) {
+  unsigned threads = par->threads ? par->threads : parallel_cpu_count();
+  size_t count = par->chunks;
+
+  // A few chunks per thread, so a slow chunk doesn't leave the other threads idle at the end
+  if (!count) {
+    count = (size_t)threads * 4;
+    if (count > length / GREX_PARALLEL_MIN_CHUNK + 1) {
+      count = length / GREX_PARALLEL_MIN_CHUNK + 1;
+    }
+  }
+  if (count > length) {
+    count = length ? length : 1;
+  }
+
+  parallel_job_t job;
+  job.par = par;
+  job.input = input;
+  job.length = length;
+  job.split_count = count;
+  job.quotes = NULL;
+  job.chunks = malloc(count * sizeof(*job.chunks));
+  if (!job.chunks) {
+    return GREX_ALLOC_ERR;
+  }
+
+  // The quotes before a split point tell whether it is between quotes
+  if (!par->boundary && count > 1) {
+    job.quotes = malloc(count * sizeof(*job.quotes));
+    if (!job.quotes || parallel_for(threads, count, parallel_count_quotes, NULL, &job) != GREX_OK) {
+      free(job.quotes);
+      free(job.chunks);
+      return GREX_ALLOC_ERR;
+    }
+  }
+
+  size_t chunk_count = 0, start = 0;
+  int quoted = 0;
+  for (size_t k = 1; k <= count; k++) {
+    size_t end = length;
+    if (k < count) {
+      size_t split = parallel_split(&job, k);
+      if (par->boundary) {
+        end = par->boundary(input, length, split, par->boundary_arg);
+      }
+      else {
+        quoted ^= job.quotes[k - 1] & 1;
+        end = unquoted_newline(input, length, split, quoted);
+      }
+      if (end > length) {
+        end = length;
+      }
+    }
+
+    // A record longer than a chunk swallows the split points inside it
+    if (end > start) {
+      grex_chunk_t* chunk = &job.chunks[chunk_count];
+      chunk->index = chunk_count++;
+      chunk->offset = start;
+      chunk->length = end - start;
+      chunk->result = GREX_OK;
+      chunk->data = NULL;
+      start = end;
+    }
+  }
+  free(job.quotes);
+
+  grex_result_t result = parallel_for(threads, chunk_count, parallel_parse, par->deliver ? parallel_deliver : NULL, &job);
+  for (size_t i = 0; i < chunk_count && result == GREX_OK; i++) {
+    result = job.chunks[i].result;
+  }
+
+  free(job.chunks);
+  return result;
+}
+
+// A stamp that never matches, for the fragments that have to be parsed on the next reload
+#define GREX_CONFIG_STAMP_UNKNOWN (~0ULL)
+
+// Initial number of slots of the config index
+#define GREX_CONFIG_SLOTS 64
+
+void grex_config_init(grex_config_t* cfg) {
+  cfg->fragments = NULL;
+  cfg->fragment_count = 0;
+  cfg->fragment_capacity = 0;
+  cfg->slots = NULL;
+  cfg->mask = 0;
+  cfg->count = 0;
+  cfg->error_fragment = 0;
+  cfg->error_line = 0;
+}
+
+static void config_fragment_free(grex_config_fragment_t* f) {
+  free(f->entries);
+  grex_arena_destroy(&f->arena);
+  f->entries = NULL;
+  f->count = 0;
+  f->capacity = 0;
+}
+
+void grex_config_destroy(grex_config_t* cfg) {
+  for (size_t i = 0; i < cfg->fragment_count; i++) {
+    config_fragment_free(&cfg->fragments[i]);
+    free(cfg->fragments[i].path);
+  }
+  free(cfg->fragments);
+  free(cfg->slots);
+  grex_config_init(cfg);
+}
+
+// The modification time and size of a file, which tell grex_config_reload that it changed
+static grex_result_t config_stat(const char* path, unsigned long long* stamp, unsigned long long* size) {
+#if defined(GREX_MMAP_POSIX)
+  struct stat st;
+  if (stat(path, &st) != 0) {
+    return GREX_IO_ERR;
+  }
+  *stamp = (unsigned long long)st.st_mtime * 1000000000ULL;
+  // glibc defines st_mtime as st_mtim.tv_sec when it declares the nanoseconds
+#if defined(__linux__) && defined(st_mtime)
+  *stamp += (unsigned long long)st.st_mtim.tv_nsec;
+#endif
+  *size = (unsigned long long)st.st_size;
+#elif defined(GREX_MMAP_WIN32)
+  WIN32_FILE_ATTRIBUTE_DATA data;
+  if (!GetFileAttributesExA(path, GetFileExInfoStandard, &data)) {
+    return GREX_IO_ERR;
+  }
+  *stamp = ((unsigned long long)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+  *size = ((unsigned long long)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+#else
+  // Without a way to tell, every reload parses the files again
+  (void)path;
+  *stamp = GREX_CONFIG_STAMP_UNKNOWN;
+  *size = GREX_CONFIG_STAMP_UNKNOWN;
+#endif
+  return GREX_OK;
+}
+
+static inline int config_blank(int c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+}
+
+static const char* config_skip_blanks(const char* s, const char* end) {
+  while (s < end && config_blank((unsigned char)*s)) {
+    s++;
+  }
+  return s;
+}
+
+static const char* config_trim_blanks(const char* begin, const char* end) {
+  while (end > begin && config_blank((unsigned char)end[-1])) {
+    end--;
+  }
+  return end;
+}
+
+// Whether the rest of the line is blank or a comment
+static int config_line_done(const char* s, const char* eol) {
+  s = config_skip_blanks(s, eol);
+  return s == eol || *s == '#' || *s == ';';
+}
+
+// Copies the section, key and value into a single arena allocation, as "section.key\0value\0"
+static grex_result_t config_add(grex_config_fragment_t* f, const grex_span_t* section, const char* key, size_t key_len,
+                                const char* value, size_t value_len, int quote, unsigned flags, unsigned long long line) {
+  if (f->count == f->capacity) {
+    size_t capacity = f->capacity ? f->capacity * 2 : 16;
+    grex_config_entry_t* entries = realloc(f->entries, capacity * sizeof(*entries));
+    if (!entries) {
+      return GREX_ALLOC_ERR;
+    }
+    f->entries = entries;
+    f->capacity = capacity;
+  }
+
+  size_t prefix = section->len ? section->len + 1 : 0;
+  char* copy = arena_bump(&f->arena, prefix + key_len + value_len + 2, 1);
+  if (!copy) {
+    return GREX_ALLOC_ERR;
+  }
+
+  if (prefix) {
+    memcpy(copy, section->ptr, section->len);
+    copy[section->len] = '.';
+  }
+  memcpy(copy + prefix, key, key_len);
+  copy[prefix + key_len] = 0;
+  char* v = copy + prefix + key_len + 1;
+  memcpy(v, value, value_len);
+  v[value_len] = 0;
+
+  grex_config_entry_t* e = &f->entries[f->count++];
+  set_span(&e->key, copy, copy + prefix + key_len, 0);
+  set_span(&e->value, v, v + value_len, flags);
+  e->hash = intern_hash(copy, e->key.len);
+  e->quote = quote;
+  e->line = line;
+  return GREX_OK;
+}
+
+static grex_result_t config_line(grex_config_fragment_t* f, const char* s, const char* eol, grex_span_t* section, unsigned long long line) {
+  s = config_skip_blanks(s, eol);
+  if (s == eol || *s == '#' || *s == ';') {
+    return GREX_OK;
+  }
+
+  if (*s == '[') {
+    const char* close = memchr(s + 1, ']', eol - s - 1);
+    if (!close || !config_line_done(close + 1, eol)) {
+      return GREX_NO_MATCH;
+    }
+    const char* name = config_skip_blanks(s + 1, close);
+    set_span(section, name, config_trim_blanks(name, close), 0);
+    return GREX_OK;
+  }
+
+  const char* eq = memchr(s, '=', eol - s);
+  if (!eq || eq == s) {
+    return GREX_NO_MATCH;
+  }
+
+  const char* v = config_skip_blanks(eq + 1, eol);
+  const char* end = v;
+  int quote = 0;
+  unsigned flags = 0;
+
+  if (v < eol && (*v == '"' || *v == '\'')) {
+    quote = *v++;
+    end = v;
+    while (end < eol && *end != quote) {
+      if (*end == '\\' && end + 1 < eol) {
+        flags = GREX_SPAN_ESCAPED;
+        end++;
+      }
+      end++;
+    }
+    if (end == eol || !config_line_done(end + 1, eol)) {
+      return GREX_NO_MATCH;
+    }
+  }
+  else {
+    // A comment starts the value or follows a blank, so '#' and ';' can be inside a value
+    while (end < eol && !((*end == '#' || *end == ';') && (end == v || config_blank((unsigned char)end[-1])))) {
+      end++;
+    }
+    end = config_trim_blanks(v, end);
+  }
+
+  return config_add(f, section, s, config_trim_blanks(s, eq) - s, v, end - v, quote, flags, line);
+}
+
+// Parses the lines of an INI text into the entries of the fragment, or returns the line that failed in *line
+static grex_result_t config_parse(grex_config_fragment_t* f, const char* text, size_t length, unsigned long long* line) {
+  static const unsigned char newline = '\n';
+  const char* s = text;
+  const char* end = text + length;
+  grex_span_t section = { "", 0, 0 };
+
+  // A byte order mark is not part of the first line
+  if (length >= 3 && !memcmp(s, "\xEF\xBB\xBF", 3)) {
+    s += 3;
+  }
+
+  for (*line = 1; s < end; (*line)++) {
+    const char* eol = bytes_scan(s, end, &newline, 1);
+    grex_result_t result = config_line(f, s, eol, &section, *line);
+    if (result != GREX_OK) {
+      return result;
+    }
+    s = eol < end ? eol + 1 : end;
+  }
+  return GREX_OK;
+}
+
+// Parses the text into new entries, which replace the ones of the fragment only on success
+static grex_result_t config_fragment_parse(grex_config_t* cfg, size_t index, const char* text, size_t length) {
+  grex_config_fragment_t parsed;
+  unsigned long long line;
+
+  // Sized so the keys and values of most texts fit in a single block
+  grex_arena_init(&parsed.arena, length + length / 4 + 256);
+  parsed.entries = NULL;
+  parsed.count = 0;
+  parsed.capacity = 0;
+
+  grex_result_t result = config_parse(&parsed, text, length, &line);
+  if (result != GREX_OK) {
+    config_fragment_free(&parsed);
+    if (result == GREX_NO_MATCH) {
+      cfg->error_fragment = index;
+      cfg->error_line = line;
+    }
+    return result;
+  }
+
+  grex_config_fragment_t* f = &cfg->fragments[index];
+  config_fragment_free(f);
+  f->arena = parsed.arena;
+  f->entries = parsed.entries;
+  f->count = parsed.count;
+  f->capacity = parsed.capacity;
+  return GREX_OK;
+}
+
+// Config files below this size are read instead of mapped, which costs fewer system calls
+#define GREX_CONFIG_READ_MAX (64 * 1024)
+
+// Reads the file of a fragment and parses it, remembering the stamp the file had before it was read
+static grex_result_t config_fragment_load(grex_config_t* cfg, size_t index, unsigned long long stamp, unsigned long long size) {
+  const char* path = cfg->fragments[index].path;
+  grex_result_t result;
+
+#if defined(GREX_MMAP_POSIX)
+  if (size < GREX_CONFIG_READ_MAX) {
+    int fd = open(path, O_RDONLY);
+    char* text = malloc((size_t)size + 1);
+    if (fd < 0 || !text) {
+      if (fd >= 0) {
+        close(fd);
+      }
+      free(text);
+      return fd < 0 ? GREX_IO_ERR : GREX_ALLOC_ERR;
+    }
+
+    // Reading one more character tells whether the file grew since it was stat'ed
+    size_t n = 0;
+    ssize_t r = 0;
+    while (n <= size && (r = read(fd, text + n, (size_t)size + 1 - n)) > 0) {
+      n += (size_t)r;
+    }
+    close(fd);
+
+    if (n <= size) {
+      result = r < 0 ? GREX_IO_ERR : config_fragment_parse(cfg, index, text, n);
+      free(text);
+      if (result == GREX_OK) {
+        cfg->fragments[index].stamp = stamp;
+        cfg->fragments[index].size = size;
+      }
+      return result;
+    }
+
+    // A file that grew is mapped whole, and read again on the next reload
+    free(text);
+    stamp = GREX_CONFIG_STAMP_UNKNOWN;
+  }
+#endif
+
+  grex_parser_t p;
+  memset(&p, 0, sizeof(p));
+  result = grex_parser_open_file(&p, path);
+  if (result != GREX_OK) {
+    return result;
+  }
+
+  result = config_fragment_parse(cfg, index, p.input, p.input_length);
+  grex_parser_close_file(&p);
+
+  if (result == GREX_OK) {
+    cfg->fragments[index].stamp = stamp;
+    cfg->fragments[index].size = size;
+  }
+  return result;
+}
+
+static grex_result_t config_fragment_add(grex_config_t* cfg, const char* path) {
+  if (cfg->fragment_count == cfg->fragment_capacity) {
+    size_t capacity = cfg->fragment_capacity ? cfg->fragment_capacity * 2 : 16;
+    grex_config_fragment_t* fragments = realloc(cfg->fragments, capacity * sizeof(*fragments));
+    if (!fragments) {
+      return GREX_ALLOC_ERR;
+    }
+    cfg->fragments = fragments;
+    cfg->fragment_capacity = capacity;
+  }
 
-  int result = grex_until(p, c);
+  grex_config_fragment_t* f = &cfg->fragments[cfg->fragment_count];
+  f->path = NULL;
+  if (path) {
+    size_t len = strlen(path);
+    f->path = malloc(len + 1);
+    if (!f->path) {
+      return GREX_ALLOC_ERR;
+    }
+    memcpy(f->path, path, len + 1);
+  }
+
+  grex_arena_init(&f->arena, 0);
+  f->entries = NULL;
+  f->count = 0;
+  f->capacity = 0;
+  f->stamp = GREX_CONFIG_STAMP_UNKNOWN;
+  f->size = GREX_CONFIG_STAMP_UNKNOWN;
+  cfg->fragment_count++;
+  return GREX_OK;
+}
+
+static void config_fragment_pop(grex_config_t* cfg) {
+  grex_config_fragment_t* f = &cfg->fragments[--cfg->fragment_count];
+  config_fragment_free(f);
+  free(f->path);
+}
+
+// The slot of the key, or the empty slot where it would be added
+static grex_config_slot_t* config_probe(const grex_config_t* cfg, const char* key, size_t len, unsigned hash) {
+  for (size_t i = hash & cfg->mask;; i = (i + 1) & cfg->mask) {
+    grex_config_slot_t* slot = &cfg->slots[i];
+    if (!slot->entry) {
+      return slot;
+    }
+    if (slot->hash == hash && slot->entry->key.len == len && !memcmp(slot->entry->key.ptr, key, len)) {
+      return slot;
+    }
+  }
+}
+
+// Resizes the slots, moving the entries by their stored hash
+static grex_result_t config_resize(grex_config_t* cfg, size_t size) {
+  grex_config_slot_t* slots = calloc(size, sizeof(*slots));
+  if (!slots) {
+    return GREX_ALLOC_ERR;
+  }
+
+  for (size_t i = 0; cfg->slots && i <= cfg->mask; i++) {
+    if (cfg->slots[i].entry) {
+      size_t j = cfg->slots[i].hash & (size - 1);
+      while (slots[j].entry) {
+        j = (j + 1) & (size - 1);
+      }
+      slots[j] = cfg->slots[i];
+    }
+  }
+
+  free(cfg->slots);
+  cfg->slots = slots;
+  cfg->mask = size - 1;
+  return GREX_OK;
+}
+
+// Adds the entries of a fragment to the index, replacing the ones with the same key
+static grex_result_t config_index(grex_config_t* cfg, const grex_config_fragment_t* f) {
+  if (!cfg->slots && config_resize(cfg, GREX_CONFIG_SLOTS) != GREX_OK) {
+    return GREX_ALLOC_ERR;
+  }
+
+  for (size_t i = 0; i < f->count; i++) {
+    const grex_config_entry_t* e = &f->entries[i];
+    grex_config_slot_t* slot = config_probe(cfg, e->key.ptr, e->key.len, e->hash);
+    if (!slot->entry) {
+      // Keeps the index at most half full
+      if ((cfg->count + 1) * 2 > cfg->mask + 1) {
+        if (config_resize(cfg, (cfg->mask + 1) * 2) != GREX_OK) {
+          return GREX_ALLOC_ERR;
+        }
+        slot = config_probe(cfg, e->key.ptr, e->key.len, e->hash);
+      }
+      slot->hash = e->hash;
+      cfg->count++;
+    }
+    slot->entry = e;
+  }
+  return GREX_OK;
+}
+
+grex_result_t grex_config_load_file(grex_config_t* cfg, const char* path) {
+  unsigned long long stamp, size;
+  if (config_stat(path, &stamp, &size) != GREX_OK) {
+    return GREX_IO_ERR;
+  }
 
+  grex_result_t result = config_fragment_add(cfg, path);
+  if (result != GREX_OK) {
+    return result;
+  }
+
+  size_t index = cfg->fragment_count - 1;
+  result = config_fragment_load(cfg, index, stamp, size);
   if (result == GREX_OK) {
-    int n = p->parsing_offset - prev_offset;
-    if (n >= size) {
-      n = size - 1;
+    return config_index(cfg, &cfg->fragments[index]);
+  }
+
+  // A malformed file stays, with an unknown stamp so the next reload parses it again
+  if (result != GREX_NO_MATCH) {
+    config_fragment_pop(cfg);
+  }
+  return result;
+}
+
+grex_result_t grex_config_load_string(grex_config_t* cfg, const char* text, size_t length) {
+  grex_result_t result = config_fragment_add(cfg, NULL);
+  if (result != GREX_OK) {
+    return result;
+  }
+
+  size_t index = cfg->fragment_count - 1;
+  result = config_fragment_parse(cfg, index, text, length);
+  if (result != GREX_OK) {
+    config_fragment_pop(cfg);
+    return result;
+  }
+  return config_index(cfg, &cfg->fragments[index]);
+}
+
+grex_result_t grex_config_reload(grex_config_t* cfg, size_t* reloaded) {
+  grex_result_t result = GREX_OK;
+  size_t count = 0;
+
+  for (size_t i = 0; i < cfg->fragment_count; i++) {
+    const grex_config_fragment_t* f = &cfg->fragments[i];
+    unsigned long long stamp, size;
+    if (!f->path) {
+      continue;
+    }
+
+    grex_result_t r = config_stat(f->path, &stamp, &size);
+    if (r == GREX_OK) {
+      if (stamp == f->stamp && size == f->size && stamp != GREX_CONFIG_STAMP_UNKNOWN) {
+        continue;
+      }
+      r = config_fragment_load(cfg, i, stamp, size);
+    }
+
+    if (r == GREX_OK) {
+      count++;
+    }
+    else if (result == GREX_OK) {
+      result = r;
+    }
+  }
+
+  // The replaced entries are gone, so the index is built again in fragment order
+  if (count) {
+    if (cfg->slots) {
+      memset(cfg->slots, 0, (cfg->mask + 1) * sizeof(*cfg->slots));
+    }
+    cfg->count = 0;
+    for (size_t i = 0; i < cfg->fragment_count; i++) {
+      if (config_index(cfg, &cfg->fragments[i]) != GREX_OK) {
+        result = GREX_ALLOC_ERR;
+        break;
+      }
+    }
+  }
+
+  if (reloaded) {
+    *reloaded = count;
+  }
+  return result;
+}
+
+const grex_config_entry_t* grex_config_find(const grex_config_t* cfg, const char* key) {
+  if (!cfg->slots) {
+    return NULL;
+  }
+
+  size_t len = strlen(key);
+  return config_probe(cfg, key, len, intern_hash(key, len))->entry;
+}
+
+grex_result_t grex_config_string(const grex_config_t* cfg, const char* key, char* buf, size_t size) {
+  const grex_config_entry_t* e = grex_config_find(cfg, key);
+  if (!e) {
+    return GREX_NO_MATCH;
+  }
+
+  if (e->value.flags & GREX_SPAN_ESCAPED) {
+    grex_span_unescape(&e->value, e->quote, buf, size);
+  }
+  else if (size > 0) {
+    size_t n = e->value.len < size ? e->value.len : size - 1;
+    memcpy(buf, e->value.ptr, n);
+    buf[n] = 0;
+  }
+  return GREX_OK;
+}
+
+// A parser over the value of the key, for the number primitives
+static int config_value_parser(const grex_config_t* cfg, const char* key, grex_parser_t* p) {
+  const grex_config_entry_t* e = grex_config_find(cfg, key);
+  if (!e) {
+    return 0;
+  }
+
+  memset(p, 0, sizeof(*p));
+  grex_parser_init(p, e->value.ptr, e->value.len);
+  return 1;
+}
+
+grex_result_t grex_config_integer(const grex_config_t* cfg, const char* key, long long* value) {
+  grex_parser_t p;
+  long long v;
+  if (!config_value_parser(cfg, key, &p)) {
+    return GREX_NO_MATCH;
+  }
+
+  grex_result_t result = grex_integer(&p, 0, &v);
+  if ((result == GREX_OK || result == GREX_RANGE_ERR) && p.parsing_offset == p.input_length) {
+    *value = v;
+    return result;
+  }
+  return GREX_NO_MATCH;
+}
+
+grex_result_t grex_config_float(const grex_config_t* cfg, const char* key, double* value) {
+  grex_parser_t p;
+  double v;
+  if (!config_value_parser(cfg, key, &p)) {
+    return GREX_NO_MATCH;
+  }
+
+  grex_result_t result = grex_float(&p, &v);
+  if (result != GREX_OK || p.parsing_offset != p.input_length) {
+    return GREX_NO_MATCH;
+  }
+
+  // grex_float reads a number too large for a double as an infinity, only inf and infinity are meant as one
+  const char* s = p.input + (*p.input == '+' || *p.input == '-');
+  if ((v > DBL_MAX || v < -DBL_MAX) && *s != 'i' && *s != 'I') {
+    result = GREX_RANGE_ERR;
+  }
+  *value = v;
+  return result;
+}
+
+grex_result_t grex_config_bool(const grex_config_t* cfg, const char* key, int* value) {
+  // Odd indexes are true
+  static const char* const words[] = { "false", "true", "no", "yes", "off", "on", "0", "1" };
+
+  const grex_config_entry_t* e = grex_config_find(cfg, key);
+  if (!e) {
+    return GREX_NO_MATCH;
+  }
+
+  for (unsigned i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+    size_t n = strlen(words[i]);
+    size_t k = 0;
+    while (k < n && k < e->value.len && tolower((unsigned char)e->value.ptr[k]) == words[i][k]) {
+      k++;
+    }
+    if (k == n && e->value.len == n) {
+      *value = (int)(i & 1);
+      return GREX_OK;
+    }
+  }
+  return GREX_NO_MATCH;
+}
+
+void grex_csv_init(grex_csv_t* csv, int delimiter, int quote) {
+  csv->delimiter = (unsigned char)delimiter;
+  csv->quote = (unsigned char)quote;
+  csv->map = NULL;
+  csv->map_count = 0;
+}
+
+void grex_csv_destroy(grex_csv_t* csv) {
+  free(csv->map);
+  csv->map = NULL;
+  csv->map_count = 0;
+}
+
+grex_result_t grex_csv_select(grex_csv_t* csv, const size_t* columns, size_t count) {
+  if (!columns) {
+    grex_csv_destroy(csv);
+    return GREX_OK;
+  }
+
+  size_t map_count = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (columns[i] == (size_t)-1) {
+      return GREX_RANGE_ERR;
+    }
+    if (columns[i] >= map_count) {
+      map_count = columns[i] + 1;
+    }
+  }
+
+  size_t* map = calloc(map_count ? map_count : 1, sizeof(size_t));
+  if (!map) {
+    return GREX_ALLOC_ERR;
+  }
+  for (size_t i = 0; i < count; i++) {
+    map[columns[i]] = i + 1;
+  }
+
+  free(csv->map);
+  csv->map = map;
+  csv->map_count = map_count;
+  return GREX_OK;
+}
+
+// Sets each bit to the parity of the bits up to it, which turns the quotes of a word into the characters they enclose
+static inline unsigned long long csv_prefix_xor(unsigned long long x) {
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
+
+#if defined(GREX_AVX2)
+static inline unsigned long long csv_mask_avx2(__m256i lo, __m256i hi, __m256i c) {
+  return (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, c))
+    | (unsigned long long)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, c)) << 32;
+}
+#endif
+
+// Marks the delimiters, quotes and line feeds of the n <= 64 characters at s
+static inline void csv_classify(const grex_csv_t* csv, const unsigned char* s, size_t n, unsigned long long* delimiters,
+                                unsigned long long* quotes, unsigned long long* newlines) {
+#if defined(GREX_AVX2)
+  if (n == 64) {
+    __m256i lo = _mm256_loadu_si256((const __m256i*)s);
+    __m256i hi = _mm256_loadu_si256((const __m256i*)(s + 32));
+    *delimiters = csv_mask_avx2(lo, hi, _mm256_set1_epi8((char)csv->delimiter));
+    *quotes = csv_mask_avx2(lo, hi, _mm256_set1_epi8((char)csv->quote));
+    *newlines = csv_mask_avx2(lo, hi, _mm256_set1_epi8('\n'));
+    return;
+  }
+#elif defined(GREX_SSE2)
+  if (n == 64) {
+    __m128i delimiter = _mm_set1_epi8((char)csv->delimiter);
+    __m128i quote = _mm_set1_epi8((char)csv->quote);
+    __m128i newline = _mm_set1_epi8('\n');
+    unsigned long long d = 0, q = 0, l = 0;
+    for (int k = 0; k < 4; k++) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(s + k * 16));
+      d |= (unsigned long long)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, delimiter)) << (k * 16);
+      q |= (unsigned long long)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)) << (k * 16);
+      l |= (unsigned long long)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, newline)) << (k * 16);
+    }
+    *delimiters = d;
+    *quotes = q;
+    *newlines = l;
+    return;
+  }
+#endif
+
+  unsigned long long d = 0, q = 0, l = 0;
+  for (size_t i = 0; i < n; i++) {
+    d |= (unsigned long long)(s[i] == csv->delimiter) << i;
+    q |= (unsigned long long)(s[i] == csv->quote) << i;
+    l |= (unsigned long long)(s[i] == '\n') << i;
+  }
+  *delimiters = d;
+  *quotes = q;
+  *newlines = l;
+}
+
+// Returns the field that receives a column plus one, or zero if the column is skipped
+static inline size_t csv_field_index(const grex_csv_t* csv, size_t column, size_t capacity) {
+  size_t index = column + 1;
+  if (csv->map) {
+    index = column < csv->map_count ? csv->map[column] : 0;
+  }
+  return index <= capacity ? index : 0;
+}
+
+// Sets the span of the field between s and end, without the carriage return of a line end and the quotes
+static inline void csv_field(const grex_csv_t* csv, const char* s, const char* end, int line_end, grex_span_t* span) {
+  if (line_end && end > s && end[-1] == '\r') {
+    end--;
+  }
+
+  span->flags = 0;
+  if (end - s >= 2 && (unsigned char)*s == csv->quote && (unsigned char)end[-1] == csv->quote) {
+    s++;
+    end--;
+    if (memchr(s, csv->quote, end - s)) {
+      span->flags = GREX_SPAN_ESCAPED;
+    }
+  }
+  span->ptr = s;
+  span->len = end - s;
+}
+
+// Splits the record at the head into fields, stride spans apart, and moves the head past it.
+// Returns GREX_EOF if the window ends before the record does and more input may follow.
+static grex_result_t csv_record(const grex_csv_t* csv, grex_parser_t* p, grex_span_t* spans, size_t stride, size_t capacity, size_t* count) {
+  const unsigned char* u = (const unsigned char*)p->input;
+  size_t field = p->parsing_offset;
+  size_t column = 0;
+  size_t wanted = csv->map ? csv->map_count : capacity;
+  unsigned long long inside = 0;
+
+  for (size_t s = p->parsing_offset; s < p->input_length; s += 64) {
+    size_t n = p->input_length - s < 64 ? p->input_length - s : 64;
+    unsigned long long delimiters, quotes, newlines;
+    csv_classify(csv, u + s, n, &delimiters, &quotes, &newlines);
+
+    // The quote parity carries over from the previous word
+    unsigned long long quoted = csv_prefix_xor(quotes) ^ inside;
+    inside = 0 - ((quoted >> (n - 1)) & 1);
+
+    unsigned long long ends = (delimiters | newlines) & ~quoted;
+    while (ends) {
+      // Past the last selected column the delimiters are only counted
+      if (column >= wanted) {
+        unsigned long long lines = ends & newlines;
+        column += popcount64(lines ? ends & ((lines & (0 - lines)) - 1) : ends);
+        if (!lines) {
+          break;
+        }
+        ends = lines;
+      }
+
+      size_t e = s + ctz64(ends);
+      int line_end = u[e] == '\n';
+      size_t index = csv_field_index(csv, column, capacity);
+      if (index) {
+        csv_field(csv, &p->input[field], &p->input[e], line_end, &spans[(index - 1) * stride]);
+      }
+      column++;
+      field = e + 1;
+
+      if (line_end) {
+        p->parsing_offset = field;
+        *count = column;
+        return GREX_OK;
+      }
+      ends &= ends - 1;
+    }
+  }
+
+  if (p->read_callback) {
+    return GREX_EOF;
+  }
+  if (inside) {
+    report_error(p, GREX_PRIMITIVE_STRING);
+    return GREX_NO_MATCH;
+  }
+
+  // The last record may end without a line feed
+  size_t index = csv_field_index(csv, column, capacity);
+  if (index) {
+    csv_field(csv, &p->input[field], p->input_end, 1, &spans[(index - 1) * stride]);
+  }
+  p->parsing_offset = p->input_length;
+  *count = column + 1;
+  return GREX_OK;
+}
+
+// Reads a record into spans, refilling the window if allowed, and sets the fields it doesn't have to empty spans
+static grex_result_t csv_read(const grex_csv_t* csv, grex_parser_t* p, int refills, grex_span_t* spans, size_t stride, size_t capacity, size_t* count) {
+  grex_result_t result;
+  for (;;) {
+    if (p->parsing_offset < p->input_length) {
+      result = csv_record(csv, p, spans, stride, capacity, count);
+      if (result != GREX_EOF) {
+        break;
+      }
+    }
+    else if (!p->read_callback) {
+      return GREX_EOF;
+    }
+
+    // The record starts at the head, so it stays in the window
+    if (!refills) {
+      return GREX_EOF;
+    }
+    if (!refill(p, NULL) && p->read_callback) {
+      return GREX_ALLOC_ERR;
+    }
+  }
+
+  if (result != GREX_OK) {
+    return result;
+  }
+
+  size_t wanted = csv->map ? csv->map_count : capacity;
+  for (size_t column = *count; column < wanted; column++) {
+    size_t index = csv_field_index(csv, column, capacity);
+    if (index) {
+      grex_span_t* span = &spans[(index - 1) * stride];
+      span->ptr = &p->input[p->parsing_offset];
+      span->len = 0;
+      span->flags = 0;
     }
-    memset(buf, 0, size);
-    memcpy(buf, p->input + prev_offset, n);
   }
+  return GREX_OK;
+}
 
+grex_result_t grex_csv_row(const grex_csv_t* csv, grex_parser_t* p, grex_span_t* fields, size_t capacity, size_t* count) {
+  size_t columns;
+  grex_result_t result = csv_read(csv, p, 1, fields, 1, capacity, &columns);
+  if (result == GREX_OK && count) {
+    *count = columns;
+  }
   return result;
-}
\ No newline at end of file
+}
+
+grex_result_t grex_csv_batch_init(grex_csv_batch_t* batch, size_t fields, size_t capacity) {
+  size_t n = fields * capacity;
+  batch->spans = malloc((n ? n : 1) * sizeof(grex_span_t));
+  if (!batch->spans) {
+    return GREX_ALLOC_ERR;
+  }
+  batch->fields = fields;
+  batch->capacity = capacity;
+  batch->rows = 0;
+  return GREX_OK;
+}
+
+void grex_csv_batch_destroy(grex_csv_batch_t* batch) {
+  free(batch->spans);
+  batch->spans = NULL;
+  batch->rows = 0;
+}
+
+grex_result_t grex_csv_batch(const grex_csv_t* csv, grex_parser_t* p, grex_csv_batch_t* batch) {
+  batch->rows = 0;
+  while (batch->rows < batch->capacity) {
+    // Refilling would move the rows already read
+    size_t columns;
+    grex_result_t result = csv_read(csv, p, batch->rows == 0, batch->spans + batch->rows, batch->capacity, batch->fields, &columns);
+    if (result != GREX_OK) {
+      return batch->rows ? GREX_OK : result;
+    }
+    batch->rows++;
+  }
+  return GREX_OK;
+}
+
+size_t grex_csv_unescape(const grex_span_t* span, int quote, char* buf, size_t size) {
+  const char* s = span->ptr;
+  const char* end = s + span->len;
+  size_t room = size ? size - 1 : 0;
+  size_t n = 0;
+
+  while (s < end) {
+    const char* q = end;
+    if (span->flags & GREX_SPAN_ESCAPED) {
+      q = memchr(s, quote, end - s);
+      if (!q) {
+        q = end;
+      }
+    }
+
+    // Copy the run up to and including the next quote, then skip its double
+    n = append(buf, room, n, s, q < end ? q - s + 1 : q - s);
+    s = q < end ? q + 1 : end;
+    if (s < end && *s == (char)quote) {
+      s++;
+    }
+  }
+
+  if (size > 0) {
+    buf[n < room ? n : room] = 0;
+  }
+  return n;
+}
+
+#if defined(GREX_PROFILE)
+
+static const char* const profile_names[GREX_PROFILE_COUNT] = {
+#define GREX_PROFILE_NAME(NAME, name, params, args) #name,
+  GREX_PROFILE_PRIMITIVES(GREX_PROFILE_NAME)
+#undef GREX_PROFILE_NAME
+};
+
+static inline unsigned long long profile_ticks(void) {
+#if defined(GREX_PROFILE_RDTSC)
+  return __rdtsc();
+#elif defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#else
+  return (unsigned long long)clock();
+#endif
+}
+
+// The head is only past the end after stop_at_eof wrapped around on an empty input
+static inline unsigned long long profile_tell(const grex_parser_t* p) {
+  size_t offset = p->parsing_offset > p->input_length ? p->input_length : p->parsing_offset;
+  return p->stream_offset + offset;
+}
+
+typedef struct profile_call {
+  unsigned long long start;
+  unsigned long long ticks;
+  int timed;
+} profile_call_t;
+
+static inline void profile_enter(grex_parser_t* p, profile_call_t* call) {
+  grex_profile_t* prof = &p->profile;
+  if (prof->depth++) {
+    return;
+  }
+
+  call->start = profile_tell(p);
+  call->timed = prof->sample && --prof->countdown == 0;
+  if (call->timed) {
+    prof->countdown = prof->sample;
+    call->ticks = profile_ticks();
+  }
+}
+
+static inline void profile_leave(grex_parser_t* p, const profile_call_t* call, grex_profile_primitive_t primitive, grex_result_t result) {
+  grex_profile_t* prof = &p->profile;
+  if (--prof->depth) {
+    return;
+  }
+
+  grex_profile_counter_t* c = &prof->counters[primitive];
+  if (call->timed) {
+    c->ticks += profile_ticks() - call->ticks;
+    c->sampled++;
+  }
+
+  c->calls++;
+  if (result == GREX_NO_MATCH) {
+    c->no_match++;
+  }
+  else if (result == GREX_EOF) {
+    c->eof++;
+  }
+
+  unsigned long long end = profile_tell(p);
+  if (end < call->start) {
+    c->bytes += call->start - end;
+    return;
+  }
+
+  c->bytes += end - call->start;
+  if (call->start < prof->furthest) {
+    c->rescanned += (end < prof->furthest ? end : prof->furthest) - call->start;
+  }
+  if (end > prof->furthest) {
+    prof->furthest = end;
+  }
+}
+
+#define GREX_PROFILE_WRAPPER(NAME, name, params, args) \
+  grex_result_t name params { \
+    profile_call_t call = { 0, 0, 0 }; \
+    profile_enter(p, &call); \
+    grex_result_t result = name##_unprofiled args; \
+    profile_leave(p, &call, GREX_PROFILE_##NAME, result); \
+    return result; \
+  }
+
+GREX_PROFILE_PRIMITIVES(GREX_PROFILE_WRAPPER)
+
+#undef GREX_PROFILE_WRAPPER
+
+void grex_profile_reset(grex_parser_t* p) {
+  memset(p->profile.counters, 0, sizeof(p->profile.counters));
+  p->profile.furthest = 0;
+  p->profile.countdown = p->profile.sample;
+}
+
+void grex_profile_set_sample(grex_parser_t* p, unsigned period) {
+  p->profile.sample = period;
+  p->profile.countdown = period;
+}
+
+const char* grex_profile_name(grex_profile_primitive_t primitive) {
+  return primitive < GREX_PROFILE_COUNT ? profile_names[primitive] : "";
+}
+
+// Appends to the table, or only counts the length once it doesn't fit anymore
+static size_t profile_printf(char* buf, size_t size, size_t length, const char* fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(length < size ? buf + length : NULL, length < size ? size - length : 0, fmt, args);
+  va_end(args);
+  return n > 0 ? length + n : length;
+}
+
+size_t grex_profile_dump(const grex_parser_t* p, char* buf, size_t size) {
+  size_t length = 0;
+  if (size > 0) {
+    buf[0] = 0;
+  }
+
+  length = profile_printf(buf, size, length, "%-32s %12s %14s %10s %10s %14s %12s\n",
+                          "primitive", "calls", "bytes", "no match", "eof", "rescanned", "ticks/call");
+  for (unsigned i = 0; i < GREX_PROFILE_COUNT; i++) {
+    const grex_profile_counter_t* c = &p->profile.counters[i];
+    if (!c->calls) {
+      continue;
+    }
+
+    length = profile_printf(buf, size, length, "%-32s %12llu %14llu %10llu %10llu %14llu %12.1f\n",
+                            profile_names[i], c->calls, c->bytes, c->no_match, c->eof, c->rescanned,
+                            c->sampled ? (double)c->ticks / c->sampled : 0.0);
+  }
+  return length;
+}
+
+#endif
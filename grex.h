@@ -24,43 +24,421 @@ SOFTWARE.
 
 #pragma once
 
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef enum grex_result {
   GREX_OK = 0,
   GREX_NO_MATCH = 1,
   GREX_RANGE_ERR = 2,
+  GREX_ALLOC_ERR = 3,
+  GREX_IO_ERR = 4,
   GREX_EOF = -1,
 } grex_result_t;
 
 struct grex_parser;
 
+/// @brief Identifies the primitive that failed, for the deferred error mode
+typedef enum grex_primitive {
+  GREX_PRIMITIVE_WHITESPACE,
+  GREX_PRIMITIVE_WHITESPACE_NO_LINE,
+  GREX_PRIMITIVE_CHAR,
+  GREX_PRIMITIVE_SET,
+  GREX_PRIMITIVE_RANGE,
+  GREX_PRIMITIVE_SEQUENCE,
+  GREX_PRIMITIVE_SEQUENCE_REVERSE,
+  GREX_PRIMITIVE_SEQUENCE_NEEDLE,
+  GREX_PRIMITIVE_WHILE,
+  GREX_PRIMITIVE_UNTIL,
+  GREX_PRIMITIVE_UNTIL_ANY,
+  GREX_PRIMITIVE_WHILE_CLASS,
+  GREX_PRIMITIVE_UNTIL_CLASS,
+  GREX_PRIMITIVE_WHILE_SEQUENCE,
+  GREX_PRIMITIVE_WHILE_SEQUENCE_REVERSE,
+  GREX_PRIMITIVE_WHILE_NEEDLE,
+  GREX_PRIMITIVE_WHILE_NEEDLE_REVERSE,
+  GREX_PRIMITIVE_INTEGER,
+  GREX_PRIMITIVE_UINTEGER,
+  GREX_PRIMITIVE_FLOAT,
+  GREX_PRIMITIVE_IDENTIFIER,
+  GREX_PRIMITIVE_STRING,
+  GREX_PRIMITIVE_RANGE_WHILE,
+  GREX_PRIMITIVE_CHAR_CLASS,
+  GREX_PRIMITIVE_KEYWORD,
+  GREX_PRIMITIVE_COUNT,
+} grex_primitive_t;
+
+/// @brief Error mode: call the error callback on every failed primitive
+#define GREX_ERRORS_IMMEDIATE 0
+
+/// @brief Error mode: only record the furthest failure and the primitives expected there, see grex_parser_error
+#define GREX_ERRORS_DEFERRED 1
+
 /// @brief Error callback for handling parser errors
 typedef void (*grex_error_callback_t)(struct grex_parser*, const char* msg, void* arg);
 
+/// @brief Read callback for streaming parsers.
+/// Writes up to size bytes into buf and returns how many were written, 0 at the end of the stream.
+typedef size_t (*grex_read_callback_t)(void* arg, char* buf, size_t size);
+
+/// @brief Lazily built index of the line starts, see grex_parser_position
+typedef struct grex_line_index {
+  size_t* marks;
+  size_t count;
+  size_t capacity;
+  size_t indexed;
+  size_t lines;
+  unsigned long long base_line;
+  unsigned long long base_start;
+} grex_line_index_t;
+
+/// @brief The primitives counted in the GREX_PROFILE mode, as X(NAME, function, parameters, arguments)
+#define GREX_PROFILE_PRIMITIVES(X) \
+  X(WHITESPACE, grex_whitespace, (grex_parser_t* p), (p)) \
+  X(WHITESPACE_NO_LINE, grex_whitespace_no_line, (grex_parser_t* p), (p)) \
+  X(CHAR, grex_char, (grex_parser_t* p, int c), (p, c)) \
+  X(SET, grex_set, (grex_parser_t* p, const char* set), (p, set)) \
+  X(CHAR_CLASS, grex_char_class, (grex_parser_t* p, const grex_class_t* cls), (p, cls)) \
+  X(RANGE, grex_range, (grex_parser_t* p, const char* range), (p, range)) \
+  X(RANGE_WHILE, grex_range_while, (grex_parser_t* p, const char* range), (p, range)) \
+  X(SEQUENCE, grex_sequence, (grex_parser_t* p, const char* seq), (p, seq)) \
+  X(SEQUENCE_REVERSE, grex_sequence_reverse, (grex_parser_t* p, const char* seq), (p, seq)) \
+  X(WHILE, grex_while, (grex_parser_t* p, unsigned c), (p, c)) \
+  X(UNTIL, grex_until, (grex_parser_t* p, unsigned c), (p, c)) \
+  X(UNTIL_ANY, grex_until_any, (grex_parser_t* p, const char* set), (p, set)) \
+  X(WHILE_CLASS, grex_while_class, (grex_parser_t* p, const grex_class_t* cls), (p, cls)) \
+  X(UNTIL_CLASS, grex_until_class, (grex_parser_t* p, const grex_class_t* cls), (p, cls)) \
+  X(SEQUENCE_NEEDLE, grex_sequence_needle, (grex_parser_t* p, const grex_needle_t* n), (p, n)) \
+  X(WHILE_NEEDLE, grex_while_needle, (grex_parser_t* p, const grex_needle_t* n), (p, n)) \
+  X(WHILE_NEEDLE_REVERSE, grex_while_needle_reverse, (grex_parser_t* p, const grex_needle_t* n), (p, n)) \
+  X(UNTIL_NEEDLE, grex_until_needle, (grex_parser_t* p, const grex_needle_t* n), (p, n)) \
+  X(UNTIL_NEEDLE_REVERSE, grex_until_needle_reverse, (grex_parser_t* p, const grex_needle_t* n), (p, n)) \
+  X(WHILE_SEQUENCE, grex_while_sequence, (grex_parser_t* p, const char* seq), (p, seq)) \
+  X(WHILE_SEQUENCE_REVERSE, grex_while_sequence_reverse, (grex_parser_t* p, const char* seq), (p, seq)) \
+  X(UNTIL_SEQUENCE, grex_until_sequence, (grex_parser_t* p, const char* seq), (p, seq)) \
+  X(UNTIL_SEQUENCE_REVERSE, grex_until_sequence_reverse, (grex_parser_t* p, const char* seq), (p, seq)) \
+  X(UNTIL_ANY_SEQUENCE, grex_until_any_sequence, (grex_parser_t* p, const grex_sequences_t* set, unsigned* index), (p, set, index)) \
+  X(UNTIL_ANY_SEQUENCE_REVERSE, grex_until_any_sequence_reverse, (grex_parser_t* p, const grex_sequences_t* set, unsigned* index), (p, set, index)) \
+  X(KEYWORD, grex_keyword, (grex_parser_t* p, const grex_keywords_t* kw, unsigned* index), (p, kw, index)) \
+  X(INTEGER, grex_integer, (grex_parser_t* p, int base, long long *value), (p, base, value)) \
+  X(UINTEGER, grex_uinteger, (grex_parser_t* p, int base, unsigned long long* value), (p, base, value)) \
+  X(FLOAT_EX, grex_float_ex, (grex_parser_t* p, double* value, unsigned flags), (p, value, flags)) \
+  X(FLOAT, grex_float, (grex_parser_t* p, double* value), (p, value)) \
+  X(IDENTIFIER_SPAN, grex_identifier_span, (grex_parser_t* p, grex_span_t* span), (p, span)) \
+  X(IDENTIFIER, grex_identifier, (grex_parser_t* p, char* buf, unsigned size), (p, buf, size)) \
+  X(IDENTIFIER_ALLOC, grex_identifier_alloc, (grex_parser_t* p, grex_span_t* span), (p, span)) \
+  X(IDENTIFIER_INTERN, grex_identifier_intern, (grex_parser_t* p, unsigned* id, grex_span_t* span), (p, id, span)) \
+  X(DELIMITED_STRING_SPAN, grex_delimited_string_span, (grex_parser_t* p, int delim, grex_span_t* span), (p, delim, span)) \
+  X(SINGLE_QUOTED_STRING_SPAN, grex_single_quoted_string_span, (grex_parser_t* p, grex_span_t* span), (p, span)) \
+  X(DOUBLE_QUOTED_STRING_SPAN, grex_double_quoted_string_span, (grex_parser_t* p, grex_span_t* span), (p, span)) \
+  X(STRING_SPAN, grex_string_span, (grex_parser_t* p, grex_span_t* span), (p, span)) \
+  X(DELIMITED_STRING, grex_delimited_string, (grex_parser_t* p, int delim, char* buf, unsigned size), (p, delim, buf, size)) \
+  X(SINGLE_QUOTED_STRING, grex_single_quoted_string, (grex_parser_t* p, char* buf, unsigned size), (p, buf, size)) \
+  X(DOUBLE_QUOTED_STRING, grex_double_quoted_string, (grex_parser_t* p, char* buf, unsigned size), (p, buf, size)) \
+  X(STRING, grex_string, (grex_parser_t* p, char* buf, unsigned size), (p, buf, size)) \
+  X(DELIMITED_STRING_DECODE, grex_delimited_string_decode, (grex_parser_t* p, int delim, char* buf, size_t size, grex_span_t* span), (p, delim, buf, size, span)) \
+  X(STRING_DECODE, grex_string_decode, (grex_parser_t* p, char* buf, size_t size, grex_span_t* span), (p, buf, size, span)) \
+  X(DELIMITED_STRING_ALLOC, grex_delimited_string_alloc, (grex_parser_t* p, int delim, grex_span_t* span), (p, delim, span)) \
+  X(STRING_ALLOC, grex_string_alloc, (grex_parser_t* p, grex_span_t* span), (p, span)) \
+  X(CAPTURE_UNTIL_SPAN, grex_capture_until_span, (grex_parser_t* p, int c, grex_span_t* span), (p, c, span)) \
+  X(CAPTURE_UNTIL_ALLOC, grex_capture_until_alloc, (grex_parser_t* p, int c, grex_span_t* span), (p, c, span)) \
+  X(CAPTURE_UNTIL_ANY_SPAN, grex_capture_until_any_span, (grex_parser_t* p, const char* set, grex_span_t* span), (p, set, span)) \
+  X(CAPTURE_UNTIL_ANY_ALLOC, grex_capture_until_any_alloc, (grex_parser_t* p, const char* set, grex_span_t* span), (p, set, span)) \
+  X(CAPTURE_UNTIL, grex_capture_until, (grex_parser_t* p, int c, char* buf, unsigned size), (p, c, buf, size)) \
+  X(CAPTURE_UNTIL_ANY, grex_capture_until_any, (grex_parser_t* p, const char* set, char* buf, unsigned size), (p, set, buf, size)) \
+  X(PATTERN_MATCH, grex_pattern_match, (grex_parser_t* p, const grex_pattern_t* pat, grex_span_t* captures, unsigned capture_count), (p, pat, captures, capture_count))
+
+#if defined(GREX_PROFILE)
+
+/// @brief Identifies a primitive in the profile counters
+typedef enum grex_profile_primitive {
+#define GREX_PROFILE_ENUM(NAME, name, params, args) GREX_PROFILE_##NAME,
+  GREX_PROFILE_PRIMITIVES(GREX_PROFILE_ENUM)
+#undef GREX_PROFILE_ENUM
+  GREX_PROFILE_COUNT,
+} grex_profile_primitive_t;
+
+/// @brief The counters of a primitive. A primitive called by another one is counted as part of the outer call.
+typedef struct grex_profile_counter {
+  unsigned long long calls;
+  unsigned long long bytes;
+  unsigned long long no_match;
+  unsigned long long eof;
+  unsigned long long rescanned;
+  unsigned long long ticks;
+  unsigned long long sampled;
+} grex_profile_counter_t;
+
+/// @brief Profile of a parser, in the GREX_PROFILE mode.
+/// Bytes are the distance the head moved, in either direction. Rescanned bytes are the ones a primitive consumed
+/// again after the parser was moved back, by a rewind or reset. With a sample period, one call every period calls
+/// is timed, and ticks holds the cycles (or nanoseconds where there is no cycle counter) of the sampled calls.
+typedef struct grex_profile {
+  grex_profile_counter_t counters[GREX_PROFILE_COUNT];
+  unsigned long long furthest;
+  unsigned sample;
+  unsigned countdown;
+  unsigned depth;
+} grex_profile_t;
+
+/// @brief Zeroes the counters of the parser, keeping the sample period
+/// @param p
+void grex_profile_reset(struct grex_parser* p);
+
+/// @brief Times one primitive call every period calls, or none if the period is 0, the default
+/// @param p
+/// @param period
+void grex_profile_set_sample(struct grex_parser* p, unsigned period);
+
+/// @brief The name of a primitive, such as "grex_until"
+/// @param primitive
+/// @return the name
+const char* grex_profile_name(grex_profile_primitive_t primitive);
+
+/// @brief Formats the counters of the primitives that were called as a table, one line each, truncated to size - 1 characters
+/// @param p
+/// @param buf
+/// @param size
+/// @return the length of the whole table
+size_t grex_profile_dump(const struct grex_parser* p, char* buf, size_t size);
+
+#else
+
+#define grex_profile_reset(p) ((void)0)
+#define grex_profile_set_sample(p, period) ((void)0)
+#define grex_profile_dump(p, buf, size) ((size) ? (void)((buf)[0] = 0) : (void)0, (size_t)0)
+
+#endif
+
 /// @brief The parser structure
 typedef struct grex_parser {
   const char* input;
   const char* input_end;
-  unsigned input_length;
-  unsigned parsing_offset;
+  size_t input_length;
+  size_t parsing_offset;
   grex_error_callback_t error_callback;
   void* error_callback_arg;
+  int error_mode;
+  unsigned long long error_offset;
+  unsigned long long error_expected;
+  grex_read_callback_t read_callback;
+  void* read_callback_arg;
+  char* window;
+  size_t window_size;
+  unsigned long long stream_offset;
+  unsigned long long stream_hold;
+  void* file_data;
+  size_t file_size;
+  grex_line_index_t line_index;
+  struct grex_structural* structural;
+  struct grex_arena* arena;
+  struct grex_intern* intern;
+#if defined(GREX_PROFILE)
+  grex_profile_t profile;
+#endif
 } grex_parser_t;
 
-/// @brief Initialize the parser with the input
+/// @brief Initialize the parser with the input. The error callback and mode are kept, so start from a zeroed parser.
+/// Nothing the parser held is released: call grex_parser_destroy first on a parser that was streaming, opened a file,
+/// or built its line or structural index.
 /// @param p
 /// @param input
 /// @param length
-void grex_parser_init(grex_parser_t* p, const char* input, unsigned length);
+void grex_parser_init(grex_parser_t* p, const char* input, size_t length);
+
+/// @brief Initialize the parser with the contents of a file, mapped read-only into memory.
+/// The mapping is advised for sequential access and huge pages where the platform supports it.
+/// Platforms without memory mapping read the whole file instead.
+/// @param p
+/// @param path
+/// @return GREX_OK on success, GREX_IO_ERR if the file can't be opened or mapped, GREX_ALLOC_ERR if it can't be read into memory
+grex_result_t grex_parser_open_file(grex_parser_t* p, const char* path);
+
+/// @brief Releases the file opened with grex_parser_open_file and leaves the parser with an empty input
+/// @param p
+void grex_parser_close_file(grex_parser_t* p);
+
+/// @brief Initialize the parser to stream its input from a read callback.
+/// The parser keeps a sliding window of the input: it reads more when a primitive reaches the end
+/// of the window and discards the input behind the reading head, so memory stays proportional to
+/// the window size. The window only grows to fit a single token (string, capture, number) larger than it.
+/// Spans and offsets point into the window, so they are only valid until the next primitive is called,
+/// and the reverse primitives can't go back further than the start of the window.
+/// @param p
+/// @param cb
+/// @param arg
+/// @param window_size
+/// @return GREX_OK on success, GREX_ALLOC_ERR if the window can't be allocated
+grex_result_t grex_parser_init_stream(grex_parser_t* p, grex_read_callback_t cb, void* arg, size_t window_size);
+
+/// @brief Read callback for a stdio FILE, to be used with grex_parser_init_stream
+/// @param file
+/// @param buf
+/// @param size
+/// @return the number of bytes read
+size_t grex_read_stdio(void* file, char* buf, size_t size);
+
+/// @brief Returns the position of the reading head from the start of the input, including streamed input already discarded
+/// @param p
+/// @return the absolute offset of the reading head
+unsigned long long grex_parser_tell(const grex_parser_t* p);
+
+/// @brief A position to go back to, see grex_parser_mark
+typedef struct grex_mark {
+  unsigned long long offset;
+  unsigned long long hold;
+} grex_mark_t;
+
+/// @brief Saves the position of the reading head, to try an alternative and rewind if it fails.
+/// A streaming parser keeps the input from the mark on until it is released,
+/// so marks must be released in the reverse order they were taken.
+/// @param p
+/// @param mark
+void grex_parser_mark(grex_parser_t* p, grex_mark_t* mark);
+
+/// @brief Moves the reading head back to the mark. The mark stays valid until it is released.
+/// @param p
+/// @param mark
+void grex_parser_rewind(grex_parser_t* p, const grex_mark_t* mark);
+
+/// @brief Releases the mark, letting a streaming parser discard the input before it
+/// @param p
+/// @param mark
+void grex_parser_release(grex_parser_t* p, const grex_mark_t* mark);
+
+/// @brief An entry of the packrat cache
+typedef struct grex_memo_entry {
+  unsigned long long offset;
+  unsigned long long end;
+  unsigned rule;
+  int result;
+} grex_memo_entry_t;
+
+/// @brief A bounded packrat cache of rule results, keyed by (rule, offset).
+/// The table has a fixed number of slots and a new result replaces the one in its slot,
+/// so memory never grows with the input.
+typedef struct grex_memo {
+  grex_memo_entry_t* entries;
+  size_t mask;
+} grex_memo_t;
+
+/// @brief Allocates the cache, with the capacity rounded up to a power of two
+/// @param m
+/// @param capacity
+/// @return GREX_OK on success, GREX_ALLOC_ERR if the table can't be allocated
+grex_result_t grex_memo_init(grex_memo_t* m, size_t capacity);
+
+/// @brief Releases the cache
+/// @param m
+void grex_memo_destroy(grex_memo_t* m);
+
+/// @brief Forgets every result, for example before parsing another input
+/// @param m
+void grex_memo_clear(grex_memo_t* m);
+
+/// @brief Looks up the result of a rule at the reading head.
+/// On a hit the head moves to where the rule ended, as if it had just run.
+/// @param p
+/// @param m
+/// @param rule
+/// @param result
+/// @return non-zero on a hit, with the rule's result stored in result
+int grex_memo_lookup(grex_parser_t* p, const grex_memo_t* m, unsigned rule, grex_result_t* result);
+
+/// @brief Stores the result of a rule that started at the mark and ended at the reading head
+/// @param p
+/// @param m
+/// @param rule
+/// @param start
+/// @param result
+void grex_memo_store(grex_parser_t* p, grex_memo_t* m, unsigned rule, const grex_mark_t* start, grex_result_t result);
+
+/// @brief A block of arena memory
+typedef struct grex_arena_block {
+  struct grex_arena_block* next;
+  size_t size;
+  size_t used;
+} grex_arena_block_t;
+
+/// @brief A bump allocator for parse results, freed all at once.
+/// Memory comes from a chain of blocks. Resetting or releasing keeps the blocks for the next allocations,
+/// so a parser that resets the arena per record stops calling malloc once the blocks fit the largest record.
+typedef struct grex_arena {
+  grex_arena_block_t* first;
+  grex_arena_block_t* current;
+  size_t block_size;
+} grex_arena_t;
+
+/// @brief A position to release the arena back to, see grex_arena_mark
+typedef struct grex_arena_mark {
+  grex_arena_block_t* block;
+  size_t used;
+} grex_arena_mark_t;
+
+/// @brief Default block size of an arena
+#define GREX_ARENA_BLOCK (16 * 1024)
+
+/// @brief Initialize an empty arena, the first block is allocated with the first allocation
+/// @param a
+/// @param block_size or 0 for GREX_ARENA_BLOCK. Larger allocations get a block of their own.
+void grex_arena_init(grex_arena_t* a, size_t block_size);
+
+/// @brief Releases every block of the arena
+/// @param a
+void grex_arena_destroy(grex_arena_t* a);
+
+/// @brief Allocates memory aligned for any type
+/// @param a
+/// @param size
+/// @return the memory, or NULL if a block can't be allocated
+void* grex_arena_alloc(grex_arena_t* a, size_t size);
+
+/// @brief Frees everything allocated from the arena, keeping the blocks
+/// @param a
+void grex_arena_reset(grex_arena_t* a);
+
+/// @brief Saves the position of the arena, to free what is allocated after it
+/// @param a
+/// @param mark
+void grex_arena_mark(const grex_arena_t* a, grex_arena_mark_t* mark);
+
+/// @brief Frees everything allocated since the mark, keeping the blocks
+/// @param a
+/// @param mark
+void grex_arena_release(grex_arena_t* a, const grex_arena_mark_t* mark);
+
+/// @brief Sets the arena the *_alloc primitives copy their results into, or NULL.
+/// The parser doesn't own the arena, and forgets it when it is initialized again.
+/// @param p
+/// @param a
+void grex_parser_set_arena(grex_parser_t* p, grex_arena_t* a);
+
+/// @brief Converts an offset, as returned by grex_parser_tell, into a line and column, both starting at 1.
+/// The newline index is built the first time a position is requested, and only up to that offset,
+/// so it can be called from the error callback. Streaming parsers only know the positions in the current window,
+/// and only count the lines of the input they discard while they report errors, through a callback or the deferred mode.
+/// Otherwise their lines start over at the window.
+/// @param p
+/// @param offset
+/// @param line
+/// @param column
+/// @return GREX_OK on success, GREX_NO_MATCH if the offset is not in the input, GREX_ALLOC_ERR if the index can't grow
+grex_result_t grex_parser_position(grex_parser_t* p, unsigned long long offset, unsigned long long* line, unsigned long long* column);
 
 /// @brief Releases all resources used by the parser
 /// @param p
 void grex_parser_destroy(grex_parser_t* p);
 
-/// @brief Reset the parser's reading head to the start of the input
+/// @brief Reset the parser's reading head to the start of the input.
+/// A streaming parser goes back to the start of the window instead.
 /// @param p
 void grex_parser_reset(grex_parser_t* p);
 
-/// @brief Set the parser's reading head to the end of the input
+/// @brief Set the parser's reading head to the end of the input.
+/// A streaming parser goes to the end of the window instead.
 /// @param p
 void grex_parser_end(grex_parser_t* p);
 
@@ -70,6 +448,278 @@ void grex_parser_end(grex_parser_t* p);
 /// @param arg
 void grex_parser_set_error_callback(grex_parser_t* p, grex_error_callback_t cb, void* arg);
 
+/// @brief Sets how failed primitives are reported, GREX_ERRORS_IMMEDIATE or GREX_ERRORS_DEFERRED.
+/// In the deferred mode the error callback is not called: the parser keeps the offset of the furthest
+/// failure and a bit (1 << grex_primitive_t) for every primitive that failed there.
+/// @param p
+/// @param mode
+void grex_parser_set_error_mode(grex_parser_t* p, int mode);
+
+/// @brief Forgets the failure recorded in the deferred error mode
+/// @param p
+void grex_parser_clear_error(grex_parser_t* p);
+
+/// @brief Formats the failure recorded in the deferred error mode, like "3:7: expected grex_integer or grex_float"
+/// @param p
+/// @param buf
+/// @param size
+/// @return the length of the whole message, which may be larger than what was written, or 0 if there is no failure
+size_t grex_parser_error(grex_parser_t* p, char* buf, size_t size);
+
+/// @brief Maximum number of byte ranges a class can have and still be scanned with SIMD
+#define GREX_CLASS_MAX_RANGES 8
+
+/// @brief Maximum number of characters grex_until_any can search for with SIMD
+#define GREX_UNTIL_ANY_MAX 8
+
+/// @brief A compiled character class.
+/// Build it once with the grex_class_* functions and reuse it for every scan.
+typedef struct grex_class {
+  unsigned long long bits[4];
+  unsigned range_count;
+  unsigned char ranges[GREX_CLASS_MAX_RANGES][2];
+} grex_class_t;
+
+/// @brief Empties the character class
+/// @param cls
+void grex_class_clear(grex_class_t* cls);
+
+/// @brief Adds every character of the set to the class
+/// @param cls
+/// @param set
+void grex_class_add_set(grex_class_t* cls, const char* set);
+
+/// @brief Adds an inclusive range of characters to the class
+/// @param cls
+/// @param first
+/// @param last
+void grex_class_add_range(grex_class_t* cls, int first, int last);
+
+/// @brief Inverts the class, so it matches every character it did not match before
+/// @param cls
+void grex_class_negate(grex_class_t* cls);
+
+/// @brief Compiles a class from a bracket-expression-like spec, such as "a-zA-Z0-9_".
+/// A leading '^' negates the class, a '-' between two characters makes a range, and is literal
+/// at the start or the end. A backslash makes the next character literal. Only a '-' makes a range,
+/// so "ac" is the set of 'a' and 'c', and the two-character "az" of the first grex_range is now written "a-z".
+/// @param cls
+/// @param spec
+/// @return GREX_OK on success, GREX_NO_MATCH if the spec is malformed
+grex_result_t grex_class_parse(grex_class_t* cls, const char* spec);
+
+/// @brief Checks if a character belongs to the class
+/// @param cls
+/// @param c
+/// @return non-zero if the character is in the class
+int grex_class_contains(const grex_class_t* cls, int c);
+
+/// @brief The span holds escape sequences that still have to be unescaped
+#define GREX_SPAN_ESCAPED 1
+
+/// @brief A view into the parser input. Spans are never null-terminated.
+typedef struct grex_span {
+  const char* ptr;
+  size_t len;
+  unsigned flags;
+} grex_span_t;
+
+/// @brief Unescapes a quoted string span into a null-terminated buffer, truncating it to size - 1 characters.
+/// Decodes the C and JSON escapes: \n \t \r \b \f \v \a, the escaped quotes, backslash, slash and delimiter,
+/// \xHH, octal \ooo, and \uXXXX (with surrogate pairs) or \UXXXXXXXX as UTF-8. Any other backslash is kept.
+/// The opening delimiter of a span returned by the string functions is span->ptr[-1].
+/// @param span
+/// @param delim
+/// @param buf
+/// @param size
+/// @return the length of the whole unescaped string, which may be larger than what was written
+size_t grex_span_unescape(const grex_span_t* span, int delim, char* buf, size_t size);
+
+/// @brief A slot of the intern table: the hash of a name and its id + 1, or 0 if the slot is empty
+typedef struct grex_intern_slot {
+  unsigned hash;
+  unsigned id;
+} grex_intern_slot_t;
+
+/// @brief An interning table, mapping names to small integer ids numbered from 0 in insertion order.
+/// Each name is copied once and keeps the same id and canonical copy until the table is cleared,
+/// so names can be compared and dispatched on by id. Slots are probed linearly and hold the full hash,
+/// so a lookup only compares the characters of a name with the same hash.
+typedef struct grex_intern {
+  grex_intern_slot_t* slots;
+  size_t mask;
+  grex_span_t* names;
+  size_t count;
+  size_t capacity;
+  grex_arena_t arena;
+} grex_intern_t;
+
+/// @brief Allocates the table, sized to hold the expected number of names without growing
+/// @param t
+/// @param expected
+/// @return GREX_OK on success, GREX_ALLOC_ERR if the table can't be allocated
+grex_result_t grex_intern_init(grex_intern_t* t, size_t expected);
+
+/// @brief Releases the table and the names
+/// @param t
+void grex_intern_destroy(grex_intern_t* t);
+
+/// @brief Forgets every name, keeping the memory for the next ones
+/// @param t
+void grex_intern_clear(grex_intern_t* t);
+
+/// @brief Interns a name, adding it if it isn't in the table yet
+/// @param t
+/// @param str
+/// @param len
+/// @param id
+/// @return GREX_OK on success, GREX_ALLOC_ERR if the table can't grow
+grex_result_t grex_intern_string(grex_intern_t* t, const char* str, size_t len, unsigned* id);
+
+/// @brief Looks up the id of a name without adding it
+/// @param t
+/// @param str
+/// @param len
+/// @param id
+/// @return non-zero if the name is in the table
+int grex_intern_find(const grex_intern_t* t, const char* str, size_t len, unsigned* id);
+
+/// @brief The canonical copy of a name, null-terminated
+/// @param t
+/// @param id
+/// @return the name, or NULL if there is no name with the id
+const grex_span_t* grex_intern_name(const grex_intern_t* t, unsigned id);
+
+/// @brief Sets the table grex_identifier_intern adds the identifiers to, or NULL.
+/// The parser doesn't own the table, and forgets it when it is initialized again.
+/// @param p
+/// @param t
+void grex_parser_set_intern(grex_parser_t* p, grex_intern_t* t);
+
+/// @brief A precompiled needle for the sequence scanners.
+/// It holds the Two-Way factorization of the sequence in both directions, so searching
+/// never rescans the input. The needle points to the sequence, which must outlive it.
+typedef struct grex_needle {
+  const char* seq;
+  size_t length;
+  size_t suffix;
+  size_t period;
+  int periodic;
+  size_t reverse_suffix;
+  size_t reverse_period;
+  int reverse_periodic;
+} grex_needle_t;
+
+/// @brief Precompiles a null-terminated sequence
+/// @param n
+/// @param seq
+void grex_needle_init(grex_needle_t* n, const char* seq);
+
+/// @brief Precompiles a sequence of the given length
+/// @param n
+/// @param seq
+/// @param length
+void grex_needle_init_length(grex_needle_t* n, const char* seq, size_t length);
+
+/// @brief grex_keywords_init flag: match the keyword that comes first in the list instead of the longest one
+#define GREX_KEYWORDS_FIRST 1
+
+/// @brief grex_keywords_init flag: only match keywords that are not followed by an identifier character
+#define GREX_KEYWORDS_WHOLE_WORD 2
+
+/// @brief A precompiled set of keywords, matched in a single pass.
+/// The keywords are sorted into a compact trie: a table on the first character, then every following
+/// character narrows the range of candidates. The set points to the keywords, which must outlive it.
+typedef struct grex_keywords {
+  const char** words;
+  unsigned* lengths;
+  unsigned* indices;
+  unsigned count;
+  unsigned max_length;
+  unsigned flags;
+  unsigned root[257];
+} grex_keywords_t;
+
+/// @brief Precompiles a set of keywords
+/// @param kw
+/// @param words
+/// @param count
+/// @param flags
+/// @return GREX_OK on success, GREX_NO_MATCH if a keyword is empty, GREX_ALLOC_ERR if the set can't be allocated
+grex_result_t grex_keywords_init(grex_keywords_t* kw, const char* const* words, unsigned count, unsigned flags);
+
+/// @brief Releases the keyword set
+/// @param kw
+void grex_keywords_destroy(grex_keywords_t* kw);
+
+/// @brief One direction of a sequence set: an Aho-Corasick automaton with every transition filled in
+typedef struct grex_automaton {
+  unsigned* next;
+  unsigned* depth;
+  unsigned* output;
+  unsigned* output_link;
+  unsigned state_count;
+} grex_automaton_t;
+
+/// @brief A precompiled set of sequences, searched for all at once.
+/// Bytes that appear in no sequence share one column of the transition tables, and the search
+/// skips to the next possible first (or last, in reverse) byte of a sequence with the SIMD kernels.
+/// The set points to the sequences, which must outlive it.
+typedef struct grex_sequences {
+  const char** seqs;
+  unsigned* lengths;
+  unsigned count;
+  unsigned alphabet_size;
+  unsigned char byte_class[256];
+  grex_automaton_t forward;
+  grex_automaton_t reverse;
+  unsigned first_count;
+  unsigned char first_bytes[GREX_UNTIL_ANY_MAX];
+  grex_class_t first;
+  grex_class_t last;
+} grex_sequences_t;
+
+/// @brief Precompiles a set of sequences
+/// @param set
+/// @param seqs
+/// @param count
+/// @return GREX_OK on success, GREX_NO_MATCH if a sequence is empty, GREX_ALLOC_ERR if the set can't be allocated
+grex_result_t grex_sequences_init(grex_sequences_t* set, const char* const* seqs, unsigned count);
+
+/// @brief Releases the sequence set
+/// @param set
+void grex_sequences_destroy(grex_sequences_t* set);
+
+/// @brief Structural characters of INI/CSV-like formats: quotes, backslash, newline, '=', ',' and '#'
+#define GREX_STRUCTURAL_DEFAULT "\"'\\\n=,#"
+
+/// @brief Default block size of the structural index, in characters
+#define GREX_STRUCTURAL_BLOCK (64 * 1024)
+
+/// @brief Structural index of a parser, see grex_parser_set_structural.
+/// Covers one block of the input at a time, with a bit per character in each bitmap.
+typedef struct grex_structural {
+  unsigned long long* bits;
+  unsigned long long* escaped;
+  unsigned long long start;
+  size_t length;
+  size_t capacity;
+  int carry;
+  int window_carry;
+  grex_class_t chars;
+  unsigned char nibbles[2][16];
+} grex_structural_t;
+
+/// @brief Enables the structural index: a pre-pass that marks the structural characters of the input and the
+/// characters escaped by a backslash in bitmaps, 64 characters at a time, one block ahead of the reading head.
+/// grex_until, grex_until_any, the captures and the strings then jump between the marked characters
+/// when every character they stop at is structural. Call it after the parser is initialized.
+/// @param p
+/// @param chars the structural characters, like GREX_STRUCTURAL_DEFAULT, or NULL to disable the index
+/// @param block_size in characters, or 0 for GREX_STRUCTURAL_BLOCK
+/// @return GREX_OK on success, GREX_ALLOC_ERR if the index can't be allocated
+grex_result_t grex_parser_set_structural(grex_parser_t* p, const char* chars, size_t block_size);
+
 /// @brief Matches on whitespace, including line breaks and carriage returns
 /// @param p
 /// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
@@ -92,12 +742,25 @@ grex_result_t grex_char(grex_parser_t* p, int c);
 /// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
 grex_result_t grex_set(grex_parser_t* p, const char* set);
 
-/// @brief Matches an inclusive range of characters
+/// @brief Matches a character of a class spec, such as "a-zA-Z0-9_" or "^0-9", see grex_class_parse.
+/// The spec is compiled on every call, use grex_class_parse and grex_char_class in loops.
 /// @param p
 /// @param range
 /// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
 grex_result_t grex_range(grex_parser_t* p, const char* range);
 
+/// @brief Keep advancing while the current character is in the class spec, see grex_class_parse
+/// @param p
+/// @param range
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
+grex_result_t grex_range_while(grex_parser_t* p, const char* range);
+
+/// @brief Matches a character of a compiled class
+/// @param p
+/// @param cls
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
+grex_result_t grex_char_class(grex_parser_t* p, const grex_class_t* cls);
+
 /// @brief Matches a sequence of characters.
 /// When the function returns, the parsing head is at the start of the sequence.
 /// @param p
@@ -112,6 +775,12 @@ grex_result_t grex_sequence(grex_parser_t* p, const char* seq);
 /// @return
 grex_result_t grex_sequence_reverse(grex_parser_t* p, const char* seq);
 
+/// @brief Matches a precompiled sequence of characters
+/// @param p
+/// @param n
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
+grex_result_t grex_sequence_needle(grex_parser_t* p, const grex_needle_t* n);
+
 /// @brief Keep advancing while the current character is equal
 /// @param p
 /// @param seq
@@ -124,6 +793,25 @@ grex_result_t grex_while(grex_parser_t* p, unsigned c);
 /// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
 grex_result_t grex_until(grex_parser_t* p, unsigned c);
 
+/// @brief Keep advancing while the current character is not any of the characters in the set.
+/// Sets of up to GREX_UNTIL_ANY_MAX characters use the same search kernel as grex_until.
+/// @param p
+/// @param set
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
+grex_result_t grex_until_any(grex_parser_t* p, const char* set);
+
+/// @brief Keep advancing while the current character is in the class
+/// @param p
+/// @param cls
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
+grex_result_t grex_while_class(grex_parser_t* p, const grex_class_t* cls);
+
+/// @brief Keep advancing while the current character is not in the class
+/// @param p
+/// @param cls
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
+grex_result_t grex_until_class(grex_parser_t* p, const grex_class_t* cls);
+
 /// @brief Keep advancing while the sequence of characters matches
 /// @param p
 /// @param seq
@@ -150,6 +838,57 @@ grex_result_t grex_until_sequence(grex_parser_t* p, const char* seq);
 /// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
 grex_result_t grex_until_sequence_reverse(grex_parser_t* p, const char* seq);
 
+/// @brief Keep advancing while the precompiled sequence matches
+/// @param p
+/// @param n
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
+grex_result_t grex_while_needle(grex_parser_t* p, const grex_needle_t* n);
+
+/// @brief Keep receding while the precompiled sequence matches
+/// @param p
+/// @param n
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input
+grex_result_t grex_while_needle_reverse(grex_parser_t* p, const grex_needle_t* n);
+
+/// @brief Keep advancing until the precompiled sequence matches.
+/// When the function returns, the parsing head is at the end of the sequence.
+/// @param p
+/// @param n
+/// @return GREX_OK on success, GREX_EOF if the sequence is not found
+grex_result_t grex_until_needle(grex_parser_t* p, const grex_needle_t* n);
+
+/// @brief Keep receding until the precompiled sequence matches.
+/// When the function returns, the parsing head is at the start of the sequence.
+/// @param p
+/// @param n
+/// @return GREX_OK on success, GREX_EOF if the sequence is not found
+grex_result_t grex_until_needle_reverse(grex_parser_t* p, const grex_needle_t* n);
+
+/// @brief Keep advancing until any sequence of the set matches.
+/// The match that starts first wins, and the longest one if several start at the same character.
+/// When the function returns, the parsing head is at the end of the sequence.
+/// @param p
+/// @param set
+/// @param index receives the position of the sequence in the list given to grex_sequences_init
+/// @return GREX_OK on success, GREX_EOF if no sequence is found
+grex_result_t grex_until_any_sequence(grex_parser_t* p, const grex_sequences_t* set, unsigned* index);
+
+/// @brief Keep receding until any sequence of the set matches.
+/// The match that starts last wins, and the longest one if several start at the same character.
+/// When the function returns, the parsing head is at the start of the sequence.
+/// @param p
+/// @param set
+/// @param index receives the position of the sequence in the list given to grex_sequences_init
+/// @return GREX_OK on success, GREX_EOF if no sequence is found
+grex_result_t grex_until_any_sequence_reverse(grex_parser_t* p, const grex_sequences_t* set, unsigned* index);
+
+/// @brief Matches the longest (or first, see GREX_KEYWORDS_FIRST) keyword of the set
+/// @param p
+/// @param kw
+/// @param index receives the position of the keyword in the list given to grex_keywords_init
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
+grex_result_t grex_keyword(grex_parser_t* p, const grex_keywords_t* kw, unsigned* index);
+
 /// @brief Matches an integer number
 /// @param p
 /// @param value
@@ -162,12 +901,29 @@ grex_result_t grex_integer(grex_parser_t* p, int base, long long *value);
 /// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
 grex_result_t grex_uinteger(grex_parser_t* p, int base, unsigned long long* value);
 
-/// @brief Matches a floating-point number
+/// @brief Matches a floating-point number.
+/// Accepts the same syntax as strtod in the "C" locale and returns the same value.
 /// @param p
 /// @param value
 /// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
 grex_result_t grex_float(grex_parser_t* p, double* value);
 
+/// @brief grex_float_ex flag: reject hexadecimal floats such as 0x1.8p3
+#define GREX_FLOAT_NO_HEX 1
+
+/// @brief grex_float_ex flag: reject inf, infinity and nan
+#define GREX_FLOAT_NO_INF_NAN 2
+
+/// @brief grex_float_ex flags: accept decimal floats only
+#define GREX_FLOAT_STRICT (GREX_FLOAT_NO_HEX | GREX_FLOAT_NO_INF_NAN)
+
+/// @brief Matches a floating-point number, with the GREX_FLOAT_* flags restricting the syntax
+/// @param p
+/// @param value
+/// @param flags
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
+grex_result_t grex_float_ex(grex_parser_t* p, double* value, unsigned flags);
+
 /// @brief Matches a C-like identifier sequence of characters
 /// @param p
 /// @param buf
@@ -175,6 +931,27 @@ grex_result_t grex_float(grex_parser_t* p, double* value);
 /// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
 grex_result_t grex_identifier(grex_parser_t* p, char* buf, unsigned size);
 
+/// @brief Matches a C-like identifier sequence of characters, without copying it
+/// @param p
+/// @param span
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
+grex_result_t grex_identifier_span(grex_parser_t* p, grex_span_t* span);
+
+/// @brief Matches a C-like identifier sequence of characters, copied into the parser's arena.
+/// The span points to the copy, which is null-terminated.
+/// @param p
+/// @param span
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof, GREX_ALLOC_ERR without an arena or memory
+grex_result_t grex_identifier_alloc(grex_parser_t* p, grex_span_t* span);
+
+/// @brief Matches a C-like identifier sequence of characters and interns it in the parser's table.
+/// The identifier is hashed while it is scanned, and the span points to the canonical copy.
+/// @param p
+/// @param id
+/// @param span
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof, GREX_ALLOC_ERR without a table or memory
+grex_result_t grex_identifier_intern(grex_parser_t* p, unsigned* id, grex_span_t* span);
+
 /// @brief Matches either a single or double quoted string
 /// @param p
 /// @param buf
@@ -182,6 +959,62 @@ grex_result_t grex_identifier(grex_parser_t* p, char* buf, unsigned size);
 /// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
 grex_result_t grex_string(grex_parser_t* p, char* buf, unsigned size);
 
+/// @brief Matches either a single or double quoted string, without copying it.
+/// The span excludes the delimiters and has GREX_SPAN_ESCAPED set if it holds escapes.
+/// @param p
+/// @param span
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
+grex_result_t grex_string_span(grex_parser_t* p, grex_span_t* span);
+
+/// @brief Matches a string enclosed in the delimiter
+/// @param p
+/// @param delim
+/// @param buf
+/// @param size
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
+grex_result_t grex_delimited_string(grex_parser_t* p, int delim, char* buf, unsigned size);
+
+/// @brief Matches a string enclosed in the delimiter, without copying it
+/// @param p
+/// @param delim
+/// @param span
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
+grex_result_t grex_delimited_string_span(grex_parser_t* p, int delim, grex_span_t* span);
+
+/// @brief Matches a string enclosed in the delimiter and unescapes it in the same pass, like grex_span_unescape.
+/// A string without escapes is returned as a span of the input, without copying it. Otherwise the span points to buf,
+/// which gets the unescaped string, null-terminated if there is room for it.
+/// @param p
+/// @param delim
+/// @param buf
+/// @param size
+/// @param span
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof, GREX_RANGE_ERR if the unescaped
+/// string doesn't fit in size characters: span->len is the size it needs and the head doesn't move
+grex_result_t grex_delimited_string_decode(grex_parser_t* p, int delim, char* buf, size_t size, grex_span_t* span);
+
+/// @brief Matches either a single or double quoted string and unescapes it in the same pass, see grex_delimited_string_decode
+/// @param p
+/// @param buf
+/// @param size
+/// @param span
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof, GREX_RANGE_ERR if the unescaped string doesn't fit
+grex_result_t grex_string_decode(grex_parser_t* p, char* buf, size_t size, grex_span_t* span);
+
+/// @brief Matches a string enclosed in the delimiter, unescaped into the parser's arena with its exact length.
+/// The span points to the copy, which is null-terminated.
+/// @param p
+/// @param delim
+/// @param span
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof, GREX_ALLOC_ERR without an arena or memory
+grex_result_t grex_delimited_string_alloc(grex_parser_t* p, int delim, grex_span_t* span);
+
+/// @brief Matches either a single or double quoted string, unescaped into the parser's arena, see grex_delimited_string_alloc
+/// @param p
+/// @param span
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof, GREX_ALLOC_ERR without an arena or memory
+grex_result_t grex_string_alloc(grex_parser_t* p, grex_span_t* span);
+
 /// @brief Matches a single-quoted string
 /// @param p
 /// @param buf
@@ -189,6 +1022,12 @@ grex_result_t grex_string(grex_parser_t* p, char* buf, unsigned size);
 /// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
 grex_result_t grex_single_quoted_string(grex_parser_t* p, char* buf, unsigned size);
 
+/// @brief Matches a single-quoted string, without copying it
+/// @param p
+/// @param span
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
+grex_result_t grex_single_quoted_string_span(grex_parser_t* p, grex_span_t* span);
+
 /// @brief Matches a double-quoted string
 /// @param p
 /// @param buf
@@ -196,10 +1035,446 @@ grex_result_t grex_single_quoted_string(grex_parser_t* p, char* buf, unsigned si
 /// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
 grex_result_t grex_double_quoted_string(grex_parser_t* p, char* buf, unsigned size);
 
+/// @brief Matches a double-quoted string, without copying it
+/// @param p
+/// @param span
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
+grex_result_t grex_double_quoted_string_span(grex_parser_t* p, grex_span_t* span);
+
 /// @brief Capture all characters until a character matches
 /// @param p
 /// @param c
 /// @param buf
 /// @param size
 /// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
-grex_result_t grex_capture_until(grex_parser_t* p, int c, char* buf, unsigned size);
\ No newline at end of file
+grex_result_t grex_capture_until(grex_parser_t* p, int c, char* buf, unsigned size);
+
+/// @brief Capture all characters until a character matches, without copying them
+/// @param p
+/// @param c
+/// @param span
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
+grex_result_t grex_capture_until_span(grex_parser_t* p, int c, grex_span_t* span);
+
+/// @brief Capture all characters until a character matches, copied into the parser's arena.
+/// The span points to the copy, which is null-terminated.
+/// @param p
+/// @param c
+/// @param span
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof, GREX_ALLOC_ERR without an arena or memory
+grex_result_t grex_capture_until_alloc(grex_parser_t* p, int c, grex_span_t* span);
+
+/// @brief Capture all characters until any of the characters in the set matches
+/// @param p
+/// @param set
+/// @param buf
+/// @param size
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
+grex_result_t grex_capture_until_any(grex_parser_t* p, const char* set, char* buf, unsigned size);
+
+/// @brief Capture all characters until any of the characters in the set matches, without copying them
+/// @param p
+/// @param set
+/// @param span
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof
+grex_result_t grex_capture_until_any_span(grex_parser_t* p, const char* set, grex_span_t* span);
+
+/// @brief Capture all characters until any of the characters in the set matches, copied into the parser's arena.
+/// The span points to the copy, which is null-terminated.
+/// @param p
+/// @param set
+/// @param span
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input, GREX_EOF on eof, GREX_ALLOC_ERR without an arena or memory
+grex_result_t grex_capture_until_any_alloc(grex_parser_t* p, const char* set, grex_span_t* span);
+
+/// @brief Maximum number of captures in a pattern
+#define GREX_PATTERN_MAX_CAPTURES 16
+
+/// @brief An instruction of a compiled pattern
+typedef struct grex_pattern_op {
+  unsigned char code;
+  unsigned char optional;
+  unsigned short capture;
+  unsigned arg;
+  unsigned index;
+  unsigned length;
+} grex_pattern_op_t;
+
+/// @brief A sequence of primitives compiled into bytecode and matched in a single call.
+/// Build it with the grex_pattern_* functions, which take the same arguments as the primitives,
+/// then compile it once and match it as many times as needed.
+typedef struct grex_pattern {
+  grex_pattern_op_t* ops;
+  size_t op_count;
+  size_t op_capacity;
+  grex_class_t* classes;
+  size_t class_count;
+  size_t class_capacity;
+  char* text;
+  size_t text_length;
+  size_t text_capacity;
+  grex_needle_t* needles;
+  unsigned capture_count;
+  unsigned open_captures;
+  unsigned capture_stack[GREX_PATTERN_MAX_CAPTURES];
+  int error;
+} grex_pattern_t;
+
+/// @brief Initializes an empty pattern
+/// @param pat
+void grex_pattern_init(grex_pattern_t* pat);
+
+/// @brief Releases all resources used by the pattern
+/// @param pat
+void grex_pattern_destroy(grex_pattern_t* pat);
+
+/// @brief Appends a specific character
+/// @param pat
+/// @param c
+void grex_pattern_char(grex_pattern_t* pat, int c);
+
+/// @brief Appends a sequence of characters
+/// @param pat
+/// @param seq
+void grex_pattern_sequence(grex_pattern_t* pat, const char* seq);
+
+/// @brief Appends a single character out of the set
+/// @param pat
+/// @param set
+void grex_pattern_set(grex_pattern_t* pat, const char* set);
+
+/// @brief Appends a single character out of the inclusive range
+/// @param pat
+/// @param first
+/// @param last
+void grex_pattern_range(grex_pattern_t* pat, int first, int last);
+
+/// @brief Appends a single character out of the class
+/// @param pat
+/// @param cls
+void grex_pattern_class(grex_pattern_t* pat, const grex_class_t* cls);
+
+/// @brief Appends one or more repetitions of a character
+/// @param pat
+/// @param c
+void grex_pattern_while(grex_pattern_t* pat, int c);
+
+/// @brief Appends one or more characters of the class
+/// @param pat
+/// @param cls
+void grex_pattern_while_class(grex_pattern_t* pat, const grex_class_t* cls);
+
+/// @brief Appends one or more characters up to the character, which is not consumed
+/// @param pat
+/// @param c
+void grex_pattern_until(grex_pattern_t* pat, int c);
+
+/// @brief Appends one or more characters up to any of the characters in the set, which is not consumed
+/// @param pat
+/// @param set
+void grex_pattern_until_any(grex_pattern_t* pat, const char* set);
+
+/// @brief Appends one or more characters up to a character in the class, which is not consumed
+/// @param pat
+/// @param cls
+void grex_pattern_until_class(grex_pattern_t* pat, const grex_class_t* cls);
+
+/// @brief Appends everything up to and including the sequence
+/// @param pat
+/// @param seq
+void grex_pattern_until_sequence(grex_pattern_t* pat, const char* seq);
+
+/// @brief Appends whitespace, including line breaks
+/// @param pat
+void grex_pattern_whitespace(grex_pattern_t* pat);
+
+/// @brief Appends whitespace, NOT including line breaks
+/// @param pat
+void grex_pattern_whitespace_no_line(grex_pattern_t* pat);
+
+/// @brief Appends an integer number, as grex_integer parses it
+/// @param pat
+/// @param base
+void grex_pattern_integer(grex_pattern_t* pat, int base);
+
+/// @brief Appends a floating-point number, as grex_float parses it
+/// @param pat
+void grex_pattern_float(grex_pattern_t* pat);
+
+/// @brief Appends a C-like identifier
+/// @param pat
+void grex_pattern_identifier(grex_pattern_t* pat);
+
+/// @brief Appends a single or double quoted string.
+/// Captured on its own, the capture holds the string without the delimiters, like grex_string_span.
+/// @param pat
+void grex_pattern_string(grex_pattern_t* pat);
+
+/// @brief Makes the last appended element optional: if it fails, the match goes on from where it started
+/// @param pat
+void grex_pattern_optional(grex_pattern_t* pat);
+
+/// @brief Starts a capture, which ends at the matching grex_pattern_capture_end
+/// @param pat
+/// @return the index of the capture in the spans given to grex_pattern_match
+unsigned grex_pattern_capture_begin(grex_pattern_t* pat);
+
+/// @brief Ends the innermost open capture
+/// @param pat
+void grex_pattern_capture_end(grex_pattern_t* pat);
+
+/// @brief Compiles the pattern, after which it can't be appended to anymore: appending sets the pattern's error,
+/// which the next grex_pattern_compile returns, and leaves the compiled ops as they are
+/// @param pat
+/// @return GREX_OK on success, GREX_NO_MATCH if the pattern is invalid, GREX_ALLOC_ERR if it ran out of memory
+grex_result_t grex_pattern_compile(grex_pattern_t* pat);
+
+/// @brief Matches the compiled pattern at the reading head.
+/// On failure the head goes back to where it was. The captures are valid until the next primitive is called,
+/// and a capture that matched nothing, like an optional string that isn't there, is an empty span.
+/// @param p
+/// @param pat
+/// @param captures
+/// @param capture_count
+/// @return GREX_OK on success, GREX_NO_MATCH on invalid input or a pattern that wasn't compiled, GREX_EOF on eof
+grex_result_t grex_pattern_match(grex_parser_t* p, const grex_pattern_t* pat, grex_span_t* captures, unsigned capture_count);
+
+/// @brief A chunk of the input parsed by grex_parse_parallel
+typedef struct grex_chunk {
+  size_t index;
+  size_t offset;
+  size_t length;
+  grex_result_t result;
+  void* data;
+} grex_chunk_t;
+
+/// @brief Moves a split point of grex_parse_parallel to a record boundary.
+/// Returns the offset of the first record that starts at or after offset, or length if there is none.
+typedef size_t (*grex_boundary_callback_t)(const char* input, size_t length, size_t offset, void* arg);
+
+/// @brief Parses one chunk on a worker thread, with a parser initialized on the chunk.
+/// The output of the chunk goes in chunk->data, and the returned result in chunk->result.
+typedef grex_result_t (*grex_chunk_callback_t)(grex_parser_t* p, grex_chunk_t* chunk, void* arg);
+
+/// @brief Receives the parsed chunks in input order, on the thread that called grex_parse_parallel
+typedef void (*grex_deliver_callback_t)(const grex_chunk_t* chunk, void* arg);
+
+/// @brief Options of grex_parse_parallel, see grex_parallel_init for the defaults
+typedef struct grex_parallel {
+  unsigned threads;
+  size_t chunks;
+  grex_boundary_callback_t boundary;
+  void* boundary_arg;
+  grex_chunk_callback_t parse;
+  grex_deliver_callback_t deliver;
+  void* arg;
+} grex_parallel_t;
+
+/// @brief Initialize the options with one thread per core, a few chunks per thread
+/// and records that end at a newline outside of double quotes
+/// @param par
+/// @param parse
+/// @param deliver may be NULL
+/// @param arg passed to parse and deliver
+void grex_parallel_init(grex_parallel_t* par, grex_chunk_callback_t parse, grex_deliver_callback_t deliver, void* arg);
+
+/// @brief Splits the input into chunks at record boundaries and parses them on a pool of threads.
+/// Without a boundary callback, a record ends at a newline outside of double quotes, where quotes are
+/// escaped by doubling them as in CSV. The quotes before each split point are counted in parallel first.
+/// Builds without threads (or with GREX_NO_THREADS defined) parse the chunks one after the other.
+/// @param par
+/// @param input
+/// @param length
+/// @return GREX_OK if every chunk was parsed, the result of the first chunk that failed otherwise, GREX_ALLOC_ERR if the chunks can't be allocated
+grex_result_t grex_parse_parallel(const grex_parallel_t* par, const char* input, size_t length);
+
+/// @brief A key of a config fragment and its value. The key is "section.key", or just "key" before
+/// the first section. The value is the text after the '=' without the surrounding blanks, the quotes
+/// of a quoted value and a trailing comment. Both are null-terminated copies owned by the config.
+typedef struct grex_config_entry {
+  grex_span_t key;
+  grex_span_t value;
+  unsigned hash;
+  int quote;
+  unsigned long long line;
+} grex_config_entry_t;
+
+/// @brief A file or string parsed into the config, with its own arena so it can be parsed again alone
+typedef struct grex_config_fragment {
+  char* path;
+  grex_arena_t arena;
+  grex_config_entry_t* entries;
+  size_t count;
+  size_t capacity;
+  unsigned long long stamp;
+  unsigned long long size;
+} grex_config_fragment_t;
+
+/// @brief A slot of the config index: the hash of a key and its entry, or NULL if the slot is empty
+typedef struct grex_config_slot {
+  unsigned hash;
+  const grex_config_entry_t* entry;
+} grex_config_slot_t;
+
+/// @brief The keys of a set of INI fragments in a flat hash index.
+/// A key of a later fragment replaces the same key of an earlier one, and a key repeated in a fragment keeps its last value.
+/// Values are kept as text and converted when they are read.
+typedef struct grex_config {
+  grex_config_fragment_t* fragments;
+  size_t fragment_count;
+  size_t fragment_capacity;
+  grex_config_slot_t* slots;
+  size_t mask;
+  size_t count;
+  size_t error_fragment;
+  unsigned long long error_line;
+} grex_config_t;
+
+/// @brief Initialize an empty config
+/// @param cfg
+void grex_config_init(grex_config_t* cfg);
+
+/// @brief Releases the fragments and the index
+/// @param cfg
+void grex_config_destroy(grex_config_t* cfg);
+
+/// @brief Parses an INI file into the config. Lines hold a [section], a key = value, or a comment starting with '#' or ';'.
+/// Values may be quoted with '"' or '\'', and unquoted values end at a '#' or ';' after a blank.
+/// A file that fails to parse stays in the config without keys, so grex_config_reload parses it again once it changes.
+/// @param cfg
+/// @param path
+/// @return GREX_OK on success, GREX_IO_ERR if the file can't be read, GREX_ALLOC_ERR, or GREX_NO_MATCH on a
+/// malformed line, with error_fragment and error_line set to where it is
+grex_result_t grex_config_load_file(grex_config_t* cfg, const char* path);
+
+/// @brief Parses an INI string into the config, like grex_config_load_file. The string is copied.
+/// @param cfg
+/// @param text
+/// @param length
+/// @return GREX_OK on success, GREX_ALLOC_ERR, or GREX_NO_MATCH on a malformed line
+grex_result_t grex_config_load_string(grex_config_t* cfg, const char* text, size_t length);
+
+/// @brief Parses again the files whose modification time or size changed since they were parsed.
+/// A file that can't be read or fails to parse keeps its previous keys.
+/// @param cfg
+/// @param reloaded receives the number of files parsed again, may be NULL
+/// @return GREX_OK on success, the error of the first file that failed otherwise
+grex_result_t grex_config_reload(grex_config_t* cfg, size_t* reloaded);
+
+/// @brief Looks up a key
+/// @param cfg
+/// @param key "section.key"
+/// @return the entry, valid until the config is reloaded or destroyed, or NULL if there is no such key
+const grex_config_entry_t* grex_config_find(const grex_config_t* cfg, const char* key);
+
+/// @brief Unescapes a value into a null-terminated buffer, truncating it to size - 1 characters.
+/// Quoted values are unescaped like grex_span_unescape, unquoted values are copied as they are.
+/// @param cfg
+/// @param key
+/// @param buf
+/// @param size
+/// @return GREX_OK on success, GREX_NO_MATCH if there is no such key
+grex_result_t grex_config_string(const grex_config_t* cfg, const char* key, char* buf, size_t size);
+
+/// @brief Converts a value to an integer, like grex_integer with base 0
+/// @param cfg
+/// @param key
+/// @param value
+/// @return GREX_OK on success, GREX_RANGE_ERR if the value was clamped, GREX_NO_MATCH if there is no such key or the value isn't an integer
+grex_result_t grex_config_integer(const grex_config_t* cfg, const char* key, long long* value);
+
+/// @brief Converts a value to a double, like grex_float
+/// @param cfg
+/// @param key
+/// @param value
+/// @return GREX_OK on success, GREX_RANGE_ERR if the value is too large for a double (value is set to an infinity),
+/// GREX_NO_MATCH if there is no such key or the value isn't a number
+grex_result_t grex_config_float(const grex_config_t* cfg, const char* key, double* value);
+
+/// @brief Converts a value to a boolean: true, yes, on and 1, or false, no, off and 0, in any case
+/// @param cfg
+/// @param key
+/// @param value receives 1 or 0
+/// @return GREX_OK on success, GREX_NO_MATCH if there is no such key or the value isn't a boolean
+grex_result_t grex_config_bool(const grex_config_t* cfg, const char* key, int* value);
+
+/// @brief A reader of delimited records, as in RFC 4180. Records end at a line feed, with an optional carriage return
+/// before it, and fields are split at the delimiter. A quote toggles quoting wherever it is, so a quoted field holds
+/// delimiters and line feeds, and a doubled quote inside it stands for a quote.
+/// The reader only holds the options, so one reader can be shared by several parsers.
+typedef struct grex_csv {
+  unsigned char delimiter;
+  unsigned char quote;
+  size_t* map;
+  size_t map_count;
+} grex_csv_t;
+
+/// @brief Initialize a reader that returns every column
+/// @param csv
+/// @param delimiter the field delimiter, like ',' or '\t'
+/// @param quote the quote, usually '"'
+void grex_csv_init(grex_csv_t* csv, int delimiter, int quote);
+
+/// @brief Releases the projection
+/// @param csv
+void grex_csv_destroy(grex_csv_t* csv);
+
+/// @brief Sets the columns to read. Field i of a row is column columns[i]. The other columns are neither copied nor
+/// unescaped, and past the last selected column the delimiters are only counted. Select each column at most once.
+/// @param csv
+/// @param columns the zero-based columns, or NULL to return every column again
+/// @param count
+/// @return GREX_OK on success, GREX_RANGE_ERR if a column is SIZE_MAX, GREX_ALLOC_ERR
+grex_result_t grex_csv_select(grex_csv_t* csv, const size_t* columns, size_t count);
+
+/// @brief Reads the record at the head and moves the head past it. The fields are spans into the input without
+/// the quotes of a quoted field, with GREX_SPAN_ESCAPED set if they hold a doubled quote; see grex_csv_unescape.
+/// Fields the record doesn't have are set to empty spans. In streaming mode the spans are valid until the next read.
+/// @param csv
+/// @param p
+/// @param fields receives the selected columns, or the first columns if there is no projection
+/// @param capacity the size of fields
+/// @param count receives the number of columns of the record, may be NULL
+/// @return GREX_OK on success, GREX_EOF if there is no record left, GREX_NO_MATCH if a quote is left open at the
+/// end of the input, GREX_ALLOC_ERR if the window can't grow to hold the record
+grex_result_t grex_csv_row(const grex_csv_t* csv, grex_parser_t* p, grex_span_t* fields, size_t capacity, size_t* count);
+
+/// @brief Records read into columns: the field f of row r is spans[f * capacity + r]
+typedef struct grex_csv_batch {
+  grex_span_t* spans;
+  size_t fields;
+  size_t capacity;
+  size_t rows;
+} grex_csv_batch_t;
+
+/// @brief Allocates a batch
+/// @param batch
+/// @param fields the fields of each row
+/// @param capacity the rows of a full batch
+/// @return GREX_OK on success, GREX_ALLOC_ERR
+grex_result_t grex_csv_batch_init(grex_csv_batch_t* batch, size_t fields, size_t capacity);
+
+/// @brief Releases a batch
+/// @param batch
+void grex_csv_batch_destroy(grex_csv_batch_t* batch);
+
+/// @brief Reads up to capacity records like grex_csv_row, setting batch->rows. In streaming mode the window is only
+/// refilled before the first row, so a batch ends early at the end of the window and its spans stay valid until the next read.
+/// @param csv
+/// @param p
+/// @param batch
+/// @return GREX_OK if at least one row was read, GREX_EOF if there is no record left, or the error of grex_csv_row
+/// for the first row. A later row that fails ends the batch before it, and fails again on the next read.
+grex_result_t grex_csv_batch(const grex_csv_t* csv, grex_parser_t* p, grex_csv_batch_t* batch);
+
+/// @brief Unescapes a field into a null-terminated buffer, turning every doubled quote into one and truncating it to size - 1 characters
+/// @param span
+/// @param quote
+/// @param buf
+/// @param size
+/// @return the length of the whole unescaped field, which may be larger than what was written
+size_t grex_csv_unescape(const grex_span_t* span, int quote, char* buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,1153 @@
+/**
+MIT License
+
+Copyright (c) 2023 Guilherme Freitas Nemeth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// C++17 front-end for grex. Character sets and literal sequences are compiled by constexpr
+// code, and rules compose with >> and | into grammars that inline into the caller. Every rule
+// has a fast path over the bytes already in the parser window and falls back to the C
+// primitive for everything else (the end of the input, refilling a stream, reporting errors),
+// so a rule returns the same result and leaves the head at the same place as the primitive.
+
+#pragma once
+
+#include "grex.h"
+
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+
+/// @brief Number of bytes the scanning rules test inline before handing the rest of the run to the vectorized C scanner
+#ifndef GREX_HPP_INLINE_SCAN
+#define GREX_HPP_INLINE_SCAN 32
+#endif
+
+namespace grex {
+
+namespace detail {
+
+// The counters of the profile mode only see the C primitives, so every rule goes through them
+#if defined(GREX_PROFILE)
+inline constexpr bool fast = false;
+#else
+inline constexpr bool fast = true;
+#endif
+
+// Number of characters after the head that are in the window, so a rule of that many
+// characters can match without refilling, and without running into the last character,
+// where the head stays when it can't move further
+inline size_t room(const grex_parser_t* p) {
+  return p->parsing_offset < p->input_length ? p->input_length - 1 - p->parsing_offset : 0;
+}
+
+// Misses only have to go through the C primitive when they are reported
+inline bool tracking(const grex_parser_t* p) {
+  return p->error_callback || p->error_mode == GREX_ERRORS_DEFERRED;
+}
+
+// Keeps the input from the head on while a rule tries to match, so it can rewind on failure.
+// Only a stream discards input, so a parser over memory just saves the offset. The read
+// callback is cleared at the end of the stream, so the kind of parser is taken at the start.
+class checkpoint {
+public:
+  explicit checkpoint(grex_parser_t* p) : p_(p), offset_(p->parsing_offset), stream_(p->read_callback != nullptr) {
+    if (stream_) {
+      grex_parser_mark(p, &mark_);
+    }
+  }
+
+  ~checkpoint() {
+    if (stream_) {
+      grex_parser_release(p_, &mark_);
+    }
+  }
+
+  checkpoint(const checkpoint&) = delete;
+  checkpoint& operator=(const checkpoint&) = delete;
+
+  void rewind() {
+    if (stream_) {
+      grex_parser_rewind(p_, &mark_);
+    }
+    else {
+      p_->parsing_offset = offset_;
+    }
+  }
+
+private:
+  grex_parser_t* p_;
+  size_t offset_;
+  bool stream_;
+  grex_mark_t mark_;
+};
+
+// The captures of a match, as stream offsets so they survive a refill
+template <unsigned N>
+struct capture_offsets {
+  static constexpr unsigned size = N;
+  unsigned long long begin[N ? N : 1];
+  unsigned long long end[N ? N : 1];
+};
+
+// The slots a rule with Captures captures can write, saved so they go back with the head when it fails.
+// A rule that fails leaves the captures as they were, and one without captures saves nothing.
+template <unsigned Captures, class C>
+class saved_captures {
+public:
+  explicit saved_captures(const C& caps) {
+    for (unsigned i = 0; i < count; i++) {
+      begin_[i] = caps.begin[i];
+      end_[i] = caps.end[i];
+    }
+  }
+
+  void restore(C& caps) const {
+    for (unsigned i = 0; i < count; i++) {
+      caps.begin[i] = begin_[i];
+      caps.end[i] = end_[i];
+    }
+  }
+
+private:
+  static constexpr unsigned count = Captures < C::size ? Captures : C::size;
+  unsigned long long begin_[count ? count : 1];
+  unsigned long long end_[count ? count : 1];
+};
+
+// Two-Way factorization, the same as needle_factorize in grex.c
+struct factors {
+  size_t suffix = 0;
+  size_t period = 1;
+  int periodic = 1;
+};
+
+constexpr unsigned char tw(const char* x, size_t m, size_t i, bool reverse) {
+  return (unsigned char)x[reverse ? m - 1 - i : i];
+}
+
+constexpr size_t critical_factorization(const char* x, size_t m, bool reverse, size_t& period) {
+  if (m < 3) {
+    period = 1;
+    return m - 1;
+  }
+
+  size_t max_suffix = (size_t)-1, j = 0, k = 1, per = 1;
+  while (j + k < m) {
+    unsigned char a = tw(x, m, j + k, reverse);
+    unsigned char b = tw(x, m, max_suffix + k, reverse);
+    if (a < b) {
+      j += k;
+      k = 1;
+      per = j - max_suffix;
+    }
+    else if (a == b) {
+      if (k != per) {
+        k++;
+      }
+      else {
+        j += per;
+        k = 1;
+      }
+    }
+    else {
+      max_suffix = j++;
+      k = per = 1;
+    }
+  }
+  period = per;
+
+  size_t max_suffix_rev = (size_t)-1;
+  j = 0;
+  k = per = 1;
+  while (j + k < m) {
+    unsigned char a = tw(x, m, j + k, reverse);
+    unsigned char b = tw(x, m, max_suffix_rev + k, reverse);
+    if (b < a) {
+      j += k;
+      k = 1;
+      per = j - max_suffix_rev;
+    }
+    else if (a == b) {
+      if (k != per) {
+        k++;
+      }
+      else {
+        j += per;
+        k = 1;
+      }
+    }
+    else {
+      max_suffix_rev = j++;
+      k = per = 1;
+    }
+  }
+
+  if (max_suffix_rev + 1 < max_suffix + 1) {
+    return max_suffix + 1;
+  }
+  period = per;
+  return max_suffix_rev + 1;
+}
+
+constexpr factors factorize(const char* x, size_t m, bool reverse) {
+  factors f;
+  if (m == 0) {
+    return f;
+  }
+
+  f.suffix = critical_factorization(x, m, reverse, f.period);
+
+  size_t i = 0;
+  while (i < f.suffix && tw(x, m, i, reverse) == tw(x, m, i + f.period, reverse)) {
+    i++;
+  }
+
+  f.periodic = (i == f.suffix);
+  if (!f.periodic) {
+    f.period = (f.suffix > m - f.suffix ? f.suffix : m - f.suffix) + 1;
+  }
+  return f;
+}
+
+// Not constexpr, so a malformed spec stops the compilation of a constant charset
+inline void malformed_class_spec() {}
+
+} // namespace detail
+
+/// @brief A character class built at compile time, with the same bitmap and ranges as the
+/// grex_class_* functions build at run time
+class charset {
+public:
+  constexpr charset() : cls_{} {}
+
+  /// @brief The characters from first to last, inclusive
+  /// @param first
+  /// @param last
+  /// @return the class
+  static constexpr charset range(unsigned char first, unsigned char last) {
+    charset cs;
+    cs.add(first, last);
+    cs.update_ranges();
+    return cs;
+  }
+
+  /// @brief Every character of the string
+  /// @param chars
+  /// @return the class
+  static constexpr charset of(std::string_view chars) {
+    charset cs;
+    for (char c : chars) {
+      cs.add((unsigned char)c, (unsigned char)c);
+    }
+    cs.update_ranges();
+    return cs;
+  }
+
+  /// @brief Compiles a spec with the syntax of grex_class_parse, such as "a-zA-Z0-9_" or "^\n".
+  /// Only a '-' makes a range, so "ac" is the set of 'a' and 'c'. A malformed spec fails to compile in a constant expression, and gives an empty class at run time.
+  /// @param spec
+  /// @return the class
+  static constexpr charset parse(std::string_view spec) {
+    charset cs;
+    const size_t n = spec.size();
+    auto at = [&](size_t i) { return i < n ? (unsigned char)spec[i] : (unsigned char)0; };
+
+    size_t i = 0;
+    bool negate = false;
+    if (at(0) == '^') {
+      negate = true;
+      i++;
+    }
+
+    while (i < n) {
+      unsigned char first = at(i++);
+      if (first == '\\') {
+        if (i == n) {
+          detail::malformed_class_spec();
+          return charset();
+        }
+        first = at(i++);
+      }
+
+      unsigned char last = first;
+      if (at(i) == '-' && i + 1 < n) {
+        i++;
+        last = at(i++);
+        if (last == '\\') {
+          if (i == n) {
+            detail::malformed_class_spec();
+            return charset();
+          }
+          last = at(i++);
+        }
+        if (first > last) {
+          detail::malformed_class_spec();
+          return charset();
+        }
+      }
+
+      cs.add(first, last);
+    }
+
+    if (negate) {
+      cs = ~cs;
+    }
+    cs.update_ranges();
+    return cs;
+  }
+
+  /// @brief Checks if a character belongs to the class
+  /// @param c
+  /// @return true if the character is in the class
+  constexpr bool contains(unsigned char c) const {
+    return (cls_.bits[c >> 6] >> (c & 63)) & 1;
+  }
+
+  constexpr charset operator|(const charset& other) const {
+    charset cs;
+    for (int i = 0; i < 4; i++) {
+      cs.cls_.bits[i] = cls_.bits[i] | other.cls_.bits[i];
+    }
+    cs.update_ranges();
+    return cs;
+  }
+
+  constexpr charset operator&(const charset& other) const {
+    charset cs;
+    for (int i = 0; i < 4; i++) {
+      cs.cls_.bits[i] = cls_.bits[i] & other.cls_.bits[i];
+    }
+    cs.update_ranges();
+    return cs;
+  }
+
+  constexpr charset operator~() const {
+    charset cs;
+    for (int i = 0; i < 4; i++) {
+      cs.cls_.bits[i] = ~cls_.bits[i];
+    }
+    cs.update_ranges();
+    return cs;
+  }
+
+  /// @brief The compiled class, for the C primitives
+  /// @return the class
+  constexpr const grex_class_t& get() const {
+    return cls_;
+  }
+
+private:
+  constexpr void add(unsigned first, unsigned last) {
+    for (unsigned c = first; c <= last; c++) {
+      cls_.bits[c >> 6] |= 1ULL << (c & 63);
+    }
+  }
+
+  // Same runs as class_update_ranges in grex.c, a count above GREX_CLASS_MAX_RANGES leaves the scanners on the bitmap
+  constexpr void update_ranges() {
+    unsigned n = 0;
+    unsigned c = 0;
+    while (c < 256) {
+      if (!contains((unsigned char)c)) {
+        c++;
+        continue;
+      }
+      unsigned end = c;
+      while (end < 256 && contains((unsigned char)end)) {
+        end++;
+      }
+      if (n < GREX_CLASS_MAX_RANGES) {
+        cls_.ranges[n][0] = (unsigned char)c;
+        cls_.ranges[n][1] = (unsigned char)(end - 1);
+      }
+      n++;
+      c = end;
+    }
+    cls_.range_count = n;
+  }
+
+  grex_class_t cls_;
+};
+
+/// @brief Base of every rule. A rule has a match function with the result and head movement
+/// of the C primitive it stands for. Fixed width rules also have an unchecked scan, that a
+/// sequence of them runs after a single bounds check.
+template <class Derived>
+struct rule {};
+
+template <class T>
+inline constexpr bool is_rule_v = std::is_base_of_v<rule<T>, T>;
+
+/// @brief Matches a single character, like grex_char
+struct char_rule : rule<char_rule> {
+  static constexpr bool fixed = true;
+  static constexpr size_t width = 1;
+  static constexpr unsigned captures = 0;
+
+  char c;
+
+  constexpr explicit char_rule(char c) : c(c) {}
+
+  template <class C>
+  bool scan(const grex_parser_t* p, size_t& off, C&) const {
+    if (p->input[off] != c) {
+      return false;
+    }
+    off++;
+    return true;
+  }
+
+  template <class C>
+  grex_result_t match(grex_parser_t* p, C&) const {
+    if (detail::fast && detail::room(p) >= 1) {
+      if (p->input[p->parsing_offset] == c) {
+        p->parsing_offset++;
+        return GREX_OK;
+      }
+      if (!detail::tracking(p)) {
+        return GREX_NO_MATCH;
+      }
+    }
+    return grex_char(p, (unsigned char)c);
+  }
+};
+
+/// @brief Matches a single character of a class, like grex_char_class
+struct class_rule : rule<class_rule> {
+  static constexpr bool fixed = true;
+  static constexpr size_t width = 1;
+  static constexpr unsigned captures = 0;
+
+  charset cs;
+
+  constexpr explicit class_rule(const charset& cs) : cs(cs) {}
+
+  template <class C>
+  bool scan(const grex_parser_t* p, size_t& off, C&) const {
+    if (!cs.contains((unsigned char)p->input[off])) {
+      return false;
+    }
+    off++;
+    return true;
+  }
+
+  template <class C>
+  grex_result_t match(grex_parser_t* p, C&) const {
+    if (detail::fast && detail::room(p) >= 1) {
+      if (cs.contains((unsigned char)p->input[p->parsing_offset])) {
+        p->parsing_offset++;
+        return GREX_OK;
+      }
+      if (!detail::tracking(p)) {
+        return GREX_NO_MATCH;
+      }
+    }
+    return grex_char_class(p, &cs.get());
+  }
+};
+
+/// @brief A literal sequence with its Two-Way factorization computed at compile time.
+/// It matches like grex_sequence_needle.
+template <size_t N>
+struct literal : rule<literal<N>> {
+  static constexpr bool fixed = true;
+  static constexpr size_t width = N;
+  static constexpr unsigned captures = 0;
+
+  char data[N + 1];
+  detail::factors forward;
+  detail::factors reverse;
+
+  constexpr literal(const char (&seq)[N + 1]) : data{}, forward{}, reverse{} {
+    for (size_t i = 0; i < N; i++) {
+      data[i] = seq[i];
+    }
+    forward = detail::factorize(data, N, false);
+    reverse = detail::factorize(data, N, true);
+  }
+
+  /// @brief The precompiled needle for the C sequence scanners, pointing to this literal
+  /// @return the needle
+  grex_needle_t needle() const {
+    return grex_needle_t{ data, N, forward.suffix, forward.period, forward.periodic,
+                          reverse.suffix, reverse.period, reverse.periodic };
+  }
+
+  template <class C>
+  bool scan(const grex_parser_t* p, size_t& off, C&) const {
+    if (std::memcmp(&p->input[off], data, N)) {
+      return false;
+    }
+    off += N;
+    return true;
+  }
+
+  template <class C>
+  grex_result_t match(grex_parser_t* p, C&) const {
+    // A sequence moves the head past its last character, so it can end at the end of the window
+    if (detail::fast && p->parsing_offset < p->input_length && p->input_length - p->parsing_offset >= N) {
+      if (std::memcmp(&p->input[p->parsing_offset], data, N) == 0) {
+        p->parsing_offset += N;
+        return GREX_OK;
+      }
+      if (!detail::tracking(p)) {
+        return GREX_NO_MATCH;
+      }
+    }
+    grex_needle_t n = needle();
+    return grex_sequence_needle(p, &n);
+  }
+};
+
+/// @brief Moves the head past the next occurrence of a literal, like grex_until_needle
+template <size_t N>
+struct until_literal_rule : rule<until_literal_rule<N>> {
+  static constexpr bool fixed = false;
+  static constexpr size_t width = 0;
+  static constexpr unsigned captures = 0;
+
+  literal<N> lit;
+
+  constexpr explicit until_literal_rule(const literal<N>& lit) : lit(lit) {}
+
+  template <class C>
+  grex_result_t match(grex_parser_t* p, C&) const {
+    grex_needle_t n = lit.needle();
+    return grex_until_needle(p, &n);
+  }
+};
+
+/// @brief Moves the head to the next occurrence of a character, like grex_until
+struct until_char_rule : rule<until_char_rule> {
+  static constexpr bool fixed = false;
+  static constexpr size_t width = 0;
+  static constexpr unsigned captures = 0;
+
+  char c;
+
+  constexpr explicit until_char_rule(char c) : c(c) {}
+
+  template <class C>
+  grex_result_t match(grex_parser_t* p, C&) const {
+    size_t off = p->parsing_offset;
+    if (detail::fast && off < p->input_length) {
+      const void* hit = std::memchr(&p->input[off], c, p->input_length - off);
+      if (hit) {
+        size_t s = (const char*)hit - p->input;
+        if (s > off) {
+          p->parsing_offset = s;
+          return GREX_OK;
+        }
+        if (!detail::tracking(p)) {
+          return GREX_NO_MATCH;
+        }
+      }
+    }
+    return grex_until(p, (unsigned char)c);
+  }
+};
+
+namespace detail {
+
+enum class scan_kind {
+  while_class,
+  until_class,
+  whitespace,
+  whitespace_no_line,
+};
+
+} // namespace detail
+
+/// @brief Skips a run of characters in or out of a class, like grex_while_class, grex_until_class,
+/// grex_whitespace and grex_whitespace_no_line. Short runs are tested inline, longer runs are
+/// handed over to the vectorized scanner.
+template <detail::scan_kind Kind>
+struct scan_rule : rule<scan_rule<Kind>> {
+  static constexpr bool fixed = false;
+  static constexpr size_t width = 0;
+  static constexpr unsigned captures = 0;
+  static constexpr bool member = Kind != detail::scan_kind::until_class;
+
+  charset cs;
+
+  constexpr explicit scan_rule(const charset& cs) : cs(cs) {}
+
+  template <class C>
+  grex_result_t match(grex_parser_t* p, C&) const {
+    size_t off = p->parsing_offset;
+    size_t end = p->input_length;
+
+    if (detail::fast && off < end) {
+      const char* in = p->input;
+      size_t limit = end - off > GREX_HPP_INLINE_SCAN ? off + GREX_HPP_INLINE_SCAN : end;
+      size_t s = off;
+      while (s < limit && cs.contains((unsigned char)in[s]) == member) {
+        s++;
+      }
+
+      if (s < end) {
+        if (s == limit && cs.contains((unsigned char)in[s]) == member) {
+          // The run goes on, and the scanner is sure to make progress from here
+          p->parsing_offset = s;
+          return fallback(p);
+        }
+        if (s > off) {
+          p->parsing_offset = s;
+          return GREX_OK;
+        }
+        if (!detail::tracking(p)) {
+          return GREX_NO_MATCH;
+        }
+      }
+    }
+    return fallback(p);
+  }
+
+private:
+  grex_result_t fallback(grex_parser_t* p) const {
+    if constexpr (Kind == detail::scan_kind::while_class) {
+      return grex_while_class(p, &cs.get());
+    }
+    else if constexpr (Kind == detail::scan_kind::until_class) {
+      return grex_until_class(p, &cs.get());
+    }
+    else if constexpr (Kind == detail::scan_kind::whitespace) {
+      return grex_whitespace(p);
+    }
+    else {
+      return grex_whitespace_no_line(p);
+    }
+  }
+};
+
+/// @brief Matches an identifier, [A-Za-z_][A-Za-z0-9_]*, like grex_identifier_span
+struct identifier_rule : rule<identifier_rule> {
+  static constexpr bool fixed = false;
+  static constexpr size_t width = 0;
+  static constexpr unsigned captures = 0;
+
+  template <class C>
+  grex_result_t match(grex_parser_t* p, C&) const {
+    constexpr charset start = charset::parse("A-Za-z_");
+    constexpr charset rest = charset::parse("A-Za-z0-9_");
+
+    size_t off = p->parsing_offset;
+    if (detail::fast && off < p->input_length) {
+      if (start.contains((unsigned char)p->input[off])) {
+        size_t s = off + 1;
+        while (s < p->input_length && rest.contains((unsigned char)p->input[s])) {
+          s++;
+        }
+        if (s < p->input_length) {
+          p->parsing_offset = s;
+          return GREX_OK;
+        }
+      }
+      else if (!detail::tracking(p)) {
+        return GREX_NO_MATCH;
+      }
+    }
+
+    grex_span_t span;
+    return grex_identifier_span(p, &span);
+  }
+};
+
+/// @brief Matches A then B, rewinding if either fails. A sequence of fixed width rules is
+/// checked against the window once, then matched without further bounds checks.
+template <class A, class B>
+struct seq_rule : rule<seq_rule<A, B>> {
+  static constexpr bool fixed = A::fixed && B::fixed;
+  static constexpr size_t width = A::width + B::width;
+  static constexpr unsigned captures = A::captures > B::captures ? A::captures : B::captures;
+
+  A a;
+  B b;
+
+  constexpr seq_rule(const A& a, const B& b) : a(a), b(b) {}
+
+  template <class C>
+  bool scan(const grex_parser_t* p, size_t& off, C& caps) const {
+    return a.scan(p, off, caps) && b.scan(p, off, caps);
+  }
+
+  template <class C>
+  grex_result_t match(grex_parser_t* p, C& caps) const {
+    detail::saved_captures<captures, C> saved(caps);
+    if constexpr (fixed) {
+      if (detail::fast && detail::room(p) >= width) {
+        // The captures of a scan that fails part way are dropped
+        size_t off = p->parsing_offset;
+        if (scan(p, off, caps)) {
+          p->parsing_offset = off;
+          return GREX_OK;
+        }
+        saved.restore(caps);
+        if (!detail::tracking(p)) {
+          return GREX_NO_MATCH;
+        }
+      }
+    }
+
+    detail::checkpoint cp(p);
+    grex_result_t result = a.match(p, caps);
+    if (result == GREX_OK) {
+      result = b.match(p, caps);
+    }
+    if (result != GREX_OK) {
+      cp.rewind();
+      saved.restore(caps);
+    }
+    return result;
+  }
+};
+
+/// @brief Matches A, or B from the same place if A fails
+template <class A, class B>
+struct alt_rule : rule<alt_rule<A, B>> {
+  static constexpr bool fixed = false;
+  static constexpr size_t width = 0;
+  static constexpr unsigned captures = A::captures > B::captures ? A::captures : B::captures;
+
+  A a;
+  B b;
+
+  constexpr alt_rule(const A& a, const B& b) : a(a), b(b) {}
+
+  template <class C>
+  grex_result_t match(grex_parser_t* p, C& caps) const {
+    detail::checkpoint cp(p);
+    detail::saved_captures<captures, C> saved(caps);
+    if (a.match(p, caps) == GREX_OK) {
+      return GREX_OK;
+    }
+    cp.rewind();
+    saved.restore(caps);
+    grex_result_t result = b.match(p, caps);
+    if (result != GREX_OK) {
+      cp.rewind();
+      saved.restore(caps);
+    }
+    return result;
+  }
+};
+
+/// @brief Matches R if it can, and nothing otherwise
+template <class R>
+struct opt_rule : rule<opt_rule<R>> {
+  static constexpr bool fixed = false;
+  static constexpr size_t width = 0;
+  static constexpr unsigned captures = R::captures;
+
+  R r;
+
+  constexpr explicit opt_rule(const R& r) : r(r) {}
+
+  template <class C>
+  grex_result_t match(grex_parser_t* p, C& caps) const {
+    detail::checkpoint cp(p);
+    detail::saved_captures<captures, C> saved(caps);
+    if (r.match(p, caps) != GREX_OK) {
+      cp.rewind();
+      saved.restore(caps);
+    }
+    return GREX_OK;
+  }
+};
+
+/// @brief Matches R one or more times, until it fails or stops moving the head
+template <class R>
+struct many_rule : rule<many_rule<R>> {
+  static constexpr bool fixed = false;
+  static constexpr size_t width = 0;
+  static constexpr unsigned captures = R::captures;
+
+  R r;
+
+  constexpr explicit many_rule(const R& r) : r(r) {}
+
+  template <class C>
+  grex_result_t match(grex_parser_t* p, C& caps) const {
+    grex_result_t result = r.match(p, caps);
+    if (result != GREX_OK) {
+      return result;
+    }
+
+    for (;;) {
+      unsigned long long at = grex_parser_tell(p);
+      detail::checkpoint cp(p);
+      detail::saved_captures<captures, C> saved(caps);
+      if (r.match(p, caps) != GREX_OK) {
+        cp.rewind();
+        saved.restore(caps);
+        break;
+      }
+      if (grex_parser_tell(p) == at) {
+        break;
+      }
+    }
+    return GREX_OK;
+  }
+};
+
+/// @brief Records the input matched by R as capture I
+template <unsigned I, class R>
+struct cap_rule : rule<cap_rule<I, R>> {
+  static constexpr bool fixed = R::fixed;
+  static constexpr size_t width = R::width;
+  static constexpr unsigned captures = R::captures > I + 1 ? R::captures : I + 1;
+
+  R r;
+
+  constexpr explicit cap_rule(const R& r) : r(r) {}
+
+  template <class C>
+  bool scan(const grex_parser_t* p, size_t& off, C& caps) const {
+    size_t begin = off;
+    if (!r.scan(p, off, caps)) {
+      return false;
+    }
+    if constexpr (I < C::size) {
+      caps.begin[I] = p->stream_offset + begin;
+      caps.end[I] = p->stream_offset + off;
+    }
+    return true;
+  }
+
+  template <class C>
+  grex_result_t match(grex_parser_t* p, C& caps) const {
+    unsigned long long begin = grex_parser_tell(p);
+    grex_result_t result = r.match(p, caps);
+    if constexpr (I < C::size) {
+      if (result == GREX_OK) {
+        caps.begin[I] = begin;
+        caps.end[I] = grex_parser_tell(p);
+      }
+    }
+    return result;
+  }
+};
+
+/// @brief A single character
+/// @param c
+/// @return the rule
+constexpr char_rule ch(char c) {
+  return char_rule(c);
+}
+
+/// @brief A single character of the class
+/// @param cs
+/// @return the rule
+constexpr class_rule one(const charset& cs) {
+  return class_rule(cs);
+}
+
+/// @brief A literal sequence, factorized at compile time
+/// @param seq
+/// @return the rule
+template <size_t M>
+constexpr literal<M - 1> lit(const char (&seq)[M]) {
+  return literal<M - 1>(seq);
+}
+
+/// @brief One or more characters of the class
+/// @param cs
+/// @return the rule
+constexpr scan_rule<detail::scan_kind::while_class> many(const charset& cs) {
+  return scan_rule<detail::scan_kind::while_class>(cs);
+}
+
+/// @brief One or more characters out of the class
+/// @param cs
+/// @return the rule
+constexpr scan_rule<detail::scan_kind::until_class> until(const charset& cs) {
+  return scan_rule<detail::scan_kind::until_class>(cs);
+}
+
+/// @brief Up to the next occurrence of the character, which must not be at the head
+/// @param c
+/// @return the rule
+constexpr until_char_rule until(char c) {
+  return until_char_rule(c);
+}
+
+/// @brief Past the next occurrence of the literal
+/// @param l
+/// @return the rule
+template <size_t N>
+constexpr until_literal_rule<N> until(const literal<N>& l) {
+  return until_literal_rule<N>(l);
+}
+
+/// @brief R, or nothing
+/// @param r
+/// @return the rule
+template <class R, class = std::enable_if_t<is_rule_v<R>>>
+constexpr opt_rule<R> opt(const R& r) {
+  return opt_rule<R>(r);
+}
+
+/// @brief R, one or more times
+/// @param r
+/// @return the rule
+template <class R, class = std::enable_if_t<is_rule_v<R>>>
+constexpr many_rule<R> many(const R& r) {
+  return many_rule<R>(r);
+}
+
+/// @brief Captures the input matched by R into the slot I of parser::match
+/// @param r
+/// @return the rule
+template <unsigned I, class R, class = std::enable_if_t<is_rule_v<R>>>
+constexpr cap_rule<I, R> cap(const R& r) {
+  return cap_rule<I, R>(r);
+}
+
+template <class A, class B, class = std::enable_if_t<is_rule_v<A> && is_rule_v<B>>>
+constexpr seq_rule<A, B> operator>>(const A& a, const B& b) {
+  return seq_rule<A, B>(a, b);
+}
+
+template <class A, class B, class = std::enable_if_t<is_rule_v<A> && is_rule_v<B>>>
+constexpr alt_rule<A, B> operator|(const A& a, const B& b) {
+  return alt_rule<A, B>(a, b);
+}
+
+/// @brief One or more of " \t\n\r\f"
+inline constexpr scan_rule<detail::scan_kind::whitespace> ws{ charset::of(" \t\n\r\f") };
+
+/// @brief One or more of " \t\f"
+inline constexpr scan_rule<detail::scan_kind::whitespace_no_line> ws_no_line{ charset::of(" \t\f") };
+
+/// @brief [A-Za-z_][A-Za-z0-9_]*
+inline constexpr identifier_rule identifier{};
+
+/// @brief Owns a grex_parser_t and matches rules and numbers against it
+class parser {
+public:
+  parser() : p_{} {
+    grex_parser_init(&p_, "", 0);
+  }
+
+  /// @brief Parses a string, which must outlive the parser
+  /// @param input
+  explicit parser(std::string_view input) : p_{} {
+    grex_parser_init(&p_, input.data(), input.size());
+  }
+
+  ~parser() {
+    grex_parser_destroy(&p_);
+  }
+
+  parser(const parser&) = delete;
+  parser& operator=(const parser&) = delete;
+
+  /// @brief Parses a file, see grex_parser_open_file
+  /// @param path
+  /// @return GREX_OK on success, GREX_IO_ERR or GREX_ALLOC_ERR otherwise
+  grex_result_t open_file(const char* path) {
+    return grex_parser_open_file(&p_, path);
+  }
+
+  /// @brief Parses the input of a read callback, see grex_parser_init_stream
+  /// @param cb
+  /// @param arg
+  /// @param window_size
+  /// @return GREX_OK on success, GREX_ALLOC_ERR if the window can't be allocated
+  grex_result_t stream(grex_read_callback_t cb, void* arg, size_t window_size) {
+    return grex_parser_init_stream(&p_, cb, arg, window_size);
+  }
+
+  /// @brief The C parser, to call the primitives that have no rule
+  /// @return the parser
+  grex_parser_t* get() {
+    return &p_;
+  }
+
+  /// @brief The offset of the head from the start of the input
+  /// @return the offset
+  unsigned long long tell() const {
+    return grex_parser_tell(&p_);
+  }
+
+  /// @brief Matches a rule at the head
+  /// @param r
+  /// @return GREX_OK if it matched, the result of the primitive that failed otherwise
+  template <class R, class = std::enable_if_t<is_rule_v<R>>>
+  grex_result_t match(const R& r) {
+    detail::capture_offsets<0> none;
+    return r.match(&p_, none);
+  }
+
+  /// @brief Matches a rule at the head and fills the slots with the input of its captures.
+  /// The views are valid until the parser reads more input, and slots that no capture matched are empty.
+  /// @param r
+  /// @param slots
+  /// @return GREX_OK if it matched, the result of the primitive that failed otherwise
+  template <class R, size_t N, class = std::enable_if_t<is_rule_v<R>>>
+  grex_result_t match(const R& r, std::array<std::string_view, N>& slots) {
+    static_assert(R::captures <= N, "the rule captures more slots than given");
+
+    detail::capture_offsets<(unsigned)N> caps;
+    for (size_t i = 0; i < N; i++) {
+      caps.begin[i] = caps.end[i] = ~0ULL;
+    }
+
+    detail::checkpoint cp(&p_);
+    grex_result_t result = r.match(&p_, caps);
+    if (result == GREX_OK) {
+      for (size_t i = 0; i < N; i++) {
+        slots[i] = caps.begin[i] == ~0ULL ? std::string_view() : view(caps.begin[i], caps.end[i]);
+      }
+    }
+    return result;
+  }
+
+  /// @brief Matches a rule at the head and returns the input it matched, valid until the parser reads more input
+  /// @param r
+  /// @param out
+  /// @return GREX_OK if it matched, the result of the primitive that failed otherwise
+  template <class R, class = std::enable_if_t<is_rule_v<R>>>
+  grex_result_t capture(const R& r, std::string_view& out) {
+    std::array<std::string_view, 1> slot;
+    grex_result_t result = match(cap<0>(r), slot);
+    if (result == GREX_OK) {
+      out = slot[0];
+    }
+    return result;
+  }
+
+  /// @brief Parses a number at the head, like grex_integer, grex_uinteger and grex_float_ex.
+  /// A plain decimal number in the window is converted with std::from_chars, anything else goes
+  /// through the C parser. Integers out of the range of T are clamped, and give GREX_RANGE_ERR.
+  /// @param value
+  /// @param base the base of integers, 0 to detect it from the prefix like strtoll
+  /// @return GREX_OK on success, GREX_RANGE_ERR if the value was clamped, GREX_NO_MATCH or GREX_EOF otherwise
+  template <class T>
+  grex_result_t number(T& value, int base = 10) {
+    static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "numbers are integers or floating point");
+
+    if constexpr (std::is_integral_v<T>) {
+      return integer(value, base);
+    }
+    else {
+      return floating(value);
+    }
+  }
+
+private:
+  std::string_view view(unsigned long long begin, unsigned long long end) const {
+    return std::string_view(&p_.input[begin - p_.stream_offset], (size_t)(end - begin));
+  }
+
+  // Whether the number at the head starts with a digit, after a minus sign if it may have one,
+  // so it has no leading whitespace, plus sign or letters for the C parser to handle
+  bool plain_number(bool sign) const {
+    size_t off = p_.parsing_offset;
+    size_t n = p_.input_length;
+    if (off < n && sign && p_.input[off] == '-') {
+      off++;
+    }
+    return off < n && (unsigned)(p_.input[off] - '0') < 10;
+  }
+
+  template <class T>
+  grex_result_t integer(T& value, int base) {
+    if (detail::fast && base == 10 && plain_number(std::is_signed_v<T>)) {
+      const char* s = &p_.input[p_.parsing_offset];
+      T v;
+      std::from_chars_result r = std::from_chars(s, p_.input_end, v, 10);
+
+      // The C parser decides whether a '.' makes the integer a float, and reads more of a stream
+      if (r.ec == std::errc() && r.ptr < p_.input_end && *r.ptr != '.') {
+        value = v;
+        p_.parsing_offset = r.ptr - p_.input;
+        return GREX_OK;
+      }
+    }
+
+    if constexpr (std::is_signed_v<T>) {
+      long long v;
+      grex_result_t result = grex_integer(&p_, base, &v);
+      if (result == GREX_OK || result == GREX_RANGE_ERR) {
+        if (v < (long long)std::numeric_limits<T>::min()) {
+          v = std::numeric_limits<T>::min();
+          result = GREX_RANGE_ERR;
+        }
+        else if (v > (long long)std::numeric_limits<T>::max()) {
+          v = std::numeric_limits<T>::max();
+          result = GREX_RANGE_ERR;
+        }
+        value = (T)v;
+      }
+      return result;
+    }
+    else {
+      unsigned long long v;
+      grex_result_t result = grex_uinteger(&p_, base, &v);
+      if (result == GREX_OK || result == GREX_RANGE_ERR) {
+        if (v > (unsigned long long)std::numeric_limits<T>::max()) {
+          v = std::numeric_limits<T>::max();
+          result = GREX_RANGE_ERR;
+        }
+        value = (T)v;
+      }
+      return result;
+    }
+  }
+
+  template <class T>
+  grex_result_t floating(T& value) {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    // Floats are rounded from the double, so they get the same value as through grex_float
+    if (detail::fast && plain_number(true)) {
+      const char* s = &p_.input[p_.parsing_offset];
+      double v;
+      std::from_chars_result r = std::from_chars(s, p_.input_end, v, std::chars_format::general);
+
+      // A digit has to end the number, and the character after it can't continue a number the C parser reads further
+      if (r.ec == std::errc() && r.ptr < p_.input_end && (unsigned)(r.ptr[-1] - '0') < 10) {
+        constexpr charset number_chars = charset::parse("0-9A-Za-z_.+\\-");
+        if (!number_chars.contains((unsigned char)*r.ptr)) {
+          value = (T)v;
+          p_.parsing_offset = r.ptr - p_.input;
+          return GREX_OK;
+        }
+      }
+    }
+#endif
+
+    double v;
+    grex_result_t result = grex_float(&p_, &v);
+    if (result == GREX_OK || result == GREX_RANGE_ERR) {
+      value = (T)v;
+    }
+    return result;
+  }
+
+  grex_parser_t p_;
+};
+
+} // namespace grex
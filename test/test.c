@@ -2,17 +2,6 @@
 #include "../grex.c"
 #include <stdio.h>
 
-static char input[1024];
-
-static int read_file(const char* filename) {
-  FILE* fh = fopen(filename, "rb");
-  if (!fh) return 0;
-
-  fread(input, 1, sizeof(input), fh);
-  fclose(fh);
-  return 1;
-}
-
 static void parse_properties(grex_parser_t* p) {
   static char key_buf[1024];
   static char value_buf[1024];
@@ -58,13 +47,35 @@ static void parse_properties(grex_parser_t* p) {
   }
 }
 
-int main(int argc, const char* argv[]) {
-  if (!read_file("test.ini")) {
-    return 1;
+// Counts the name,value records of a chunk, where the value is an integer or a quoted string
+static grex_result_t parse_records(grex_parser_t* p, grex_chunk_t* chunk, void* arg) {
+  char buf[64];
+  long long value;
+  size_t count = 0;
+  (void)arg;
+
+  while (grex_identifier(p, buf, sizeof(buf)) == GREX_OK) {
+    if (grex_char(p, ',')) return GREX_NO_MATCH;
+    if (grex_integer(p, 10, &value) && grex_string(p, buf, sizeof(buf))) return GREX_NO_MATCH;
+    if (grex_char(p, '\n')) return GREX_NO_MATCH;
+    count++;
   }
 
+  chunk->data = (void*)count;
+  return GREX_OK;
+}
+
+static void count_records(const grex_chunk_t* chunk, void* arg) {
+  size_t* totals = arg;
+  totals[0] += (size_t)chunk->data;
+  totals[1]++;
+}
+
+int main(int argc, const char* argv[]) {
   grex_parser_t p = {0};
-  grex_parser_init(&p, input, strlen(input));
+  if (grex_parser_open_file(&p, "test.ini")) {
+    return 1;
+  }
 
   grex_whitespace(&p);
   if (grex_sequence(&p, "[first_section]")) return 1;
@@ -101,7 +112,334 @@ int main(int argc, const char* argv[]) {
   printf("%d\n", grex_capture_until(&p, '\n', capbuf, sizeof(capbuf)));
   printf("captured 5: %s\n", capbuf);
 
+  grex_class_t digits;
+  grex_class_clear(&digits);
+  grex_class_add_range(&digits, '0', '9');
+
+  grex_parser_reset(&p);
+  grex_until_class(&p, &digits);
+  grex_capture_until(&p, '\n', capbuf, sizeof(capbuf));
+  printf("captured 6: %s\n", capbuf);
+
+  grex_parser_reset(&p);
+  grex_until_sequence(&p, "hex = ");
+  printf("range: %d", grex_range(&p, "0-9"));
+  printf(" %d", grex_range(&p, "^0-9"));
+  printf(" %d", grex_range_while(&p, "0-9a-fA-F"));
+  printf(" %d\n", grex_char(&p, '\n'));
+
+  // Two characters without a '-' are a set, not a range
+  grex_class_t pair;
+  grex_class_parse(&pair, "ac");
+  printf("class: %d%d%d", grex_class_contains(&pair, 'a'), grex_class_contains(&pair, 'b'), grex_class_contains(&pair, 'c'));
+  grex_class_parse(&pair, "_a");
+  printf(" %d\n", grex_class_contains(&pair, '`'));
+
+  static const char* const sections[] = { "[first", "[second_section]", "[first_section]" };
+  grex_keywords_t keywords;
+  unsigned keyword;
+  if (grex_keywords_init(&keywords, sections, 3, 0)) return 1;
+  grex_parser_reset(&p);
+  if (!grex_keyword(&p, &keywords, &keyword)) {
+    printf("keyword: %u\n", keyword);
+  }
+  grex_keywords_destroy(&keywords);
+
+  static const char* const markers[] = { "someprop", "[second", "# hi" };
+  grex_sequences_t sequences;
+  unsigned first, second, last;
+  if (grex_sequences_init(&sequences, markers, 3)) return 1;
+  grex_parser_reset(&p);
+  if (!grex_until_any_sequence(&p, &sequences, &first) && !grex_until_any_sequence(&p, &sequences, &second)) {
+    grex_parser_end(&p);
+    if (!grex_until_any_sequence_reverse(&p, &sequences, &last)) {
+      printf("any sequence: %u %u %u\n", first, second, last);
+    }
+  }
+  grex_sequences_destroy(&sequences);
+
+  grex_span_t span;
+  grex_parser_reset(&p);
+  grex_until_sequence(&p, "str = ");
+  grex_string_span(&p, &span);
+  printf("span: %.*s\n", (int)span.len, span.ptr);
+
+  // Unescaped in the same pass, the string without escapes is not copied
+  grex_span_t decoded;
+  grex_parser_reset(&p);
+  grex_until_sequence(&p, "somevalue = ");
+  if (!grex_string_decode(&p, capbuf, sizeof(capbuf), &decoded)) {
+    printf("decode: %.*s (%s),", (int)decoded.len, decoded.ptr, decoded.ptr == capbuf ? "copied" : "zero-copy");
+  }
+  grex_parser_reset(&p);
+  grex_until_sequence(&p, "str = ");
+  if (!grex_string_decode(&p, capbuf, sizeof(capbuf), &decoded)) {
+    printf(" %.*s (%s)\n", (int)decoded.len, decoded.ptr, decoded.ptr == capbuf ? "copied" : "zero-copy");
+  }
+
+  // An escape stops at the closing delimiter even when the delimiter is a digit, same as unescaping the span
+  grex_parser_t digit = {0};
+  char unescaped[8];
+  grex_parser_init(&digit, "0\\120 0", 7);
+  if (!grex_delimited_string_decode(&digit, '0', capbuf, sizeof(capbuf), &decoded)) {
+    grex_parser_reset(&digit);
+    grex_delimited_string(&digit, '0', unescaped, sizeof(unescaped));
+    printf("decode: digit delimiter %zu %d\n", decoded.len, decoded.len == strlen(unescaped) && !memcmp(decoded.ptr, unescaped, decoded.len));
+  }
+  grex_parser_destroy(&digit);
+
+  // Exact-length copies into an arena, freed all at once at the end of the record
+  grex_arena_t arena;
+  grex_span_t key, value;
+  grex_arena_init(&arena, 64);
+  grex_parser_set_arena(&p, &arena);
+  grex_parser_reset(&p);
+  grex_until_sequence(&p, "# hi comment\n\n");
+  if (!grex_identifier_alloc(&p, &key) && !grex_capture_until_alloc(&p, '\'', &value) && !grex_string_alloc(&p, &decoded)) {
+    printf("arena: %s%s%s\n", key.ptr, value.ptr, decoded.ptr);
+  }
+  grex_arena_reset(&arena);
+  grex_parser_set_arena(&p, NULL);
+  grex_arena_destroy(&arena);
+
+  // Every word of the file interned, the repeated ones get the id of their first occurrence
+  grex_intern_t names;
+  grex_class_t letters;
+  unsigned id, words = 0;
+  grex_class_clear(&letters);
+  grex_class_add_range(&letters, 'a', 'z');
+  grex_class_add_range(&letters, 'A', 'Z');
+  if (grex_intern_init(&names, 32)) return 1;
+  grex_parser_set_intern(&p, &names);
+  grex_parser_reset(&p);
+  while (grex_until_class(&p, &letters) == GREX_OK && grex_identifier_intern(&p, &id, &span) == GREX_OK) {
+    words++;
+  }
+  grex_intern_find(&names, "comment", 7, &id);
+  printf("intern: %u words, %zu names, %s = %u\n", words, names.count, grex_intern_name(&names, id)->ptr, id);
+  grex_parser_set_intern(&p, NULL);
+  grex_intern_destroy(&names);
+
+  // The key = value grammar again, as a compiled pattern
+  grex_pattern_t pattern;
+  grex_span_t kv[2];
+  grex_pattern_init(&pattern);
+  grex_pattern_capture_begin(&pattern);
+  grex_pattern_identifier(&pattern);
+  grex_pattern_capture_end(&pattern);
+  grex_pattern_whitespace_no_line(&pattern);
+  grex_pattern_optional(&pattern);
+  grex_pattern_char(&pattern, '=');
+  grex_pattern_whitespace_no_line(&pattern);
+  grex_pattern_optional(&pattern);
+  grex_pattern_capture_begin(&pattern);
+  grex_pattern_until(&pattern, '\n');
+  grex_pattern_capture_end(&pattern);
+  grex_pattern_whitespace(&pattern);
+  if (grex_pattern_compile(&pattern)) return 1;
+
+  grex_parser_reset(&p);
+  grex_sequence(&p, "[first_section]");
+  grex_whitespace(&p);
+  while (grex_pattern_match(&p, &pattern, kv, 2) == GREX_OK) {
+    printf("pattern: %.*s = %.*s\n", (int)kv[0].len, kv[0].ptr, (int)kv[1].len, kv[1].ptr);
+  }
+  grex_pattern_destroy(&pattern);
+
+  // An optional string that isn't there leaves its capture empty
+  grex_parser_t assignment = {0};
+  grex_pattern_init(&pattern);
+  grex_pattern_capture_begin(&pattern);
+  grex_pattern_identifier(&pattern);
+  grex_pattern_capture_end(&pattern);
+  grex_pattern_char(&pattern, '=');
+  grex_pattern_capture_begin(&pattern);
+  grex_pattern_string(&pattern);
+  grex_pattern_optional(&pattern);
+  grex_pattern_capture_end(&pattern);
+  grex_parser_init(&assignment, "key=", 4);
+  grex_result_t uncompiled = grex_pattern_match(&assignment, &pattern, kv, 2);
+  if (grex_pattern_compile(&pattern)) return 1;
+  grex_pattern_until_sequence(&pattern, "never");
+  if (grex_pattern_match(&assignment, &pattern, kv, 2) == GREX_OK) {
+    printf("optional capture: %.*s = '%.*s' %u, uncompiled %d, appended after compiling %d\n", (int)kv[0].len, kv[0].ptr,
+           (int)kv[1].len, kv[1].ptr, kv[1].flags, uncompiled, grex_pattern_compile(&pattern));
+  }
+  grex_pattern_destroy(&pattern);
+
+  unsigned long long line, column;
+  grex_parser_reset(&p);
+  grex_until_sequence(&p, "someprop");
+  grex_parser_position(&p, grex_parser_tell(&p), &line, &column);
+  printf("position: %llu:%llu\n", line, column);
+
+  // The same scans again, jumping between the structural characters of the index
+  unsigned equals = 0;
+  if (grex_parser_set_structural(&p, GREX_STRUCTURAL_DEFAULT, 0)) return 1;
+  grex_parser_reset(&p);
+  grex_until_sequence(&p, "str = ");
+  grex_string_span(&p, &span);
+  grex_parser_reset(&p);
+  while (grex_until(&p, '=') == GREX_OK && grex_char(&p, '=') == GREX_OK) {
+    equals++;
+  }
+  printf("structural: %.*s %u\n", (int)span.len, span.ptr, equals);
+
+  grex_parser_destroy(&p);
+
+  // Same file again, streamed through a window smaller than the input
+  FILE* fh = fopen("test.ini", "rb");
+  if (!fh) return 1;
+  if (grex_parser_init_stream(&p, grex_read_stdio, fh, 64)) return 1;
+
+  grex_whitespace(&p);
+  if (grex_sequence(&p, "[first_section]")) return 1;
+  printf("stream: [first_section]\n");
+  parse_properties(&p);
+
+  if (grex_sequence(&p, "[second_section]")) return 1;
+  printf("stream: [second_section]\n");
+  parse_properties(&p);
+
   grex_parser_destroy(&p);
+  fclose(fh);
+
+  // Deferred errors keep only the furthest failure, the value of "port" here
+  static const char bad[] = "[first_section]\nkey = value\nport = @\n";
+  grex_parser_init(&p, bad, sizeof(bad) - 1);
+  grex_parser_set_error_mode(&p, GREX_ERRORS_DEFERRED);
+  grex_sequence(&p, "[first_section]");
+  parse_properties(&p);
+  grex_parser_error(&p, capbuf, sizeof(capbuf));
+  printf("error: %s\n", capbuf);
+  grex_parser_destroy(&p);
+
+  // Trying a rule again at the same offset is a lookup in the packrat cache
+  grex_memo_t memo;
+  grex_mark_t mark;
+  grex_result_t memo_result;
+  long long number;
+  if (grex_memo_init(&memo, 64)) return 1;
+  grex_parser_init(&p, "12345 rest", 10);
+  grex_parser_mark(&p, &mark);
+  memo_result = grex_integer(&p, 10, &number);
+  grex_memo_store(&p, &memo, 1, &mark, memo_result);
+  grex_parser_rewind(&p, &mark);
+  if (grex_memo_lookup(&p, &memo, 1, &memo_result)) {
+    printf("memo: %d at %llu\n", memo_result, grex_parser_tell(&p));
+  }
+  grex_parser_release(&p, &mark);
+  grex_memo_destroy(&memo);
+
+  // The float syntax narrowed by flags, and NaN payloads decoded like strtod whatever their length
+  static const char* const floats[] = { "1.5", "0x1.8p3", "-inf", "nan(123)" };
+  static const unsigned float_flags[] = { 0, GREX_FLOAT_NO_HEX, GREX_FLOAT_NO_INF_NAN, GREX_FLOAT_STRICT };
+  grex_parser_t number_parser = {0};
+  double parsed, expected;
+  printf("float flags:");
+  for (int f = 0; f < 4; f++) {
+    printf(" ");
+    for (int i = 0; i < 4; i++) {
+      grex_parser_init(&number_parser, floats[i], strlen(floats[i]));
+      printf("%d", grex_float_ex(&number_parser, &parsed, float_flags[f]));
+    }
+  }
+  static char payload[128] = "nan(";
+  memset(payload + 4, '0', 100);
+  strcpy(payload + 104, "7)");
+  grex_parser_init(&number_parser, payload, strlen(payload));
+  expected = strtod(payload, NULL);
+  if (!grex_float_ex(&number_parser, &parsed, 0)) {
+    printf(", long payload %s strtod\n", memcmp(&parsed, &expected, sizeof(double)) ? "differs from" : "same as");
+  }
+
+  // Records split into chunks at the newlines outside of quotes, parsed on two threads
+  static const char records[] = "a,1\nb,\"x\ny\"\nc,3\nd,4\ne,\"5\n\"\nf,6\n";
+  grex_parallel_t parallel;
+  size_t totals[2] = { 0, 0 };
+  grex_parallel_init(&parallel, parse_records, count_records, totals);
+  parallel.threads = 2;
+  parallel.chunks = 4;
+  if (grex_parse_parallel(&parallel, records, sizeof(records) - 1) == GREX_OK) {
+    printf("parallel: %zu records in %zu chunks\n", totals[0], totals[1]);
+  }
+
+  // Every key of the file in a flat index, the values are converted when they are read
+  grex_config_t config;
+  long long port;
+  double ratio, huge, limit;
+  int enabled;
+  size_t reloaded;
+  static const char overrides[] = "[first_section]\nport = 9090 ; from the override\nenabled = Yes\nhuge = 1e999\nlimit = -inf\n";
+  grex_config_init(&config);
+  if (grex_config_load_file(&config, "test.ini") || grex_config_load_string(&config, overrides, sizeof(overrides) - 1)) return 1;
+  if (!grex_config_integer(&config, "first_section.port", &port) && !grex_config_float(&config, "first_section.decimal", &ratio) &&
+      !grex_config_bool(&config, "first_section.enabled", &enabled) &&
+      !grex_config_string(&config, "second_section.somevalue", capbuf, sizeof(capbuf))) {
+    printf("config: %zu keys, port = %lld, decimal = %g, enabled = %d, somevalue = %s,", config.count, port, ratio, enabled, capbuf);
+    grex_result_t huge_result = grex_config_float(&config, "first_section.huge", &huge);
+    grex_result_t limit_result = grex_config_float(&config, "first_section.limit", &limit);
+    printf(" huge %d %g, limit %d %g,", huge_result, huge, limit_result, limit);
+    grex_result_t reload_result = grex_config_reload(&config, &reloaded);
+    printf(" reload %d %zu\n", reload_result, reloaded);
+  }
+  grex_config_destroy(&config);
+
+  // Delimited records with two of their columns projected, quoted fields keep their doubled quotes until unescaped
+  static const char table[] = "id,name,score,note\r\n1,\"Smith, J\",90,\"said \"\"hi\"\"\"\r\n2,Lee,75,\"two\nlines\"\r\n3,Kim,88";
+  static const size_t projection[] = { 3, 1 };
+  grex_csv_t csv;
+  grex_span_t fields[2];
+  size_t columns;
+  grex_csv_init(&csv, ',', '"');
+  if (grex_csv_select(&csv, projection, 2)) return 1;
+  grex_parser_init(&p, table, sizeof(table) - 1);
+  printf("csv:");
+  while (grex_csv_row(&csv, &p, fields, 2, &columns) == GREX_OK) {
+    grex_csv_unescape(&fields[0], '"', capbuf, sizeof(capbuf));
+    printf(" %.*s [%s] %zu;", (int)fields[1].len, fields[1].ptr, capbuf, columns);
+  }
+
+  // The same records into columns, only the score is read
+  static const size_t scores[] = { 2 };
+  grex_csv_batch_t batch;
+  grex_parser_t score = {0};
+  long long total = 0;
+  if (grex_csv_select(&csv, scores, 1) || grex_csv_batch_init(&batch, 1, 8)) return 1;
+  grex_parser_init(&p, table, sizeof(table) - 1);
+  grex_csv_row(&csv, &p, fields, 1, NULL);
+  if (!grex_csv_batch(&csv, &p, &batch)) {
+    for (size_t r = 0; r < batch.rows; r++) {
+      grex_parser_init(&score, batch.spans[r].ptr, batch.spans[r].len);
+      grex_integer(&score, 10, &number);
+      total += number;
+    }
+    printf(" %zu rows, total score %lld,", batch.rows, total);
+  }
+  static const size_t past_end[] = { (size_t)-1 };
+  printf(" past the last column %d\n", grex_csv_select(&csv, past_end, 1));
+  grex_csv_batch_destroy(&batch);
+  grex_csv_destroy(&csv);
+
+#if defined(GREX_PROFILE)
+  // Counters per primitive, the second pass over the same property is rescanned
+  grex_parser_init(&p, "key = 42\n", 9);
+  grex_profile_set_sample(&p, 1);
+  for (int pass = 0; pass < 2; pass++) {
+    grex_parser_reset(&p);
+    grex_identifier(&p, capbuf, sizeof(capbuf));
+    grex_whitespace(&p);
+    grex_char(&p, '=');
+    grex_whitespace(&p);
+    grex_integer(&p, 10, &number);
+  }
+  grex_string(&p, capbuf, sizeof(capbuf));
+
+  const grex_profile_counter_t* ident = &p.profile.counters[GREX_PROFILE_IDENTIFIER];
+  const grex_profile_counter_t* string = &p.profile.counters[GREX_PROFILE_STRING];
+  printf("profile: %s %llu calls %llu bytes %llu rescanned, %s %llu no match\n", grex_profile_name(GREX_PROFILE_IDENTIFIER),
+         ident->calls, ident->bytes, ident->rescanned, grex_profile_name(GREX_PROFILE_STRING), string->no_match);
+#endif
 
   return 0;
 }
\ No newline at end of file
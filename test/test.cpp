@@ -0,0 +1,107 @@
+// Build with grex.c compiled as C: cc -c ../grex.c && c++ -std=c++17 test.cpp grex.o
+#include "../grex.hpp"
+#include <stdio.h>
+
+// Classes and needles are built by the compiler
+constexpr grex::charset digits = grex::charset::parse("0-9");
+constexpr grex::charset hex = grex::charset::parse("0-9a-fA-F");
+static_assert(digits.contains('7') && !digits.contains('a') && digits.get().range_count == 1);
+static_assert(hex.get().range_count == 3 && (~hex).contains('g') && !(~hex).contains('F'));
+static_assert(grex::charset::parse("ac").contains('c') && !grex::charset::parse("ac").contains('b') && !grex::charset::parse("_a").contains('`'));
+
+constexpr auto comment = grex::ch('#') >> grex::until('\n');
+constexpr auto section = grex::ch('[') >> grex::cap<0>(grex::identifier) >> grex::ch(']');
+constexpr auto assign = grex::cap<0>(grex::identifier) >> grex::ws_no_line >> grex::ch('=') >> grex::ws_no_line;
+constexpr auto marker = grex::lit("# hi");
+static_assert(decltype(marker)::width == 4 && marker.forward.period == 4);
+
+// A fixed width sequence takes a single bounds check
+constexpr auto date = grex::cap<0>(grex::one(digits) >> grex::one(digits) >> grex::one(digits) >> grex::one(digits)) >>
+                      grex::ch('-') >> grex::cap<1>(grex::one(digits) >> grex::one(digits));
+static_assert(decltype(date)::fixed && decltype(date)::width == 7 && decltype(date)::captures == 2);
+
+static void parse_properties(grex::parser& p) {
+  std::array<std::string_view, 1> key;
+  std::string_view value;
+  long long value_num;
+  double value_double;
+  grex_span_t span;
+
+  while (p.match(grex::ws) != GREX_EOF) {
+    if (p.match(comment) == GREX_OK) {
+      continue;
+    }
+    if (p.match(assign, key)) break;
+
+    if (!p.number(value_num, 0)) {
+      printf("integer prop: %.*s = %lld\n", (int)key[0].size(), key[0].data(), value_num);
+      continue;
+    }
+
+    if (!p.number(value_double)) {
+      printf("float prop: %.*s = %f\n", (int)key[0].size(), key[0].data(), value_double);
+      continue;
+    }
+
+    if (!p.capture(grex::identifier, value)) {
+      printf("ident prop: %.*s = %.*s\n", (int)key[0].size(), key[0].data(), (int)value.size(), value.data());
+      continue;
+    }
+
+    if (!grex_string_span(p.get(), &span)) {
+      printf("string prop: %.*s = %.*s\n", (int)key[0].size(), key[0].data(), (int)span.len, span.ptr);
+      continue;
+    }
+
+    fprintf(stderr, "Invalid property: %.*s\n", (int)key[0].size(), key[0].data());
+    break;
+  }
+}
+
+int main() {
+  grex::parser p;
+  if (p.open_file("test.ini")) {
+    return 1;
+  }
+
+  std::array<std::string_view, 1> name;
+  for (int i = 0; i < 2; i++) {
+    p.match(grex::ws);
+    if (p.match(section, name)) return 1;
+    printf("[%.*s]\n", (int)name[0].size(), name[0].data());
+    parse_properties(p);
+  }
+
+  grex_parser_reset(p.get());
+  int comments = 0;
+  while (p.match(grex::until(marker)) == GREX_OK) {
+    comments++;
+  }
+  printf("comments: %d\n", comments);
+
+  // A branch that fails drops the captures it made, fixed width or not
+  constexpr auto fixed_alt = (grex::cap<0>(grex::ch('a')) >> grex::ch('b')) | (grex::ch('a') >> grex::ch('c'));
+  constexpr auto assign_alt = (grex::cap<0>(grex::identifier) >> grex::ch('=')) | (grex::identifier >> grex::ch(':'));
+  constexpr auto assign_opt = grex::opt(grex::cap<0>(grex::identifier) >> grex::ch('=')) >> grex::identifier;
+  grex::parser a("acX"), b("key:1"), c("key;");
+  std::array<std::string_view, 1> slot;
+  if (!a.match(fixed_alt, slot) && slot[0].empty() && !b.match(assign_alt, slot) && slot[0].empty() &&
+      !c.match(assign_opt, slot) && slot[0].empty()) {
+    printf("failed branches: no captures\n");
+  }
+
+  grex::parser q("2023-10 42 -7 2.5e3 0.125 99999999999 ");
+  std::array<std::string_view, 2> ym;
+  int small, negative;
+  unsigned char byte = 0;
+  float f;
+  double d;
+  if (!q.match(date, ym) && !q.match(grex::ws) && !q.number(small) && !q.match(grex::ws) && !q.number(negative) &&
+      !q.match(grex::ws) && !q.number(f) && !q.match(grex::ws) && !q.number(d) && !q.match(grex::ws)) {
+    printf("numbers: %.*s %.*s %d %d %g %g", (int)ym[0].size(), ym[0].data(), (int)ym[1].size(), ym[1].data(), small, negative, f, d);
+    int clamped = q.number(byte);
+    printf(" %d %u\n", clamped, byte);
+  }
+
+  return 0;
+}